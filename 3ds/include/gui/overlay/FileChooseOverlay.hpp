@@ -29,7 +29,6 @@
 
 #include "Hid.hpp"
 #include "ReplaceableScreen.hpp"
-#include "STDirectory.hpp"
 #include <vector>
 
 class FileChooseOverlay : public ReplaceableScreen
@@ -47,7 +46,6 @@ private:
     void updateEntries();
     std::string currDirString;
     const std::string rootString;
-    STDirectory currDir;
     std::string& string;
     std::vector<std::pair<std::string, bool>> currFiles;
     Hid<HidDirection::HORIZONTAL, HidDirection::VERTICAL> hid;
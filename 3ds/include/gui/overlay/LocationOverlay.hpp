@@ -32,6 +32,7 @@
 #include "pkx/PKX.hpp"
 #include <map>
 #include <memory>
+#include <vector>
 
 class Button;
 
@@ -49,7 +50,7 @@ private:
     pksm::PKX& pkm;
     Hid<HidDirection::VERTICAL, HidDirection::HORIZONTAL> hid;
     const std::map<u16, std::string>& validLocations;
-    std::map<u16, std::string> locations;
+    std::vector<u16> locations;
     std::string searchString    = "";
     std::string oldSearchString = "";
     std::unique_ptr<Button> searchButton;
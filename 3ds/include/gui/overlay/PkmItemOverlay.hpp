@@ -46,8 +46,8 @@ private:
     void searchBar();
     pksm::PKX& pkm;
     Hid<HidDirection::VERTICAL, HidDirection::HORIZONTAL> hid;
-    std::vector<std::pair<int, std::string>> items;
-    std::vector<std::pair<int, std::string>> validItems;
+    std::vector<u16> items;
+    std::vector<u16> validItems;
     std::string searchString    = "";
     std::string oldSearchString = "";
     std::unique_ptr<Button> searchButton;
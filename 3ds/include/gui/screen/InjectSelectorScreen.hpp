@@ -31,7 +31,6 @@
 #include "Sav.hpp"
 #include "Screen.hpp"
 #include "mysterygift.hpp"
-#include "nlohmann/json_fwd.hpp"
 #include <memory>
 #include <string>
 #include <vector>
@@ -53,7 +52,10 @@ private:
     bool toggleFilter(const std::string& lang);
     bool toggleFilter(u8 type);
     Hid<HidDirection::HORIZONTAL, HidDirection::HORIZONTAL> hid;
-    std::vector<nlohmann::json> wondercards;
+    // Matches that pass the filter
+    std::vector<size_t> wondercards;
+    // Card shown for each match, in the configured language when possible
+    std::vector<size_t> displayCards;
     std::vector<std::unique_ptr<Button>> buttons;
     std::vector<std::unique_ptr<ToggleButton>> langFilters;
     std::vector<std::unique_ptr<ToggleButton>> typeFilters;
@@ -31,6 +31,7 @@
 #include "File.hpp"
 #include "utils.hpp"
 #include <3ds.h>
+#include <functional>
 
 class Archive
 {
@@ -56,25 +57,34 @@ public:
         FS_MediaType mediatype, u32 lowid, u32 highid, bool pxi, u32 pathWord4 = 0);
     static Archive extdata(u32 extdata, bool pxi);
 
-    // As these do manual directory traversal, an FS_Path overload is not possible
-    static Result moveDir(
-        Archive& src, const std::u16string& dir, Archive& dst, const std::u16string& dest);
-    static Result copyDir(
-        Archive& src, const std::u16string& dir, Archive& dst, const std::u16string& dest);
+    // Called with the bytes copied so far and the total over all files
+    using TransferProgress = std::function<void(u64 done, u64 total)>;
+
+    // As these do manual directory traversal, an FS_Path overload is not possible. Between
+    // archives, moveDir copies the whole tree before deleting anything and overwrites files that
+    // are already at dest, so it can be repeated after being interrupted. A dir that no longer
+    // exists is taken to have been moved already
+    static Result moveDir(Archive& src, const std::u16string& dir, Archive& dst,
+        const std::u16string& dest, const TransferProgress& progress = nullptr);
+    static Result copyDir(Archive& src, const std::u16string& dir, Archive& dst,
+        const std::u16string& dest, const TransferProgress& progress = nullptr);
     Result deleteDir(const std::u16string& path);
 
     static Result moveFile(Archive& src, FS_Path file, Archive& dst, FS_Path dest);
     static Result copyFile(Archive& src, FS_Path file, Archive& dst, FS_Path dest);
     Result createDir(FS_Path dir, u32 attributes);
     std::unique_ptr<Directory> directory(FS_Path path);
+    std::unique_ptr<DirectoryReader> readDirectory(FS_Path path, std::u16string_view prefix = u"",
+        size_t batchSize = DirectoryReader::DEFAULT_BATCH_SIZE);
     Result createFile(FS_Path file, u32 attributes, u64 size);
     std::unique_ptr<File> file(FS_Path file, u32 flags, u32 attributes = 0);
     Result deleteFile(FS_Path file);
 
-    static Result moveDir(
-        Archive& src, const std::string& dir, Archive& dst, const std::string& dest)
+    static Result moveDir(Archive& src, const std::string& dir, Archive& dst,
+        const std::string& dest, const TransferProgress& progress = nullptr)
     {
-        return moveDir(src, StringUtils::UTF8toUTF16(dir), dst, StringUtils::UTF8toUTF16(dest));
+        return moveDir(
+            src, StringUtils::UTF8toUTF16(dir), dst, StringUtils::UTF8toUTF16(dest), progress);
     }
 
     static Result moveFile(
@@ -89,10 +99,11 @@ public:
         return moveFile(src, StringUtils::UTF8toUTF16(file), dst, StringUtils::UTF8toUTF16(dest));
     }
 
-    static Result copyDir(
-        Archive& src, const std::string& dir, Archive& dst, const std::string& dest)
+    static Result copyDir(Archive& src, const std::string& dir, Archive& dst,
+        const std::string& dest, const TransferProgress& progress = nullptr)
     {
-        return copyDir(src, StringUtils::UTF8toUTF16(dir), dst, StringUtils::UTF8toUTF16(dest));
+        return copyDir(
+            src, StringUtils::UTF8toUTF16(dir), dst, StringUtils::UTF8toUTF16(dest), progress);
     }
 
     static Result copyFile(
@@ -124,6 +135,16 @@ public:
     {
         return directory(StringUtils::UTF8toUTF16(path));
     }
+    std::unique_ptr<DirectoryReader> readDirectory(const std::u16string& path,
+        std::u16string_view prefix = u"", size_t batchSize = DirectoryReader::DEFAULT_BATCH_SIZE)
+    {
+        return readDirectory(fsMakePath(PATH_UTF16, path.c_str()), prefix, batchSize);
+    }
+    std::unique_ptr<DirectoryReader> readDirectory(const std::string& path,
+        std::u16string_view prefix = u"", size_t batchSize = DirectoryReader::DEFAULT_BATCH_SIZE)
+    {
+        return readDirectory(StringUtils::UTF8toUTF16(path), prefix, batchSize);
+    }
 
     Result deleteDir(const std::string& path) { return deleteDir(StringUtils::UTF8toUTF16(path)); }
 
@@ -30,13 +30,54 @@
 #include "utils.hpp"
 #include <3ds.h>
 #include <string>
+#include <string_view>
 #include <vector>
 
+// Reads a directory lazily, batchSize entries per request, so that a caller looking for something
+// can stop early and nothing has to be kept around. Entries whose names don't start with prefix are
+// skipped
+class DirectoryReader
+{
+    friend class Archive;
+    friend class Directory;
+    DirectoryReader(Handle handle, std::u16string_view prefix, size_t batchSize);
+    DirectoryReader(FSPXI_Directory handle, std::u16string_view prefix, size_t batchSize);
+
+public:
+    static constexpr size_t DEFAULT_BATCH_SIZE = 64;
+
+    ~DirectoryReader();
+    DirectoryReader(const DirectoryReader&) = delete;
+    DirectoryReader& operator=(const DirectoryReader&) = delete;
+
+    // Moves to the next entry. Returns false once there are none left or reading failed
+    bool next(void);
+    Result error(void) const;
+    // These describe the current entry and are only valid until the next call to next()
+    std::u16string_view name(void) const;
+    bool folder(void) const;
+    u64 size(void) const;
+    const FS_DirectoryEntry& entry(void) const;
+
+private:
+    bool readBatch(void);
+    void close(void);
+
+    std::vector<FS_DirectoryEntry> batch;
+    std::u16string prefix;
+    size_t current = 0;
+    size_t filled  = 0;
+    Result err     = 0;
+    Handle handle  = 0;
+    FSPXI_Directory pxiHandle;
+    bool pxi;
+    bool open = true;
+};
+
 class Directory
 {
     friend class Archive;
-    Directory(Handle handle);
-    Directory(FSPXI_Directory handle);
+    Directory(DirectoryReader& reader);
 
 public:
     Result error(void) const;
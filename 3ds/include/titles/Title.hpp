@@ -40,7 +40,10 @@ public:
     Title(void) = default;
     ~Title(void);
 
+    // CTR titles that loaded before at the same version come from a cache on the SD card, which
+    // saveCache writes back if anything was added to it
     bool load(u64 id, FS_MediaType mediaType, FS_CardType cardType);
+    static void saveCache(void);
     CardType SPICardType(void) const;
     u32 highId(void) const;
     u32 lowId(void) const;
@@ -77,7 +80,7 @@ private:
     C2D_Image mIcon;
     std::string mName;
     std::string mPrefix;
-    bool mGba;
+    bool mGba = false;
 };
 
 #endif
@@ -145,8 +145,9 @@ namespace TextParse
         explicit TextBuf(size_t maxGlyphs, const std::vector<FontType>& fonts = {nullptr});
         std::shared_ptr<Text> parse(const std::string& str, float maxWidth = 0.0f);
         void addFont(FontType font);
-        // Clears if currentGlyphs is >= maxChars
-        void clear();
+        // Clears if currentGlyphs is >= maxChars. Returns whether it did, which frees every Text
+        // that isn't held elsewhere
+        bool clear();
         // Clears unconditionally
         void clearUnconditional();
 
@@ -173,6 +174,11 @@ namespace TextParse
         // y is always from baseline
         void addText(std::shared_ptr<Text> text, float x, float y, float z, FontSize sizeX,
             FontSize sizeY, TextPosX textPos, PKSM_Color color = COLOR_BLACK);
+        // Same result as addText(text.slice(maxWidth, scrollOffset), ...), but draws straight from
+        // text instead of building a new Text, so it's fine to call every frame
+        void addTextSlice(const Text& text, float maxWidth, float scrollOffset, float x, float y,
+            float z, FontSize sizeX, FontSize sizeY, TextPosX textPos,
+            PKSM_Color color = COLOR_BLACK);
         void optimize();
         void draw() const;
         void clear();
@@ -191,6 +197,8 @@ namespace TextParse
             PKSM_Color color;
             Glyph glyph;
         };
+        void addGlyph(const Glyph& glyph, float lineWidth, float x, float y, float z,
+            FontSize sizeX, FontSize sizeY, TextPosX textPos, PKSM_Color color);
         std::vector<DrawableGlyph> glyphs;
     };
 }
@@ -40,12 +40,36 @@
 #include "pkx/PK7.hpp"
 #include "pkx/PK8.hpp"
 #include "utils/VersionTables.hpp"
+#include <zlib.h>
 
 #define BANK(paths) paths.first
-#define JSON(paths) paths.second
+#define NAMES(paths) paths.second
 #define ARCHIVE (Configuration::getInstance().useExtData() ? Archive::data() : Archive::sd())
 #define OTHERARCHIVE (Configuration::getInstance().useExtData() ? Archive::sd() : Archive::data())
 
+namespace
+{
+    std::string defaultBoxName(int box)
+    {
+        return i18n::localize("STORAGE") + " " + std::to_string(box + 1);
+    }
+
+    // Cuts name down to at most maxSize bytes without splitting a UTF-8 sequence
+    std::string fitName(std::string name, size_t maxSize)
+    {
+        if (name.size() > maxSize)
+        {
+            size_t size = maxSize;
+            while (size > 0 && (name[size] & 0xC0) == 0x80)
+            {
+                size--;
+            }
+            name.resize(size);
+        }
+        return name;
+    }
+}
+
 class BankException : public std::exception
 {
 public:
@@ -60,22 +84,24 @@ private:
     std::string string;
 };
 
-Bank::Bank(const std::string& name, int maxBoxes) : bankName(name)
+Bank::Bank(const std::string& name, int maxBoxes, int firstBox) : bankName(name)
 {
-    load(maxBoxes);
+    load(maxBoxes, firstBox);
 }
 
 Bank::~Bank()
 {
+    cancelLoad();
     if (entries)
     {
         delete[] entries;
     }
 }
 
-void Bank::load(int maxBoxes)
+void Bank::load(int maxBoxes, int firstBox)
 {
     bool create = false;
+    cancelLoad();
     if (entries)
     {
         delete[] entries;
@@ -93,9 +119,12 @@ void Bank::load(int maxBoxes)
         auto in       = ARCHIVE.file(BANK(paths), FS_OPEN_READ);
         if (in)
         {
-            Gui::waitFrame(i18n::localize("BANK_LOAD"));
             u32 size = in->size();
             in->read((char*)&header, sizeof(BankHeader::MAGIC) + sizeof(BankHeader::version));
+            if (header.version != BANK_VERSION)
+            {
+                Gui::waitFrame(i18n::localize("BANK_LOAD"));
+            }
             if (memcmp(header.MAGIC, BANK_MAGIC.data(), 8))
             {
                 Gui::warn(i18n::localize("BANK_CORRUPT"));
@@ -148,14 +177,27 @@ void Bank::load(int maxBoxes)
                     }
                     in->close();
                 }
-                else if (header.version == BANK_VERSION)
+                else if (header.version == 3)
                 {
                     in->read(&header.boxes, sizeof(u32));
-                    entries = new BankEntry[boxes() * 30];
+                    entries        = new BankEntry[boxes() * 30];
+                    header.version = BANK_VERSION;
+                    needSave       = true;
 
                     in->read(entries, size - sizeof(BankHeader));
                     in->close();
                 }
+                else if (header.version == BANK_VERSION)
+                {
+                    in->read(&header.boxes, sizeof(u32));
+                    in->close();
+                    entries = new BankEntry[boxes() * 30];
+                    resetBoxes(false);
+                    firstBox = std::clamp(firstBox, 0, boxes() - 1);
+                    loadTask = Threads::executeTask(
+                        [this, path = BANK(paths), firstBox] { return loadBoxes(path, firstBox); },
+                        Threads::Priority::UI);
+                }
                 else
                 {
                     Gui::warn(
@@ -176,37 +218,23 @@ void Bank::load(int maxBoxes)
             create   = true;
         }
 
-        auto json = ARCHIVE.file(JSON(paths), FS_OPEN_READ);
-        if (json)
+        if (!loadTask.valid())
         {
-            size_t jsonSize = in->size();
-            char* jsonData  = new char[jsonSize + 1];
-            json->read(jsonData, jsonSize);
-            json->close();
-            jsonData[jsonSize] = '\0';
-            boxNames =
-                std::make_unique<nlohmann::json>(nlohmann::json::parse(jsonData, nullptr, false));
-            delete[] jsonData;
-            if (boxNames->is_discarded())
-            {
-                createJSON();
-                needSave = true;
-            }
-            else
+            resetBoxes(true);
+        }
+
+        if (!readNames(NAMES(paths)))
+        {
+            if (!importJsonNames(legacyNamesPath()))
             {
-                for (int i = boxNames->size(); i < boxes(); i++)
-                {
-                    (*boxNames)[i] = i18n::localize("STORAGE") + " " + std::to_string(i + 1);
-                    if (!needSave)
-                    {
-                        needSave = true;
-                    }
-                }
+                createNames();
             }
+            needSave = true;
         }
-        else
+        for (int i = boxNames.size(); i < boxes(); i++)
         {
-            createJSON();
+            boxNames.emplace_back(defaultBoxName(i));
+            dirtyNames.push_back(true);
             needSave = true;
         }
 
@@ -217,6 +245,8 @@ void Bank::load(int maxBoxes)
 
         if (needSave)
         {
+            waitForLoad();
+            update();
             if (create)
             {
                 saveWithoutBackup();
@@ -226,40 +256,43 @@ void Bank::load(int maxBoxes)
                 save();
             }
         }
-        else
-        {
-            prevHash = pksm::crypto::sha256((u8*)entries, sizeof(BankEntry) * boxes() * 30);
-            std::string nameData = boxNames->dump(2);
-            prevNameHash         = pksm::crypto::sha256((u8*)nameData.data(), nameData.size());
-        }
     }
 }
 
 bool Bank::saveWithoutBackup() const
 {
+    if (!confirmOverwrite())
+    {
+        return false;
+    }
     auto paths = this->paths();
     Gui::waitFrame(i18n::localize("BANK_SAVE"));
+    std::vector<BoxIndex> index(boxes());
+    std::vector<u8> blocks;
+    for (int box = 0; box < boxes(); box++)
+    {
+        index[box] = packBox(box, blocks);
+    }
     ARCHIVE.deleteFile(BANK(paths));
-    ARCHIVE.createFile(BANK(paths), 0, sizeof(BankHeader) + sizeof(BankEntry) * boxes() * 30);
+    ARCHIVE.createFile(
+        BANK(paths), 0, sizeof(BankHeader) + sizeof(BoxIndex) * index.size() + blocks.size());
     auto out = ARCHIVE.file(BANK(paths), FS_OPEN_WRITE);
     if (out)
     {
         out->write(&header, sizeof(BankHeader));
-        out->write(entries, sizeof(BankEntry) * boxes() * 30);
+        out->write(index.data(), sizeof(BoxIndex) * index.size());
+        out->write(blocks.data(), blocks.size());
         out->close();
-
-        std::string jsonData = boxNames->dump(2);
-        ARCHIVE.deleteFile(JSON(paths));
-        ARCHIVE.createFile(JSON(paths), 0, jsonData.size() + 1);
-        out = ARCHIVE.file(JSON(paths), FS_OPEN_WRITE, jsonData.size() + 1);
-        if (out)
+        for (int box = 0; box < boxes(); box++)
         {
-            out->write(jsonData.data(), jsonData.size() + 1);
-            prevHash     = pksm::crypto::sha256((u8*)entries, sizeof(BankEntry) * boxes() * 30);
-            prevNameHash = pksm::crypto::sha256((u8*)jsonData.data(), jsonData.size());
-            out->close();
+            if (touchedBoxes[box])
+            {
+                boxHashes[box]    = hashBox(box);
+                touchedBoxes[box] = false;
+            }
         }
-        else
+
+        if (!saveNames())
         {
             Gui::error(i18n::localize("BANK_NAME_ERROR"), ARCHIVE.result());
         }
@@ -275,6 +308,13 @@ bool Bank::saveWithoutBackup() const
 
 bool Bank::save() const
 {
+    waitForLoad();
+    finishLoad();
+    if (loadFailed)
+    {
+        // What's on disk is what couldn't be read, so it mustn't replace the last good backup
+        return confirmOverwrite() && saveWithoutBackup();
+    }
     if (Configuration::getInstance().autoBackup())
     {
         if (!backup() && !Gui::showChoiceMessage(i18n::localize("BACKUP_FAIL_SAVE_1") + '\n' +
@@ -286,11 +326,34 @@ bool Bank::save() const
     return saveWithoutBackup();
 }
 
+void Bank::pkm(const Bank& from, int fromBox, int fromSlot, int box, int slot)
+{
+    from.waitForBox(fromBox);
+    waitForBox(box);
+    entries[box * 30 + slot] = from.entries[fromBox * 30 + fromSlot];
+    touchedBoxes[box]        = true;
+    needsCheck               = true;
+}
+
+void Bank::swapPkm(
+    Bank& first, int firstBox, int firstSlot, Bank& second, int secondBox, int secondSlot)
+{
+    first.waitForBox(firstBox);
+    second.waitForBox(secondBox);
+    std::swap(
+        first.entries[firstBox * 30 + firstSlot], second.entries[secondBox * 30 + secondSlot]);
+    first.touchedBoxes[firstBox]   = true;
+    second.touchedBoxes[secondBox] = true;
+    first.needsCheck               = true;
+    second.needsCheck              = true;
+}
+
 void Bank::resize(int boxes)
 {
     auto paths = this->paths();
     if (this->boxes() != boxes)
     {
+        waitForLoad();
         Gui::showResizeStorage();
         BankEntry* newEntries = new BankEntry[boxes * 30];
         std::copy(entries, entries + std::min(boxes, this->boxes()) * 30, newEntries);
@@ -303,18 +366,118 @@ void Bank::resize(int boxes)
         entries = newEntries;
 
         header.boxes = boxes;
+        resetBoxes(true);
 
-        for (int i = boxNames->size(); i < boxes; i++)
+        for (int i = boxNames.size(); i < boxes; i++)
         {
-            (*boxNames)[i] = i18n::localize("STORAGE") + " " + std::to_string(i + 1);
+            boxNames.emplace_back(defaultBoxName(i));
+            dirtyNames.push_back(true);
         }
 
         save();
     }
 }
 
+Bank::BoxIndex Bank::packBox(int box, std::vector<u8>& out) const
+{
+    std::vector<u8> raw;
+    raw.reserve(MAX_BOX_BLOCK);
+    auto put16 = [&raw](u16 value) {
+        raw.push_back(value & 0xFF);
+        raw.push_back(value >> 8);
+    };
+
+    u16 emptySlots = 0;
+    for (int slot = 0; slot < 30; slot++)
+    {
+        const u8* entry = (const u8*)(entries + box * 30 + slot);
+        u16 length      = sizeof(BankEntry);
+        while (length > 0 && entry[length - 1] == 0xFF)
+        {
+            length--;
+        }
+        if (length == 0)
+        {
+            emptySlots++;
+            continue;
+        }
+        if (emptySlots > 0)
+        {
+            put16(EMPTY_RUN | emptySlots);
+            emptySlots = 0;
+        }
+        put16(length);
+        raw.insert(raw.end(), entry, entry + length);
+    }
+    if (emptySlots > 0)
+    {
+        put16(EMPTY_RUN | emptySlots);
+    }
+
+    BoxIndex ret{(u32)out.size(), 0};
+    uLongf compressedSize = compressBound(raw.size());
+    out.resize(ret.offset + compressedSize);
+    if (compress2(out.data() + ret.offset, &compressedSize, raw.data(), raw.size(),
+            Z_BEST_SPEED) == Z_OK &&
+        compressedSize < raw.size())
+    {
+        ret.size = compressedSize;
+        out.resize(ret.offset + compressedSize);
+    }
+    else
+    {
+        ret.size = raw.size() | RAW_BOX;
+        out.resize(ret.offset);
+        out.insert(out.end(), raw.begin(), raw.end());
+    }
+    return ret;
+}
+
+bool Bank::unpackBox(int box, const u8* block, const BoxIndex& index, std::vector<u8>& scratch)
+{
+    const u8* raw = block;
+    size_t size   = index.size & ~RAW_BOX;
+    if (!(index.size & RAW_BOX))
+    {
+        scratch.resize(MAX_BOX_BLOCK);
+        uLongf rawSize = scratch.size();
+        if (uncompress(scratch.data(), &rawSize, block, size) != Z_OK)
+        {
+            return false;
+        }
+        raw  = scratch.data();
+        size = rawSize;
+    }
+
+    BankEntry* boxEntries = entries + box * 30;
+    std::fill_n((u8*)boxEntries, sizeof(BankEntry) * 30, 0xFF);
+    int slot   = 0;
+    size_t pos = 0;
+    while (pos + sizeof(u16) <= size)
+    {
+        u16 value = raw[pos] | (raw[pos + 1] << 8);
+        pos += sizeof(u16);
+        if (value & EMPTY_RUN)
+        {
+            slot += value & ~EMPTY_RUN;
+        }
+        else
+        {
+            if (slot >= 30 || value > sizeof(BankEntry) || value > size - pos)
+            {
+                return false;
+            }
+            std::copy(raw + pos, raw + pos + value, (u8*)(boxEntries + slot));
+            pos += value;
+            slot++;
+        }
+    }
+    return pos == size && slot == 30;
+}
+
 std::unique_ptr<pksm::PKX> Bank::pkm(int box, int slot) const
 {
+    waitForBox(box);
     int index = box * 30 + slot;
     auto ret  = pksm::PKX::getPKM(entries[index].gen, entries[index].data, false);
     if (ret)
@@ -331,7 +494,9 @@ std::unique_ptr<pksm::PKX> Bank::pkm(int box, int slot) const
 
 void Bank::pkm(const pksm::PKX& pkm, int box, int slot)
 {
-    int index = box * 30 + slot;
+    waitForBox(box);
+    int index         = box * 30 + slot;
+    touchedBoxes[box] = true;
     BankEntry newEntry;
     if (pkm.species() == pksm::Species::None)
     {
@@ -348,18 +513,42 @@ void Bank::pkm(const pksm::PKX& pkm, int box, int slot)
         std::fill_n(
             newEntry.data + pkm.getLength(), sizeof(BankEntry::data) - pkm.getLength(), 0xFF);
     }
+    std::fill_n(newEntry.padding, sizeof(BankEntry::padding), 0xFF);
     entries[index] = newEntry;
     needsCheck     = true;
 }
 
+void Bank::forEachPkm(int firstBox, int lastBox,
+    const std::function<void(const pksm::PKX&, int box, int slot)>& func) const
+{
+    for (int box = firstBox; box <= lastBox; box++)
+    {
+        waitForBox(box);
+        for (int slot = 0; slot < 30; slot++)
+        {
+            BankEntry& entry = entries[box * 30 + slot];
+            if (entry.gen == pksm::Generation::UNUSED)
+            {
+                continue;
+            }
+            // Entries are stored decrypted, so accessing them directly leaves them untouched
+            auto pkm = pksm::PKX::getPKM(entry.gen, entry.data, false, true);
+            if (pkm && pkm->species() != pksm::Species::None)
+            {
+                func(*pkm, box, slot);
+            }
+        }
+    }
+}
+
 bool Bank::backup() const
 {
     Gui::waitFrame(i18n::localize("BANK_BACKUP"));
     auto paths = this->paths();
     Archive::copyFile(Archive::sd(), "/3ds/PKSM/backups/" + bankName + ".bnk.bak", Archive::sd(),
         "/3ds/PKSM/backups/" + bankName + ".bnk.bak.old");
-    Archive::copyFile(Archive::sd(), "/3ds/PKSM/backups/" + bankName + ".json.bak", Archive::sd(),
-        "/3ds/PKSM/backups/" + bankName + ".json.bak.old");
+    Archive::copyFile(Archive::sd(), "/3ds/PKSM/backups/" + bankName + ".names.bak", Archive::sd(),
+        "/3ds/PKSM/backups/" + bankName + ".names.bak.old");
     Result res = Archive::copyFile(
         ARCHIVE, BANK(paths), Archive::sd(), "/3ds/PKSM/backups/" + bankName + ".bnk.bak");
     if (R_FAILED(res))
@@ -367,28 +556,158 @@ bool Bank::backup() const
         return false;
     }
     Archive::copyFile(
-        ARCHIVE, JSON(paths), Archive::sd(), "/3ds/PKSM/backups/" + bankName + ".json.bak");
+        ARCHIVE, NAMES(paths), Archive::sd(), "/3ds/PKSM/backups/" + bankName + ".names.bak");
+    if (legacyNames)
+    {
+        Archive::copyFile(ARCHIVE, legacyNamesPath(), Archive::sd(),
+            "/3ds/PKSM/backups/" + bankName + ".json.bak");
+    }
     return true;
 }
 
 std::string Bank::boxName(int box) const
 {
-    return (*boxNames)[box].get<std::string>();
+    return boxNames[box];
 }
 
 void Bank::boxName(std::string name, int box)
 {
-    (*boxNames)[box] = name;
-    needsCheck       = true;
+    name = fitName(std::move(name), sizeof(NameRecord::name));
+    if (boxNames[box] != name)
+    {
+        boxNames[box]   = std::move(name);
+        dirtyNames[box] = true;
+        needsCheck      = true;
+    }
 }
 
-void Bank::createJSON()
+void Bank::createNames()
 {
-    boxNames = std::make_unique<nlohmann::json>(nlohmann::json::array());
+    boxNames.clear();
     for (int i = 0; i < boxes(); i++)
     {
-        (*boxNames)[i] = i18n::localize("STORAGE") + " " + std::to_string(i + 1);
+        boxNames.emplace_back(defaultBoxName(i));
+    }
+    dirtyNames.assign(boxNames.size(), true);
+    storedNames = 0;
+}
+
+bool Bank::readNames(const std::string& path)
+{
+    auto in = ARCHIVE.file(path, FS_OPEN_READ);
+    if (!in)
+    {
+        return false;
+    }
+
+    NamesHeader namesHeader;
+    in->read(&namesHeader, sizeof(NamesHeader));
+    if (memcmp(namesHeader.MAGIC, NAMES_MAGIC.data(), NAMES_MAGIC.size()) ||
+        namesHeader.version != NAMES_VERSION ||
+        in->size() < sizeof(NamesHeader) + sizeof(NameRecord) * namesHeader.boxes)
+    {
+        in->close();
+        return false;
+    }
+    std::vector<NameRecord> records(namesHeader.boxes);
+    in->read(records.data(), sizeof(NameRecord) * records.size());
+    in->close();
+    if (R_FAILED(in->result()))
+    {
+        return false;
+    }
+
+    boxNames.clear();
+    for (const auto& record : records)
+    {
+        boxNames.emplace_back(record.name, std::min(size_t(record.length), sizeof(record.name)));
+    }
+    dirtyNames.assign(boxNames.size(), false);
+    storedNames = boxNames.size();
+    return true;
+}
+
+bool Bank::importJsonNames(const std::string& path)
+{
+    auto in = ARCHIVE.file(path, FS_OPEN_READ);
+    if (!in)
+    {
+        return false;
+    }
+    std::string data(in->size(), '\0');
+    in->read(data.data(), data.size());
+    in->close();
+
+    // The file ends with a null terminator, so parse up to that
+    nlohmann::json json = nlohmann::json::parse(data.c_str(), nullptr, false);
+    if (!json.is_array())
+    {
+        return false;
     }
+
+    boxNames.clear();
+    for (const auto& name : json)
+    {
+        boxNames.emplace_back(
+            name.is_string() ? fitName(name.get<std::string>(), sizeof(NameRecord::name)) : "");
+    }
+    dirtyNames.assign(boxNames.size(), true);
+    storedNames = 0;
+    legacyNames = true;
+    return true;
+}
+
+bool Bank::saveNames() const
+{
+    auto paths = this->paths();
+    std::unique_ptr<File> out;
+    if (storedNames == boxNames.size())
+    {
+        out = ARCHIVE.file(NAMES(paths), FS_OPEN_WRITE);
+    }
+    if (!out)
+    {
+        ARCHIVE.deleteFile(NAMES(paths));
+        ARCHIVE.createFile(
+            NAMES(paths), 0, sizeof(NamesHeader) + sizeof(NameRecord) * boxNames.size());
+        out = ARCHIVE.file(NAMES(paths), FS_OPEN_WRITE);
+        if (!out)
+        {
+            return false;
+        }
+        NamesHeader namesHeader;
+        std::copy(NAMES_MAGIC.begin(), NAMES_MAGIC.end(), namesHeader.MAGIC);
+        namesHeader.version = NAMES_VERSION;
+        namesHeader.boxes   = boxNames.size();
+        out->write(&namesHeader, sizeof(NamesHeader));
+        dirtyNames.assign(boxNames.size(), true);
+    }
+
+    for (size_t i = 0; i < boxNames.size(); i++)
+    {
+        if (dirtyNames[i])
+        {
+            NameRecord record{};
+            record.length = boxNames[i].size();
+            std::copy(boxNames[i].begin(), boxNames[i].end(), record.name);
+            out->seek(sizeof(NamesHeader) + sizeof(NameRecord) * i, SEEK_SET);
+            out->write(&record, sizeof(NameRecord));
+        }
+    }
+    out->close();
+    if (R_FAILED(out->result()))
+    {
+        return false;
+    }
+
+    dirtyNames.assign(boxNames.size(), false);
+    storedNames = boxNames.size();
+    if (legacyNames)
+    {
+        ARCHIVE.deleteFile(legacyNamesPath());
+        legacyNames = false;
+    }
+    return true;
 }
 
 void Bank::createBank(int maxBoxes)
@@ -410,14 +729,18 @@ bool Bank::hasChanged() const
     {
         return false;
     }
-    auto hash = pksm::crypto::sha256((u8*)entries, sizeof(BankEntry) * boxes() * 30);
-    if (hash != prevHash)
+    for (int box = 0; box < boxes(); box++)
     {
-        return true;
+        if (touchedBoxes[box])
+        {
+            if (hashBox(box) != boxHashes[box])
+            {
+                return true;
+            }
+            touchedBoxes[box] = false;
+        }
     }
-    std::string jsonData = boxNames->dump(2);
-    hash                 = pksm::crypto::sha256((u8*)jsonData.data(), jsonData.size());
-    if (hash != prevNameHash)
+    if (std::find(dirtyNames.begin(), dirtyNames.end(), true) != dirtyNames.end())
     {
         return true;
     }
@@ -425,6 +748,200 @@ bool Bank::hasChanged() const
     return false;
 }
 
+bool Bank::boxLoaded(int box) const
+{
+    return !loadedBoxes || loadedBoxes[box].load(std::memory_order_acquire);
+}
+
+bool Bank::loading() const
+{
+    return loadTask.valid() && !loadTask.ready();
+}
+
+void Bank::update()
+{
+    finishLoad();
+    if (loadFailed && !failureReported)
+    {
+        failureReported = true;
+        Gui::warn(fmt::format(i18n::localize("BANK_PARTIAL_LOAD"), bankName));
+    }
+}
+
+void Bank::finishLoad() const
+{
+    if (loadTask.valid() && loadTask.ready())
+    {
+        if (!(loadTask.wait() && loadTask.get()))
+        {
+            loadFailed      = true;
+            failureReported = false;
+        }
+        loadTask = {};
+    }
+}
+
+bool Bank::confirmOverwrite() const
+{
+    waitForLoad();
+    finishLoad();
+    if (loadFailed)
+    {
+        failureReported = true;
+        if (!Gui::showChoiceMessage(
+                fmt::format(i18n::localize("BANK_OVERWRITE_PARTIAL"), bankName)))
+        {
+            return false;
+        }
+        loadFailed = false;
+    }
+    return true;
+}
+
+bool Bank::loadBoxes(const std::string& path, int firstBox)
+{
+    std::vector<u8> scratch;
+    if (readBoxes(path, firstBox, scratch))
+    {
+        return true;
+    }
+    if (!cancelLoading)
+    {
+        // Whatever couldn't be read is shown empty. Nothing is written back until the user agrees
+        for (int box = 0; box < boxes(); box++)
+        {
+            if (!loadedBoxes[box].load(std::memory_order_relaxed))
+            {
+                std::fill_n((u8*)(entries + box * 30), sizeof(BankEntry) * 30, 0xFF);
+                publishBox(box);
+            }
+        }
+    }
+    return false;
+}
+
+bool Bank::readBoxes(const std::string& path, int firstBox, std::vector<u8>& scratch)
+{
+    auto in = ARCHIVE.file(path, FS_OPEN_READ);
+    if (!in)
+    {
+        return false;
+    }
+    u32 size = in->size();
+    std::vector<BoxIndex> index(boxes());
+    u32 dataStart = sizeof(BankHeader) + sizeof(BoxIndex) * index.size();
+    if (size < dataStart)
+    {
+        return false;
+    }
+    in->seek(sizeof(BankHeader), SEEK_SET);
+    in->read(index.data(), sizeof(BoxIndex) * index.size());
+    for (const auto& box : index)
+    {
+        if (box.offset > size - dataStart ||
+            (box.size & ~RAW_BOX) > size - dataStart - box.offset)
+        {
+            return false;
+        }
+    }
+
+    // The first box is read on its own so that it can be shown before the rest has been read
+    std::vector<u8> blocks(index[firstBox].size & ~RAW_BOX);
+    in->seek(dataStart + index[firstBox].offset, SEEK_SET);
+    in->read(blocks.data(), blocks.size());
+    if (R_FAILED(in->result()) ||
+        !unpackBox(firstBox, blocks.data(), index[firstBox], scratch))
+    {
+        return false;
+    }
+    publishBox(firstBox);
+
+    blocks.resize(size - dataStart);
+    in->seek(dataStart, SEEK_SET);
+    in->read(blocks.data(), blocks.size());
+    if (R_FAILED(in->result()))
+    {
+        return false;
+    }
+    in->close();
+
+    for (int distance = 1; distance < boxes(); distance++)
+    {
+        for (int box : {firstBox + distance, firstBox - distance})
+        {
+            if (box < 0 || box >= boxes())
+            {
+                continue;
+            }
+            if (cancelLoading ||
+                !unpackBox(box, blocks.data() + index[box].offset, index[box], scratch))
+            {
+                return false;
+            }
+            publishBox(box);
+        }
+    }
+    return true;
+}
+
+void Bank::publishBox(int box)
+{
+    boxHashes[box] = hashBox(box);
+    loadedBoxes[box].store(true, std::memory_order_release);
+}
+
+void Bank::waitForBox(int box) const
+{
+    if (loadTask.valid() && !loadedBoxes[box].load(std::memory_order_acquire))
+    {
+        loadTask.wait();
+    }
+}
+
+void Bank::waitForLoad() const
+{
+    if (loadTask.valid())
+    {
+        loadTask.wait();
+    }
+}
+
+void Bank::cancelLoad()
+{
+    loadFailed      = false;
+    failureReported = false;
+    if (loadTask.valid())
+    {
+        cancelLoading = true;
+        if (!loadTask.cancel())
+        {
+            loadTask.wait();
+        }
+        loadTask      = {};
+        cancelLoading = false;
+    }
+}
+
+void Bank::resetBoxes(bool loaded)
+{
+    loadedBoxes = std::make_unique<std::atomic<bool>[]>(boxes());
+    boxHashes.resize(boxes());
+    touchedBoxes.assign(boxes(), false);
+    for (int box = 0; box < boxes(); box++)
+    {
+        loadedBoxes[box] = loaded;
+        if (loaded)
+        {
+            boxHashes[box] = hashBox(box);
+        }
+    }
+}
+
+std::array<u8, 32> Bank::hashBox(int box) const
+{
+    return pksm::crypto::sha256((u8*)(entries + box * 30), sizeof(BankEntry) * 30);
+}
+
 void Bank::convertFromBankBin()
 {
     Gui::waitFrame(i18n::localize("BANK_CONVERT"));
@@ -447,7 +964,8 @@ void Bank::convertFromBankBin()
         extern nlohmann::json g_banks;
         g_banks["pksm_1"] = header.boxes;
         std::fill_n((u8*)entries, sizeof(BankEntry) * boxes() * 30, 0xFF);
-        boxNames = std::make_unique<nlohmann::json>(nlohmann::json::array());
+        resetBoxes(true);
+        createNames();
 
         for (int box = 0; box < std::min((int)(oldSize / (pksm::PK6::BOX_LENGTH * 30)), boxes());
              box++)
@@ -502,11 +1020,6 @@ void Bank::convertFromBankBin()
         inStream->close();
         outStream->close();
 
-        for (int i = 0; i < boxes(); i++)
-        {
-            (*boxNames)[i] = i18n::localize("STORAGE") + " " + std::to_string(i + 1);
-        }
-
         if (save())
         {
             Archive::sd().deleteFile(u"/3ds/PKSM/bank/bank.bin");
@@ -528,8 +1041,14 @@ int Bank::boxes() const
     return header.boxes;
 }
 
+size_t Bank::memoryUsage() const
+{
+    return sizeof(BankEntry) * boxes() * 30 + sizeof(NameRecord) * boxNames.size();
+}
+
 bool Bank::setName(const std::string& name)
 {
+    waitForLoad();
     auto oldPaths       = paths();
     std::string oldName = bankName;
     bankName            = name;
@@ -539,7 +1058,7 @@ bool Bank::setName(const std::string& name)
         bankName = oldName;
         return false;
     }
-    if (R_FAILED(Archive::moveFile(ARCHIVE, JSON(oldPaths), ARCHIVE, JSON(newPaths))))
+    if (R_FAILED(Archive::moveFile(ARCHIVE, NAMES(oldPaths), ARCHIVE, NAMES(newPaths))))
     {
         bankName = oldName;
         if (R_FAILED(Archive::moveFile(ARCHIVE, BANK(newPaths), ARCHIVE, BANK(oldPaths))))
@@ -557,10 +1076,22 @@ std::pair<std::string, std::string> Bank::paths() const
 {
     if (Configuration::getInstance().useExtData())
     {
-        return {"/banks/" + bankName + ".bnk", "/banks/" + bankName + ".json"};
+        return {"/banks/" + bankName + ".bnk", "/banks/" + bankName + ".names"};
+    }
+    else
+    {
+        return {"/3ds/PKSM/banks/" + bankName + ".bnk", "/3ds/PKSM/banks/" + bankName + ".names"};
+    }
+}
+
+std::string Bank::legacyNamesPath() const
+{
+    if (Configuration::getInstance().useExtData())
+    {
+        return "/banks/" + bankName + ".json";
     }
     else
     {
-        return {"/3ds/PKSM/banks/" + bankName + ".bnk", "/3ds/PKSM/banks/" + bankName + ".json"};
+        return "/3ds/PKSM/banks/" + bankName + ".json";
     }
 }
@@ -33,6 +33,7 @@
 #include "appIcon.hpp"
 #include "banks.hpp"
 #include "fetch.hpp"
+#include "fetchcache.hpp"
 #include "format.h"
 #include "gui.hpp"
 #include "i18n_ext.hpp"
@@ -46,11 +47,14 @@
 #include <3ds.h>
 #include <atomic>
 #include <malloc.h>
+#include <optional>
 #include <stdio.h>
 #include <sys/stat.h>
 
 namespace
 {
+    constexpr size_t HTTP_CACHE_SIZE = 4 * 1024 * 1024;
+
     u32 old_time_limit;
     Handle hbldrHandle;
     std::atomic_flag moveIcon     = ATOMIC_FLAG_INIT;
@@ -112,36 +116,31 @@ namespace
 
     Result downloadAdditionalAssets(void)
     {
-        Result res = 0;
-
-        for (auto item : assets)
+        std::vector<Fetch::DownloadRequest> requests;
+        for (auto& item : assets)
         {
-            bool downloadAsset = true;
             if (io::exists(item.path))
             {
                 if (matchSha256HashFromFile(item.path, item.hash))
                 {
-                    downloadAsset = false;
-                }
-                else
-                {
-                    std::remove(item.path.c_str());
+                    continue;
                 }
+                std::remove(item.path.c_str());
             }
-            if (downloadAsset)
-            {
+            requests.push_back({item.url, item.path});
+        }
+
+        if (requests.empty())
+        {
+            return 0;
+        }
 #if !CITRA_DEBUG
-                u32 status;
-                ACU_GetWifiStatus(&status);
-                if (status == 0)
-                    return -1;
+        u32 status;
+        ACU_GetWifiStatus(&status);
+        if (status == 0)
+            return -1;
 #endif
-                Result res1 = Fetch::download(item.url, item.path);
-                if (R_FAILED(res1))
-                    return res1;
-            }
-        }
-        return res;
+        return Fetch::downloadMany(requests);
     }
 
     Result consoleDisplayError(const std::string& message, Result res)
@@ -187,6 +186,274 @@ namespace
         Archive::copyDir(Archive::sd(), u"/3ds/PKSM/banks", Archive::sd(), u"/3ds/PKSM/banksBkp");
     }
 
+    using Sha256Hash = decltype(pksm::crypto::sha256(nullptr, 0));
+
+    // Receives an update as it downloads. A CIA is written straight into the install handle; only
+    // a 3DSX goes through a file, which is then moved over the running one
+    struct UpdateSink
+    {
+        static constexpr size_t WRITE_SIZE = 0x10000;
+
+        Fetch* fetch      = nullptr;
+        Handle ciaInstall = 0;
+        FILE* file        = nullptr;
+        pksm::crypto::SHA256 hash;
+        std::vector<u8> pending;
+        std::string fileName;
+        // Bytes received so far over all attempts, and how many of those the current attempt
+        // will send again because the server ignored the Range header
+        u64 received       = 0;
+        u64 skip           = 0;
+        u64 written        = 0;
+        Result writeResult = 0;
+        bool checkedStatus = false;
+
+        bool flush()
+        {
+            if (pending.empty())
+            {
+                return true;
+            }
+            if (file)
+            {
+                if (fwrite(pending.data(), 1, pending.size(), file) != pending.size())
+                {
+                    writeResult = -errno;
+                    return false;
+                }
+            }
+            else
+            {
+                u32 bytesWritten;
+                if (R_FAILED(writeResult = FSFILE_Write(ciaInstall, &bytesWritten, written,
+                                 pending.data(), pending.size(), FS_WRITE_FLUSH)))
+                {
+                    return false;
+                }
+                if (bytesWritten != pending.size())
+                {
+                    writeResult = -1;
+                    return false;
+                }
+            }
+            written += pending.size();
+            pending.clear();
+            return true;
+        }
+    };
+
+    size_t updateWriteCallback(char* data, size_t size, size_t nitems, void* userdata)
+    {
+        UpdateSink* sink = (UpdateSink*)userdata;
+        size_t length    = size * nitems;
+        if (!sink->checkedStatus)
+        {
+            sink->checkedStatus = true;
+            long status;
+            sink->fetch->getinfo(CURLINFO_RESPONSE_CODE, &status);
+            if (status >= 400)
+            {
+                return 0;
+            }
+            // The server ignored the Range header and is sending everything again
+            sink->skip = status == 206 ? 0 : sink->received;
+        }
+
+        size_t skipped = std::min<u64>(sink->skip, length);
+        sink->skip -= skipped;
+        data += skipped;
+        size_t usable = length - skipped;
+
+        sink->hash.update((u8*)data, usable);
+        sink->received += usable;
+        while (usable > 0)
+        {
+            size_t taken = std::min(usable, UpdateSink::WRITE_SIZE - sink->pending.size());
+            sink->pending.insert(sink->pending.end(), data, data + taken);
+            data += taken;
+            usable -= taken;
+            if (sink->pending.size() == UpdateSink::WRITE_SIZE && !sink->flush())
+            {
+                return 0;
+            }
+        }
+        return length;
+    }
+
+    // GitHub lists a "sha256:<hex>" digest for each release asset
+    std::optional<Sha256Hash> releaseDigest(const nlohmann::json& release, std::string_view name)
+    {
+        if (!release.contains("assets") || !release["assets"].is_array())
+        {
+            return std::nullopt;
+        }
+        for (const auto& asset : release["assets"])
+        {
+            if (!asset.contains("name") || asset["name"] != name || !asset.contains("digest") ||
+                !asset["digest"].is_string())
+            {
+                continue;
+            }
+            const std::string digest = asset["digest"].get<std::string>();
+            Sha256Hash ret;
+            if (digest.size() != 7 + ret.size() * 2 || digest.substr(0, 7) != "sha256:")
+            {
+                return std::nullopt;
+            }
+            for (size_t i = 0; i < ret.size(); i++)
+            {
+                char* end;
+                std::string byte = digest.substr(7 + i * 2, 2);
+                ret[i]           = strtoul(byte.c_str(), &end, 16);
+                if (*end != '\0')
+                {
+                    return std::nullopt;
+                }
+            }
+            return ret;
+        }
+        return std::nullopt;
+    }
+
+    // Downloads the update into sink, picking up where it left off if the connection drops
+    Result downloadUpdate(const std::string& url, const std::string& postData, UpdateSink& sink)
+    {
+        constexpr int MAX_ATTEMPTS = 5;
+        Result res                 = 0;
+        for (int attempt = 0; attempt < MAX_ATTEMPTS; attempt++)
+        {
+            auto fetch = Fetch::init(url, true, nullptr, nullptr, postData);
+            if (!fetch)
+            {
+                return -1;
+            }
+            sink.fetch         = fetch.get();
+            sink.checkedStatus = false;
+            fetch->setopt(CURLOPT_WRITEFUNCTION, updateWriteCallback);
+            fetch->setopt(CURLOPT_WRITEDATA, &sink);
+            if (sink.received > 0)
+            {
+                fetch->setopt(CURLOPT_RESUME_FROM_LARGE, (curl_off_t)sink.received);
+            }
+            fetch->setopt(CURLOPT_NOPROGRESS, 0L);
+            fetch->setopt(CURLOPT_XFERINFOFUNCTION,
+                (curl_xferinfo_callback)[](void* clientp, curl_off_t dltotal, curl_off_t dlnow,
+                    curl_off_t, curl_off_t) {
+                    UpdateSink* sink = (UpdateSink*)clientp;
+                    Gui::showDownloadProgress(sink->fileName, sink->received / 1024,
+                        dltotal > 0 ? (sink->received - dlnow + dltotal) / 1024 : 0);
+                    return 0;
+                });
+            fetch->setopt(CURLOPT_XFERINFODATA, &sink);
+
+            auto result = Fetch::perform(fetch);
+            if (result.index() == 0)
+            {
+                return -std::get<0>(result);
+            }
+            CURLcode code = std::get<1>(result);
+            long status   = 0;
+            fetch->getinfo(CURLINFO_RESPONSE_CODE, &status);
+            if (R_FAILED(sink.writeResult))
+            {
+                return sink.writeResult;
+            }
+            if (status >= 400)
+            {
+                return -(CURLE_HTTP_RETURNED_ERROR + 100);
+            }
+            if (code == CURLE_OK)
+            {
+                return sink.flush() ? 0 : sink.writeResult;
+            }
+            res = -(code + 100);
+        }
+        return res;
+    }
+
+    bool installUpdate(const std::string& url, const std::string& postData,
+        const std::string& execPath, const std::optional<Sha256Hash>& expectedHash)
+    {
+        UpdateSink sink;
+        sink.pending.reserve(UpdateSink::WRITE_SIZE);
+        Result res;
+        std::string path;
+        if (execPath.empty())
+        {
+            sink.fileName = "PKSM.cia";
+            if (R_FAILED(res = AM_StartCiaInstall(MEDIATYPE_SD, &sink.ciaInstall)))
+            {
+                Gui::error(i18n::localize("CIA_INSTALL_START_FAIL"), res);
+                return false;
+            }
+        }
+        else
+        {
+            sink.fileName = "PKSM.3dsx";
+            path          = execPath + ".new";
+            if (!(sink.file = fopen(path.c_str(), "wb")))
+            {
+                Gui::error(i18n::localize("UPDATE_FOUND_BUT_FAILED_DOWNLOAD"), -errno);
+                return false;
+            }
+        }
+
+        res = downloadUpdate(url, postData, sink);
+        if (sink.file)
+        {
+            fclose(sink.file);
+        }
+        bool hashMatches = !expectedHash || sink.hash.finish() == *expectedHash;
+        if (R_FAILED(res) || !hashMatches)
+        {
+            if (execPath.empty())
+            {
+                AM_CancelCIAInstall(sink.ciaInstall);
+            }
+            else
+            {
+                Archive::sd().deleteFile(path);
+            }
+            if (R_FAILED(sink.writeResult) && execPath.empty())
+            {
+                Gui::error(i18n::localize("CIA_UPDATE_WRITE_FAIL"), res);
+            }
+            else if (R_FAILED(res))
+            {
+                Gui::error(i18n::localize("UPDATE_FOUND_BUT_FAILED_DOWNLOAD"), res);
+            }
+            else
+            {
+                Gui::warn(i18n::localize("UPDATE_BAD_CHECKSUM"));
+            }
+            return false;
+        }
+
+        Gui::waitFrame(i18n::localize("UPDATE_INSTALLING"));
+        if (!execPath.empty())
+        {
+            // Stop using the 3DSX
+            romfsExit();
+            if (R_FAILED(Archive::moveFile(Archive::sd(), path, Archive::sd(), execPath)))
+            {
+                // RUN, THE INSTALL FAILED
+                romfsInit();
+                Archive::sd().deleteFile(path);
+                return false;
+            }
+            // No need to reinit ROMFS, as we're definitely about to reboot
+            // And if we don't reboot, then catastrophic errors are likely. Honestly,
+            // probably a good thing
+            return true;
+        }
+        if (R_FAILED(res = AM_FinishCiaInstall(sink.ciaInstall)))
+        {
+            Gui::error(i18n::localize("CIA_INSTALL_FINISH_FAIL"), res);
+            return false;
+        }
+        return true;
+    }
+
     bool update(std::string execPath)
     {
         u32 status;
@@ -196,7 +463,8 @@ namespace
             return false;
         }
         execPath        = execPath.substr(execPath.find(':') + 1);
-        std::string url = "", path = "", retString = "";
+        std::string url = "", retString = "";
+        std::optional<Sha256Hash> expectedHash;
         const std::string patronCode = Configuration::getInstance().patronCode();
         if (Configuration::getInstance().alphaChannel() && !patronCode.empty())
         {
@@ -222,16 +490,7 @@ namespace
                                 if (retString.substr(0, 8) != GIT_REV)
                                 {
                                     url = "https://flagbrew.org/patron/downloadLatest/";
-                                    if (execPath.empty())
-                                    {
-                                        url += "cia";
-                                        path = "/3ds/PKSM/PKSM.cia";
-                                    }
-                                    else
-                                    {
-                                        url += "3dsx";
-                                        path = execPath + ".new";
-                                    }
+                                    url += execPath.empty() ? "cia" : "3dsx";
                                 }
                                 break;
                             case 204:
@@ -297,16 +556,9 @@ namespace
                                 {
                                     url = "https://github.com/FlagBrew/PKSM/releases/download/" +
                                           newVersion + "/PKSM";
-                                    if (execPath != "")
-                                    {
-                                        url += ".3dsx";
-                                        path = execPath + ".new";
-                                    }
-                                    else
-                                    {
-                                        url += ".cia";
-                                        path = "/3ds/PKSM/PKSM.cia";
-                                    }
+                                    url += execPath.empty() ? ".cia" : ".3dsx";
+                                    expectedHash = releaseDigest(retJson,
+                                        execPath.empty() ? "PKSM.cia" : "PKSM.3dsx");
                                 }
                             }
                             break;
@@ -327,135 +579,9 @@ namespace
             backupExtData();
             backupBanks();
             Gui::waitFrame(i18n::localize("UPDATE_FOUND_DOWNLOAD"));
-            std::string fileName = path.substr(path.find_last_of('/') + 1);
-            Result res           = Fetch::download(
-                url, path, Configuration::getInstance().alphaChannel() ? "code=" + patronCode : "",
-                [](void* clientp, curl_off_t dltotal, curl_off_t dlnow, curl_off_t ultotal,
-                    curl_off_t ulnow) {
-                    Gui::showDownloadProgress(*(std::string*)clientp, dlnow / 1024, dltotal / 1024);
-                    return 0;
-                },
-                &fileName);
-            if (R_FAILED(res))
-            {
-                Gui::error(i18n::localize("UPDATE_FOUND_BUT_FAILED_DOWNLOAD"), res);
-                Archive::sd().deleteFile(path);
-                return false;
-            }
-
-            Gui::waitFrame(i18n::localize("UPDATE_INSTALLING"));
-            if (execPath != "")
-            {
-                // Stop using the 3DSX
-                romfsExit();
-                if (R_FAILED(Archive::moveFile(Archive::sd(), path, Archive::sd(), execPath)))
-                {
-                    // RUN, THE INSTALL FAILED
-                    romfsInit();
-                    Archive::sd().deleteFile(path);
-                    return false;
-                }
-                else
-                {
-                    // No need to reinit ROMFS, as we're definitely about to reboot
-                    // And if we don't reboot, then catastrophic errors are likely. Honestly,
-                    // probably a good thing
-                    return true;
-                }
-            }
-            else
-            {
-                // Adapted from https://github.com/joel16/3DShell/blob/master/source/cia.c
-                AM_TitleEntry title;
-                Handle dstHandle;
-                auto ciaFile = Archive::sd().file(path, FS_OPEN_READ);
-                if (ciaFile)
-                {
-                    if (R_FAILED(res = AM_GetCiaFileInfo(
-                                     MEDIATYPE_SD, &title, std::get<0>(ciaFile->getRawHandle()))))
-                    {
-                        Gui::error(i18n::localize("BAD_CIA_FILE"), res);
-                        ciaFile->close();
-                        return false;
-                    }
-
-                    if (R_FAILED(res = AM_StartCiaInstall(MEDIATYPE_SD, &dstHandle)))
-                    {
-                        Gui::error(i18n::localize("CIA_INSTALL_START_FAIL"), res);
-                        ciaFile->close();
-                        return false;
-                    }
-
-                    size_t bufSize = 0x10000;
-                    u8* buf        = (u8*)memalign(0x1000, bufSize);
-                    u8 backupBuf[0x1000];
-                    if (!buf)
-                    {
-                        buf     = backupBuf;
-                        bufSize = sizeof(backupBuf);
-                    }
-                    u32 bytesWritten, bytesRead;
-                    u64 offset          = 0;
-                    bool ciaInstallGood = true;
-                    do
-                    {
-                        memset(buf, 0, bufSize);
-
-                        bytesRead = ciaFile->read(buf, bufSize);
-                        if (R_FAILED(ciaFile->result()))
-                        {
-                            Gui::error(i18n::localize("CIA_UPDATE_READ_FAIL"), ciaFile->result());
-                            ciaFile->close();
-                            FSFILE_Close(dstHandle);
-                            return false;
-                        }
-
-                        if (R_FAILED(res = FSFILE_Write(dstHandle, &bytesWritten, offset, buf,
-                                         bytesRead, FS_WRITE_FLUSH)))
-                        {
-                            Gui::error(i18n::localize("CIA_UPDATE_WRITE_FAIL"), res);
-                            ciaFile->close();
-                            FSFILE_Close(dstHandle);
-                            return false;
-                        }
-
-                        if (bytesWritten != bytesRead)
-                        {
-                            ciaInstallGood = false;
-                        }
-
-                        offset += bytesRead;
-                    } while (offset < ciaFile->size() && ciaInstallGood);
-
-                    if (buf != backupBuf)
-                    {
-                        free(buf);
-                    }
-
-                    if (!ciaInstallGood)
-                    {
-                        AM_CancelCIAInstall(dstHandle);
-                        ciaFile->close();
-                        Gui::warn("Bytes written doesn't match bytes read:\n" +
-                                  std::to_string(bytesWritten) + " vs " +
-                                  std::to_string(bytesRead));
-                        return false;
-                    }
-
-                    if (R_FAILED(res = AM_FinishCiaInstall(dstHandle)))
-                    {
-                        Gui::error(i18n::localize("CIA_INSTALL_FINISH_FAIL"), res);
-                        ciaFile->close();
-                        return false;
-                    }
-
-                    ciaFile->close();
-
-                    Archive::sd().deleteFile(path);
-
-                    return true;
-                }
-            }
+            return installUpdate(url,
+                Configuration::getInstance().alphaChannel() ? "code=" + patronCode : "", execPath,
+                expectedHash);
         }
         return false;
     }
@@ -557,7 +683,7 @@ namespace
         }
     }
 
-    void i18nThread(void*)
+    void i18nThread(void)
     {
         constexpr pksm::Language languages[] = {pksm::Language::JPN, pksm::Language::ENG,
             pksm::Language::FRE, pksm::Language::ITA, pksm::Language::GER, pksm::Language::SPA,
@@ -818,7 +944,7 @@ Result App::init(const std::string& execPath)
 
     hidInit();
     gfxInitDefault();
-    Threads::init(1);
+    Threads::init();
 
     moveIcon.test_and_set();
     Threads::create(iconThread);
@@ -865,6 +991,8 @@ Result App::init(const std::string& execPath)
         return consoleDisplayError("Initializing network connection failed.", -1);
     }
 
+    FetchCache::init("/3ds/PKSM/cache", HTTP_CACHE_SIZE);
+
     if (R_FAILED(res = downloadAdditionalAssets()))
         return consoleDisplayError("Additional assets download failed.\n\nAlways make sure you're "
                                    "connected to the internet and on the lastest version.",
@@ -907,14 +1035,14 @@ Result App::init(const std::string& execPath)
 
     TitleLoader::init();
 
-    Threads::executeTask([](void*) { TitleLoader::scanTitles(); }, nullptr);
+    Threads::executeTask([] { TitleLoader::scanTitles(); });
     TitleLoader::scanSaves();
 
     doCartScan.test_and_set();
     Threads::create(cartScan, nullptr);
 
     continueI18N.test_and_set();
-    Threads::executeTask(i18nThread, nullptr);
+    Threads::executeTask(i18nThread, Threads::Priority::BACKGROUND);
 
     Gui::setScreen(std::make_unique<TitleLoadScreen>());
     // uncomment when needing to debug with GDB
@@ -931,6 +1059,7 @@ Result App::exit(void)
     TitleLoader::exit();
     Gui::exit();
     Fetch::exitMulti();
+    FetchCache::exit();
     curl_global_cleanup();
     socExit();
     acExit();
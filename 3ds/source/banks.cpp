@@ -27,7 +27,9 @@
 #include "banks.hpp"
 #include "Archive.hpp"
 #include "Configuration.hpp"
+#include "gui.hpp"
 #include "nlohmann/json.hpp"
+#include <list>
 
 // Public on purpose: banks being converted need to set their size
 nlohmann::json g_banks;
@@ -41,12 +43,10 @@ namespace
         return Banks::saveJson();
     }
 
-    Result read()
+    Result read(bool extData)
     {
-        std::string path =
-            Configuration::getInstance().useExtData() ? "/banks.json" : "/3ds/PKSM/banks.json";
-        auto in = (Configuration::getInstance().useExtData() ? Archive::data() : Archive::sd())
-                      .file(path, FS_OPEN_READ);
+        std::string path = extData ? "/banks.json" : "/3ds/PKSM/banks.json";
+        auto in          = (extData ? Archive::data() : Archive::sd()).file(path, FS_OPEN_READ);
         if (in)
         {
             size_t size = in->size();
@@ -62,6 +62,41 @@ namespace
         }
         return 0;
     }
+
+    // Open banks, most recently used first. Banks::bank is always among them
+    std::list<std::shared_ptr<Bank>> resident;
+    size_t budget = BANK_RESIDENCY_BUDGET;
+
+    std::list<std::shared_ptr<Bank>>::iterator findResident(const std::string& name)
+    {
+        return std::find_if(resident.begin(), resident.end(),
+            [&name](const std::shared_ptr<Bank>& bank) { return bank->name() == name; });
+    }
+
+    void trimResident()
+    {
+        size_t used = Banks::residentBytes();
+        // Closing clean banks is free, so only save changes once that isn't enough
+        for (bool saveChanges : {false, true})
+        {
+            for (auto i = resident.end(); used > budget && i != resident.begin();)
+            {
+                --i;
+                // Anything referenced from outside of this list, like the current bank, is in use
+                if (i->use_count() != 1)
+                {
+                    continue;
+                }
+                // A bank whose save fails or is declined keeps its changes open
+                if ((*i)->hasChanged() && (!saveChanges || !(*i)->save()))
+                {
+                    continue;
+                }
+                used -= (*i)->memoryUsage();
+                i = resident.erase(i);
+            }
+        }
+    }
 }
 
 Result Banks::saveJson()
@@ -91,7 +126,48 @@ Result Banks::saveJson()
 Result Banks::init()
 {
     Result res;
-    if (R_FAILED(res = read()))
+    bool recovered = false;
+
+    // swapSD moves banks.json last, so finding it only where the banks used to be means that the
+    // last swap was interrupted. Moving again picks up where it stopped
+    const bool extData = Configuration::getInstance().useExtData();
+
+    auto unmoved = (extData ? Archive::sd() : Archive::data())
+                       .file(extData ? "/3ds/PKSM/banks.json" : "/banks.json", FS_OPEN_READ);
+    if (unmoved)
+    {
+        unmoved->close();
+        auto moved = (extData ? Archive::data() : Archive::sd())
+                         .file(extData ? "/banks.json" : "/3ds/PKSM/banks.json", FS_OPEN_READ);
+        if (moved)
+        {
+            moved->close();
+        }
+        else if (R_FAILED(res = swapSD(!extData)))
+        {
+            Gui::error(i18n::localize("BANK_MOVE_ERROR"), res);
+            // Nothing is taken out of the old location until the whole banks folder has been
+            // copied, so while it's there it can simply be used again. After that, only banks.json
+            // is left to move
+            if ((extData ? Archive::sd() : Archive::data())
+                    .readDirectory(extData ? "/3ds/PKSM/banks" : "/banks"))
+            {
+                Configuration::getInstance().useExtData(!extData);
+                Configuration::getInstance().save();
+            }
+            else if (R_SUCCEEDED(read(!extData)) && !g_banks.is_discarded())
+            {
+                recovered = true;
+                if (R_SUCCEEDED(saveJson()))
+                {
+                    (extData ? Archive::sd() : Archive::data())
+                        .deleteFile(extData ? "/3ds/PKSM/banks.json" : "/banks.json");
+                }
+            }
+        }
+    }
+
+    if (!recovered && R_FAILED(res = read(Configuration::getInstance().useExtData())))
         return res;
 
     if (g_banks.is_discarded())
@@ -124,7 +200,13 @@ bool Banks::loadBank(const std::string& name, const std::optional<int>& maxBoxes
             saveJson();
             found = g_banks.find(name);
         }
-        bank = std::make_unique<Bank>(found.key(), found.value().get<int>());
+        // Leaving a bank with changes means they were declined, so it's dropped rather than kept
+        if (bank && bank->hasChanged())
+        {
+            resident.remove(bank);
+        }
+        bank = openBank(found.key());
+        trimResident();
         return true;
     }
     return false;
@@ -148,9 +230,13 @@ void Banks::removeBank(const std::string& name)
             }
             loadBank(i.key(), i.value());
         }
+        resident.remove_if(
+            [&name](const std::shared_ptr<Bank>& bank) { return bank->name() == name; });
         Archive::sd().deleteFile("/3ds/PKSM/banks/" + name + ".bnk");
+        Archive::sd().deleteFile("/3ds/PKSM/banks/" + name + ".names");
         Archive::sd().deleteFile("/3ds/PKSM/banks/" + name + ".json");
         Archive::data().deleteFile("/banks/" + name + ".bnk");
+        Archive::data().deleteFile("/banks/" + name + ".names");
         Archive::data().deleteFile("/banks/" + name + ".json");
         for (auto i = g_banks.begin(); i != g_banks.end(); i++)
         {
@@ -178,23 +264,23 @@ void Banks::renameBank(const std::string& oldName, const std::string& newName)
 {
     if (oldName != newName && g_banks.contains(oldName))
     {
-        if (bank->name() == oldName)
+        if (auto found = findResident(oldName); found != resident.end())
         {
-            if (!bank->setName(newName))
+            if (!(*found)->setName(newName))
             {
                 return;
             }
         }
         else
         {
-            Archive::moveFile(Archive::data(), "/banks/" + oldName + ".bnk", Archive::data(),
-                "/banks/" + newName + ".bnk");
-            Archive::moveFile(Archive::data(), "/banks/" + oldName + ".json", Archive::data(),
-                "/banks/" + newName + ".json");
-            Archive::moveFile(Archive::sd(), "/3ds/PKSM/banks/" + oldName + ".bnk", Archive::sd(),
-                "/3ds/PKSM/banks/" + newName + ".bnk");
-            Archive::moveFile(Archive::sd(), "/3ds/PKSM/banks/" + oldName + ".json", Archive::sd(),
-                "/3ds/PKSM/banks/" + newName + ".json");
+            // Banks that haven't been opened since box names moved out of JSON still have a .json
+            for (const auto& extension : {".bnk", ".names", ".json"})
+            {
+                Archive::moveFile(Archive::data(), "/banks/" + oldName + extension,
+                    Archive::data(), "/banks/" + newName + extension);
+                Archive::moveFile(Archive::sd(), "/3ds/PKSM/banks/" + oldName + extension,
+                    Archive::sd(), "/3ds/PKSM/banks/" + newName + extension);
+            }
         }
         g_banks[newName] = g_banks[oldName];
         g_banks.erase(oldName);
@@ -207,21 +293,120 @@ void Banks::setBankSize(const std::string& name, int size)
     if (g_banks.count(name))
     {
         g_banks[name] = size;
-        if (bank && bank->name() == name && size != bank->boxes())
+        if (auto found = findResident(name); found != resident.end() && size != (*found)->boxes())
         {
-            bank->resize(size);
+            (*found)->resize(size);
         }
         saveJson();
+        trimResident();
+    }
+}
+
+std::shared_ptr<Bank> Banks::openBank(const std::string& name)
+{
+    if (auto found = findResident(name); found != resident.end())
+    {
+        resident.splice(resident.begin(), resident, found);
+        return resident.front();
+    }
+    auto found = g_banks.find(name);
+    if (found == g_banks.end())
+    {
+        return nullptr;
+    }
+    auto ret = std::make_shared<Bank>(found.key(), found.value().get<int>());
+    resident.emplace_front(ret);
+    trimResident();
+    return ret;
+}
+
+bool Banks::isResident(const std::string& name)
+{
+    return findResident(name) != resident.end();
+}
+
+std::vector<std::string> Banks::residentBanks()
+{
+    std::vector<std::string> ret;
+    for (const auto& bank : resident)
+    {
+        ret.emplace_back(bank->name());
+    }
+    return ret;
+}
+
+size_t Banks::residentBytes()
+{
+    size_t ret = 0;
+    for (const auto& bank : resident)
+    {
+        ret += bank->memoryUsage();
+    }
+    return ret;
+}
+
+size_t Banks::residencyBudget()
+{
+    return budget;
+}
+
+void Banks::residencyBudget(size_t bytes)
+{
+    budget = bytes;
+    trimResident();
+}
+
+bool Banks::movePkm(const std::string& fromBank, int fromBox, int fromSlot,
+    const std::string& toBank, int toBox, int toSlot)
+{
+    auto from = openBank(fromBank);
+    auto to   = openBank(toBank);
+    if (!from || !to || fromBox < 0 || fromBox >= from->boxes() || toBox < 0 ||
+        toBox >= to->boxes() || fromSlot < 0 || fromSlot >= 30 || toSlot < 0 || toSlot >= 30)
+    {
+        return false;
+    }
+    Bank::swapPkm(*from, fromBox, fromSlot, *to, toBox, toSlot);
+    return true;
+}
+
+void Banks::saveChanged()
+{
+    for (const auto& bank : resident)
+    {
+        if (bank->hasChanged())
+        {
+            bank->save();
+        }
+    }
+}
+
+void Banks::update()
+{
+    // Reporting runs a screen of its own, so work on a copy in case the list changes meanwhile
+    std::vector<std::shared_ptr<Bank>> banks(resident.begin(), resident.end());
+    for (const auto& bank : banks)
+    {
+        bank->update();
     }
 }
 
 Result Banks::swapSD(bool toSD)
 {
     Result res = 0;
+    // Drawing waits for the next frame, so only redraw when the percentage shown would change
+    Archive::TransferProgress progress = [shown = u64(-1)](u64 done, u64 total) mutable {
+        u64 percent = total == 0 ? 100 : done * 100 / total;
+        if (percent != shown)
+        {
+            shown = percent;
+            Gui::showProgress(i18n::localize("BANK_MOVE"), done / 1024, total / 1024);
+        }
+    };
     if (toSD)
     {
         if (R_FAILED(res = Archive::moveDir(
-                         Archive::data(), "/banks", Archive::sd(), "/3ds/PKSM/banks")))
+                         Archive::data(), "/banks", Archive::sd(), "/3ds/PKSM/banks", progress)))
             return res;
         if (R_FAILED(res = Archive::moveFile(
                          Archive::data(), "/banks.json", Archive::sd(), "/3ds/PKSM/banks.json")))
@@ -230,7 +415,7 @@ Result Banks::swapSD(bool toSD)
     else
     {
         if (R_FAILED(res = Archive::moveDir(
-                         Archive::sd(), "/3ds/PKSM/banks", Archive::data(), "/banks")))
+                         Archive::sd(), "/3ds/PKSM/banks", Archive::data(), "/banks", progress)))
             return res;
         if (R_FAILED(res = Archive::moveFile(
                          Archive::sd(), "/3ds/PKSM/banks.json", Archive::data(), "/banks.json")))
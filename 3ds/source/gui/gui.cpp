@@ -29,6 +29,7 @@
 #include "DecisionScreen.hpp"
 #include "MessageScreen.hpp"
 #include "TextParse.hpp"
+#include "banks.hpp"
 #include "format.h"
 #include "personal.hpp"
 #include "pkx/PKX.hpp"
@@ -62,13 +63,33 @@ namespace
     bool textMode = false;
     bool inFrame  = false;
 
+    // Retained drawing. A screen that's neither animated nor touched by input keeps showing its
+    // last frame, as nothing is presented to it until it's marked for redrawing
+    bool redrawTop       = true;
+    bool redrawBottom    = true;
+    bool mainLoopDrawing = false;
+
+    // Called by anything that changes on its own from frame to frame
+    void keepAnimating()
+    {
+        if (currentText == &bottomText)
+        {
+            redrawBottom = true;
+        }
+        else
+        {
+            redrawTop = true;
+        }
+    }
+
     struct ScrollingTextOffset
     {
         int offset;
         int pauseTime;
         bool thisFrame;
     };
-    std::unordered_map<std::string, ScrollingTextOffset> scrollOffsets;
+    // Keyed by the parsed text, which stays put until the text buffer is cleared
+    std::unordered_map<const TextParse::Text*, ScrollingTextOffset> scrollOffsets;
 
     Tex3DS_SubTexture _select_box(const C2D_Image& image, int x, int y, int endX, int endY)
     {
@@ -533,6 +554,7 @@ void Gui::setDoHomeDraw()
 {
     noHomeAlpha  = 1.0f;
     dNoHomeAlpha = NOHOMEALPHA_ACCEL;
+    redrawBottom = true;
 }
 
 void Gui::drawNoHome()
@@ -545,11 +567,17 @@ void Gui::drawNoHome()
             90.0f, &tint);
         noHomeAlpha -= dNoHomeAlpha;
         dNoHomeAlpha += NOHOMEALPHA_ACCEL;
+        keepAnimating();
     }
 }
 
 void Gui::target(gfxScreen_t screen)
 {
+    if (!mainLoopDrawing)
+    {
+        // Someone else is drawing over whatever the main loop left on screen
+        redrawTop = redrawBottom = true;
+    }
     if (screen == GFX_BOTTOM)
     {
         currentText = &bottomText;
@@ -630,6 +658,7 @@ void Gui::backgroundAnimatedTop()
 
     Gui::drawImageAt({bgBoxes.tex, &boxes1}, x1--, 0);
     Gui::drawImageAt({bgBoxes.tex, &boxes2}, x2--, 0);
+    keepAnimating();
 }
 
 void Gui::backgroundAnimatedBottom()
@@ -650,10 +679,12 @@ void Gui::backgroundAnimatedBottom()
 
     Gui::drawImageAt({bgBoxes.tex, &boxes1}, x1--, 0);
     Gui::drawImageAt({bgBoxes.tex, &boxes2}, x2--, 0);
+    keepAnimating();
 }
 
 void Gui::clearText(void)
 {
+    scrollOffsets.clear();
     textBuffer->clearUnconditional();
 }
 
@@ -665,26 +696,43 @@ std::shared_ptr<TextParse::Text> Gui::parseText(
     return textBuffer->parse(str, maxWidth);
 }
 
-void Gui::text(std::shared_ptr<TextParse::Text> text, float x, float y, FontSize sizeX,
-    FontSize sizeY, PKSM_Color color, TextPosX positionX, TextPosY positionY)
+namespace
 {
-    static_assert(std::is_same<FontSize, float>::value);
-    textMode            = true;
-    const float lineMod = sizeY * C2D_FontGetInfo(fonts[1])->lineFeed;
-    y -= sizeY * 6;
-    switch (positionY)
+    float textY(const TextParse::Text& text, float y, FontSize sizeY, TextPosY positionY)
     {
-        case TextPosY::TOP:
-            break;
-        case TextPosY::CENTER:
-            y -= 0.5f * (lineMod * (float)text->lines());
-            break;
-        case TextPosY::BOTTOM:
-            y -= lineMod * (float)text->lines();
-            break;
+        static_assert(std::is_same<FontSize, float>::value);
+        const float lineMod = sizeY * C2D_FontGetInfo(fonts[1])->lineFeed;
+        y -= sizeY * 6;
+        switch (positionY)
+        {
+            case TextPosY::TOP:
+                break;
+            case TextPosY::CENTER:
+                y -= 0.5f * (lineMod * (float)text.lines());
+                break;
+            case TextPosY::BOTTOM:
+                y -= lineMod * (float)text.lines();
+                break;
+        }
+        return y;
     }
 
-    currentText->addText(text, x, y, 0.5f, sizeX, sizeY, positionX, color);
+    // Draws the part of text that's within maxWidth once moved by scrollOffset, both in pixels
+    void textSlice(const TextParse::Text& text, float maxWidth, float scrollOffset, float x,
+        float y, FontSize size, PKSM_Color color, TextPosX positionX, TextPosY positionY)
+    {
+        textMode = true;
+        currentText->addTextSlice(text, maxWidth / size, scrollOffset / size, x,
+            textY(text, y, size, positionY), 0.5f, size, size, positionX, color);
+    }
+}
+
+void Gui::text(std::shared_ptr<TextParse::Text> text, float x, float y, FontSize sizeX,
+    FontSize sizeY, PKSM_Color color, TextPosX positionX, TextPosY positionY)
+{
+    textMode = true;
+    currentText->addText(
+        text, x, textY(*text, y, sizeY, positionY), 0.5f, sizeX, sizeY, positionX, color);
 }
 
 void Gui::text(const std::string& str, float x, float y, FontSize size, PKSM_Color color,
@@ -725,8 +773,7 @@ void Gui::text(const std::string& str, float x, float y, FontSize size, PKSM_Col
                 return;
             }
 
-            text = text->slice(maxWidth / size);
-            Gui::text(text, x, y, size, size, color, positionX, positionY);
+            textSlice(*text, maxWidth, 0.0f, x, y, size, color, positionX, positionY);
         }
         break;
         case TextWidthAction::SCROLL:
@@ -738,10 +785,10 @@ void Gui::text(const std::string& str, float x, float y, FontSize size, PKSM_Col
                 return;
             }
 
-            auto offsetIt = scrollOffsets.find(str);
+            auto offsetIt = scrollOffsets.find(text.get());
             if (offsetIt == scrollOffsets.end())
             {
-                offsetIt = scrollOffsets.emplace(str, ScrollingTextOffset{0, 1, true}).first;
+                offsetIt = scrollOffsets.emplace(text.get(), ScrollingTextOffset{0, 1, true}).first;
             }
 
             if (!offsetIt->second.thisFrame)
@@ -776,8 +823,9 @@ void Gui::text(const std::string& str, float x, float y, FontSize size, PKSM_Col
                 }
             }
 
-            text = text->slice(maxWidth / size, (float)-offsetIt->second.offset / 3.0f / size);
-            Gui::text(text, x, y, size, size, color, positionX, positionY);
+            textSlice(*text, maxWidth, (float)-offsetIt->second.offset / 3.0f, x, y, size, color,
+                positionX, positionY);
+            keepAnimating();
         }
         break;
         case TextWidthAction::SQUISH_OR_SLICE:
@@ -846,6 +894,16 @@ void Gui::frameClean()
     }
 }
 
+void Gui::requestRedraw(void)
+{
+    redrawTop = redrawBottom = true;
+}
+
+void Gui::keepAnimating(void)
+{
+    ::keepAnimating();
+}
+
 void Gui::mainLoop(void)
 {
     bool exit = false;
@@ -853,61 +911,89 @@ void Gui::mainLoop(void)
     while (aptMainLoop() && !exit)
     {
         hidScanInput();
-        C3D_FrameBegin(C3D_FRAME_SYNCDRAW);
-        inFrame = true;
-        Gui::clearScreen(GFX_TOP);
-        Gui::clearScreen(GFX_BOTTOM);
 
         u32 kHeld = hidKeysHeld();
 
-        if (kHeld & KEY_SELECT && !screens.top()->getInstructions().empty())
+        if (!aptIsHomeAllowed() && aptCheckHomePressRejected())
         {
-            target(GFX_TOP);
-            screens.top()->doTopDraw();
-            screens.top()->getInstructions().drawTop();
-            flushText();
-            target(GFX_BOTTOM);
-            screens.top()->doBottomDraw();
-            screens.top()->getInstructions().drawBottom();
-            flushText();
-
-            if (!aptIsHomeAllowed() && aptCheckHomePressRejected())
-            {
-                setDoHomeDraw();
-            }
-            drawNoHome();
+            setDoHomeDraw();
+        }
 
-            C3D_FrameEnd(0);
-            Gui::frameClean();
-            inFrame = false;
+        const bool hadInput = kHeld || hidKeysDown() || hidKeysUp();
+        if (!screens.top()->isRetained() || hadInput)
+        {
+            requestRedraw();
         }
-        else
+
+        const bool showInstructions =
+            kHeld & KEY_SELECT && !screens.top()->getInstructions().empty();
+        const bool drawTop    = redrawTop;
+        const bool drawBottom = redrawBottom;
+        redrawTop = redrawBottom = false;
+
+        if (drawTop || drawBottom)
         {
-            target(GFX_TOP);
-            screens.top()->doTopDraw();
-            flushText();
+            // Screens that aren't drawn to aren't swapped either, so they keep their last frame
+            C3D_FrameBegin(C3D_FRAME_SYNCDRAW);
+            inFrame         = true;
+            mainLoopDrawing = true;
 
-            target(GFX_BOTTOM);
-            screens.top()->doBottomDraw();
-            flushText();
+            if (drawTop)
+            {
+                Gui::clearScreen(GFX_TOP);
+                target(GFX_TOP);
+                screens.top()->doTopDraw();
+                if (showInstructions)
+                {
+                    screens.top()->getInstructions().drawTop();
+                }
+                flushText();
+            }
 
-            if (!aptIsHomeAllowed() && aptCheckHomePressRejected())
+            if (drawBottom)
             {
-                setDoHomeDraw();
+                Gui::clearScreen(GFX_BOTTOM);
+                target(GFX_BOTTOM);
+                screens.top()->doBottomDraw();
+                if (showInstructions)
+                {
+                    screens.top()->getInstructions().drawBottom();
+                }
+                flushText();
+                drawNoHome();
             }
-            drawNoHome();
 
+            mainLoopDrawing = false;
             C3D_FrameEnd(0);
             Gui::frameClean();
             inFrame = false;
+        }
+        else
+        {
+            gspWaitForVBlank();
+        }
 
+        if (!showInstructions)
+        {
             touchPosition touch;
             hidTouchRead(&touch);
             screens.top()->doUpdate(&touch);
             exit = screens.size() == 1 && (kHeld & KEY_START);
+            Banks::update();
+        }
+
+        // This frame was drawn before the update, so show what the input changed, like a key
+        // being released, next frame even if there is no more input by then
+        if (hadInput)
+        {
+            requestRedraw();
         }
 
-        textBuffer->clear();
+        // Offsets are keyed by address, so they have to go with the texts they belong to
+        if (textBuffer->clear())
+        {
+            scrollOffsets.clear();
+        }
     }
 }
 
@@ -2173,6 +2259,7 @@ void Gui::type(pksm::Language lang, pksm::Type type, int x, int y)
 void Gui::setScreen(std::unique_ptr<Screen> screen)
 {
     screens.push(std::move(screen));
+    requestRedraw();
 }
 
 int Gui::pointerBob()
@@ -2195,6 +2282,7 @@ int Gui::pointerBob()
             up = true;
         }
     }
+    keepAnimating();
     return currentBob / 4;
 }
 
@@ -2214,6 +2302,7 @@ u8 Gui::transparencyWaver()
         if (currentAmount < 155)
             dir = false;
     }
+    keepAnimating();
     return currentAmount;
 }
 
@@ -2273,9 +2362,10 @@ void Gui::screenBack()
 {
     scrollOffsets.clear();
     screens.pop();
+    requestRedraw();
 }
 
-void Gui::showRestoreProgress(u32 partial, u32 total)
+void Gui::showProgress(const std::string& message, u32 partial, u32 total)
 {
     if (inFrame)
     {
@@ -2288,8 +2378,7 @@ void Gui::showRestoreProgress(u32 partial, u32 total)
     Gui::clearScreen(GFX_BOTTOM);
     target(GFX_TOP);
     sprite(ui_sheet_part_info_top_idx, 0, 0);
-    text(i18n::localize("SAVING"), 200, 95, FONT_SIZE_15, COLOR_WHITE, TextPosX::CENTER,
-        TextPosY::TOP);
+    text(message, 200, 95, FONT_SIZE_15, COLOR_WHITE, TextPosX::CENTER, TextPosY::TOP);
     text(fmt::format(i18n::localize("SAVE_PROGRESS"), partial, total), 200, 130, FONT_SIZE_12,
         COLOR_WHITE, TextPosX::CENTER, TextPosY::TOP);
     flushText();
@@ -2306,35 +2395,14 @@ void Gui::showRestoreProgress(u32 partial, u32 total)
     }
 }
 
-void Gui::showDownloadProgress(const std::string& path, u32 partial, u32 total)
+void Gui::showRestoreProgress(u32 partial, u32 total)
 {
-    if (inFrame)
-    {
-        C3D_FrameEnd(0);
-        Gui::frameClean();
-    }
-
-    C3D_FrameBegin(C3D_FRAME_SYNCDRAW);
-    Gui::clearScreen(GFX_TOP);
-    Gui::clearScreen(GFX_BOTTOM);
-    target(GFX_TOP);
-    sprite(ui_sheet_part_info_top_idx, 0, 0);
-    text(fmt::format(i18n::localize("DOWNLOADING_FILE"), path), 200, 95, FONT_SIZE_15, COLOR_WHITE,
-        TextPosX::CENTER, TextPosY::TOP);
-    text(fmt::format(i18n::localize("SAVE_PROGRESS"), partial, total), 200, 130, FONT_SIZE_12,
-        COLOR_WHITE, TextPosX::CENTER, TextPosY::TOP);
-    flushText();
-
-    target(GFX_BOTTOM);
-    sprite(ui_sheet_part_info_bottom_idx, 0, 0);
-
-    C3D_FrameEnd(0);
-    Gui::frameClean();
+    showProgress(i18n::localize("SAVING"), partial, total);
+}
 
-    if (inFrame)
-    {
-        C3D_FrameBegin(C3D_FRAME_SYNCDRAW);
-    }
+void Gui::showDownloadProgress(const std::string& path, u32 partial, u32 total)
+{
+    showProgress(fmt::format(i18n::localize("DOWNLOADING_FILE"), path), partial, total);
 }
 
 void Gui::showResizeStorage()
@@ -2433,4 +2501,5 @@ void Gui::drawSelector(float x, float y)
     Gui::drawSolidRect(x, y + 50 - w, 50, w, color);             // bottom
 
     timer += .025f;
+    keepAnimating();
 }
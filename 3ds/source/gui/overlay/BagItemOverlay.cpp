@@ -25,10 +25,12 @@
  */
 
 #include "BagItemOverlay.hpp"
+#include "Configuration.hpp"
 #include "gui.hpp"
 #include "loader.hpp"
 #include "sav/Item.hpp"
 #include "sav/Sav.hpp"
+#include "searchindex.hpp"
 #include "utils/utils.hpp"
 
 void BagItemOverlay::drawBottom() const
@@ -81,13 +83,14 @@ void BagItemOverlay::update(touchPosition* touch)
 
     if (!searchString.empty() && searchString != oldSearchString)
     {
+        const SearchIndex& index = SearchIndex::items(
+            Configuration::getInstance().language(), TitleLoader::save->generation());
+        const auto found = index.find(searchString);
         items.clear();
         items.emplace_back(validItems[0]);
         for (size_t i = 1; i < validItems.size(); i++)
         {
-            std::string itemName = validItems[i].first->substr(0, searchString.size());
-            StringUtils::toLower(itemName);
-            if (itemName == searchString)
+            if (found.contains(validItems[i].second))
             {
                 items.emplace_back(validItems[i]);
             }
@@ -26,6 +26,7 @@
 
 #include "FileChooseOverlay.hpp"
 #include "Configuration.hpp"
+#include "STDirectory.hpp"
 #include "gui.hpp"
 #include "i18n_ext.hpp"
 #include <algorithm>
@@ -35,7 +36,6 @@ FileChooseOverlay::FileChooseOverlay(
     : ReplaceableScreen(&screen, i18n::localize("A_SELECT") + '\n' + i18n::localize("B_BACK")),
       currDirString("/"),
       rootString(rootString),
-      currDir("/"),
       string(retString),
       hid(9, 1)
 {
@@ -93,18 +93,15 @@ void FileChooseOverlay::updateEntries()
 {
     hid.select(0);
     currFiles.clear();
+    STDirectoryReader currDir(currDirString);
     if (!currDir.good())
     {
         Gui::warn(i18n::localize("FOLDER_DOESNT_EXIST"));
         return;
     }
-    for (size_t i = 0; i < currDir.count(); i++)
+    while (currDir.next())
     {
-        std::string item = currDir.item(i);
-        if (item != "." && item != "..")
-        {
-            currFiles.push_back(std::make_pair(item, currDir.folder(i)));
-        }
+        currFiles.emplace_back(std::string(currDir.name()), currDir.folder());
     }
     std::sort(currFiles.begin(), currFiles.end(),
         [this](
@@ -139,7 +136,6 @@ void FileChooseOverlay::update(touchPosition* touch)
         {
             currDirString = currDirString.substr(
                 0, currDirString.substr(0, currDirString.size() - 1).find_last_of('/') + 1);
-            currDir = STDirectory(currDirString);
             updateEntries();
         }
     }
@@ -150,7 +146,6 @@ void FileChooseOverlay::update(touchPosition* touch)
             if (currFiles[hid.fullIndex()].second)
             {
                 currDirString += currFiles[hid.fullIndex()].first + '/';
-                currDir = STDirectory(currDirString);
                 updateEntries();
             }
             else
@@ -30,6 +30,7 @@
 #include "gui.hpp"
 #include "i18n_ext.hpp"
 #include "pkx/PKX.hpp"
+#include "searchindex.hpp"
 #include "utils.hpp"
 
 LocationOverlay::LocationOverlay(ReplaceableScreen& screen, pksm::PKX& pkm, bool met)
@@ -38,7 +39,6 @@ LocationOverlay::LocationOverlay(ReplaceableScreen& screen, pksm::PKX& pkm, bool
       hid(40, 2),
       validLocations(i18n::rawLocations(
           Configuration::getInstance().language(), (pksm::Generation)pkm.version())),
-      locations(validLocations),
       met(met)
 {
     instructions.addBox(false, 75, 30, 170, 23, COLOR_GREY, i18n::localize("SEARCH"), COLOR_WHITE);
@@ -49,12 +49,15 @@ LocationOverlay::LocationOverlay(ReplaceableScreen& screen, pksm::PKX& pkm, bool
             return false;
         },
         ui_sheet_emulated_box_search_idx, "", 0, COLOR_BLACK);
+    locations.reserve(validLocations.size());
+    for (const auto& location : validLocations)
+    {
+        locations.emplace_back(location.first);
+    }
     hid.update(locations.size());
     hid.select(std::distance(locations.begin(),
-        std::find_if(locations.begin(), locations.end(),
-            [&pkm, met](const std::pair<u16, std::string>& pair) {
-                return pair.first == (met ? pkm.metLocation() : pkm.eggLocation());
-            })));
+        std::find(locations.begin(), locations.end(),
+            met ? pkm.metLocation() : pkm.eggLocation())));
 }
 
 void LocationOverlay::drawBottom() const
@@ -77,21 +80,15 @@ void LocationOverlay::drawTop() const
     Gui::drawSolidRect(x, y, 1, 11, COLOR_YELLOW);
     Gui::drawSolidRect(x, y + 10, 198, 1, COLOR_YELLOW);
     Gui::drawSolidRect(x + 197, y, 1, 11, COLOR_YELLOW);
-    // Stupid non random-access iterators
-    std::map<u16, std::string>::const_iterator locIt = locations.begin();
-    for (size_t i = 0; i < hid.page() * hid.maxVisibleEntries(); i++)
-    {
-        ++locIt;
-    }
     for (size_t i = 0; i < hid.maxVisibleEntries(); i++)
     {
         x = i < hid.maxVisibleEntries() / 2 ? 4 : 203;
         if (hid.page() * hid.maxVisibleEntries() + i < locations.size())
         {
-            Gui::text(std::to_string(locIt->first) + " - " + locIt->second, x,
+            u16 location = locations[hid.page() * hid.maxVisibleEntries() + i];
+            Gui::text(std::to_string(location) + " - " + validLocations.at(location), x,
                 (i % (hid.maxVisibleEntries() / 2)) * 12, FONT_SIZE_9, COLOR_WHITE, TextPosX::LEFT,
                 TextPosY::TOP);
-            ++locIt;
         }
         else
         {
@@ -119,21 +116,26 @@ void LocationOverlay::update(touchPosition* touch)
 
     if (!searchString.empty() && searchString != oldSearchString)
     {
+        const SearchIndex& index = SearchIndex::locations(
+            Configuration::getInstance().language(), (pksm::Generation)pkm.version());
+        const auto found = index.find(searchString);
         locations.clear();
-        for (auto i = validLocations.begin(); i != validLocations.end(); i++)
+        for (const auto& location : validLocations)
         {
-            std::string locName = i->second.substr(0, searchString.size());
-            StringUtils::toLower(locName);
-            if (locName == searchString)
+            if (found.contains(location.first))
             {
-                locations.emplace(*i);
+                locations.emplace_back(location.first);
             }
         }
         oldSearchString = searchString;
     }
     else if (searchString.empty() && !oldSearchString.empty())
     {
-        locations       = validLocations;
+        locations.clear();
+        for (const auto& location : validLocations)
+        {
+            locations.emplace_back(location.first);
+        }
         oldSearchString = searchString = "";
     }
     if (hid.fullIndex() >= locations.size())
@@ -147,18 +149,13 @@ void LocationOverlay::update(touchPosition* touch)
     {
         if (locations.size() > 0)
         {
-            auto locIt = locations.begin();
-            for (size_t i = 0; i < hid.fullIndex(); i++)
-            {
-                locIt++;
-            }
             if (met)
             {
-                pkm.metLocation(locIt->first);
+                pkm.metLocation(locations[hid.fullIndex()]);
             }
             else
             {
-                pkm.eggLocation(locIt->first);
+                pkm.eggLocation(locations[hid.fullIndex()]);
             }
         }
         parent->removeOverlay();
@@ -32,39 +32,10 @@
 #include "loader.hpp"
 #include "pkx/PKX.hpp"
 #include "sav/Sav.hpp"
+#include "searchindex.hpp"
 #include "utils.hpp"
 #include <set>
 
-namespace
-{
-    int index(std::vector<std::pair<pksm::Move, std::string>>& search, const std::string& v)
-    {
-        if (v == search[0].second || v == "")
-        {
-            return 0;
-        }
-        int index = -1, min = 0, mid = 0, max = search.size();
-        while (min <= max)
-        {
-            mid = min + (max - min) / 2;
-            if (search[mid].second == v)
-            {
-                index = mid;
-                break;
-            }
-            if (search[mid].second < v)
-            {
-                min = mid + 1;
-            }
-            else
-            {
-                max = mid - 1;
-            }
-        }
-        return index >= 0 ? index : 0;
-    }
-}
-
 MoveOverlay::MoveOverlay(ReplaceableScreen& screen, pksm::IPKFilterable& object, int moveIndex)
     : ReplaceableScreen(&screen, i18n::localize("A_SELECT") + '\n' + i18n::localize("B_BACK")),
       object(object),
@@ -72,46 +43,30 @@ MoveOverlay::MoveOverlay(ReplaceableScreen& screen, pksm::IPKFilterable& object,
       moveIndex(moveIndex)
 {
     instructions.addBox(false, 75, 30, 170, 23, COLOR_GREY, i18n::localize("SEARCH"), COLOR_WHITE);
-    const std::vector<std::string>& rawMoves =
-        i18n::rawMoves(Configuration::getInstance().language());
     pksm::Generation gen = !object.isFilter() ? object.generation() : pksm::Generation::EIGHT;
     const std::set<pksm::Move> availableMoves =
         TitleLoader::save
             ? TitleLoader::save->availableMoves()
             : pksm::VersionTables::availableMoves(pksm::GameVersion::oldestVersion(gen));
-    moves.reserve(availableMoves.size());
-    for (auto i = availableMoves.begin(); i != availableMoves.end(); i++)
+    validMoves.reserve(availableMoves.size());
+    if (availableMoves.count(pksm::Move::None))
+    {
+        validMoves.emplace_back(pksm::Move::None);
+    }
+    for (u16 id : SearchIndex::moves(Configuration::getInstance().language()).sorted())
     {
-        if (*i >= pksm::Move::BreakneckBlitzA && *i <= pksm::Move::TwinkleTackleB)
+        pksm::Move move = pksm::Move{id};
+        if (move == pksm::Move::None || !availableMoves.count(move) ||
+            (move >= pksm::Move::BreakneckBlitzA && move <= pksm::Move::TwinkleTackleB))
             continue;
-        moves.emplace_back(*i, rawMoves[u16(*i)]);
+        validMoves.emplace_back(move);
     }
-    std::sort(moves.begin(), moves.end(),
-        [](const std::pair<pksm::Move, std::string>& pair1,
-            const std::pair<pksm::Move, std::string>& pair2) {
-            if (pair1.first == pksm::Move::None)
-            {
-                return pair2.first != pksm::Move::None;
-            }
-            if (pair2.first == pksm::Move::None)
-            {
-                return false;
-            }
-            return pair1.second < pair2.second;
-        });
-    validMoves = moves;
+    moves = validMoves;
 
     hid.update(moves.size());
-    if (moveIndex < 4)
-    {
-        hid.select((u16)index(
-            moves, i18n::move(Configuration::getInstance().language(), object.move(moveIndex))));
-    }
-    else
-    {
-        hid.select((u16)index(moves, i18n::move(Configuration::getInstance().language(),
-                                         object.relearnMove(moveIndex - 4))));
-    }
+    pksm::Move current = moveIndex < 4 ? object.move(moveIndex) : object.relearnMove(moveIndex - 4);
+    auto it            = std::find(moves.begin(), moves.end(), current);
+    hid.select(it == moves.end() ? 0 : std::distance(moves.begin(), it));
     searchButton = std::make_unique<ClickButton>(
         75, 30, 170, 23,
         [this]() {
@@ -146,8 +101,9 @@ void MoveOverlay::drawTop() const
         x = i < hid.maxVisibleEntries() / 2 ? 4 : 203;
         if (hid.page() * hid.maxVisibleEntries() + i < moves.size())
         {
-            Gui::text(std::to_string(u16(moves[hid.page() * hid.maxVisibleEntries() + i].first)) +
-                          " - " + moves[hid.page() * hid.maxVisibleEntries() + i].second,
+            pksm::Move move = moves[hid.page() * hid.maxVisibleEntries() + i];
+            Gui::text(std::to_string(u16(move)) + " - " +
+                          i18n::move(Configuration::getInstance().language(), move),
                 x, (i % (hid.maxVisibleEntries() / 2)) * 12, FONT_SIZE_9, COLOR_WHITE,
                 TextPosX::LEFT, TextPosY::TOP);
         }
@@ -177,13 +133,13 @@ void MoveOverlay::update(touchPosition* touch)
 
     if (!searchString.empty() && searchString != oldSearchString)
     {
+        const auto found =
+            SearchIndex::moves(Configuration::getInstance().language()).find(searchString);
         moves.clear();
         moves.emplace_back(validMoves[0]);
         for (size_t i = 1; i < validMoves.size(); i++)
         {
-            std::string itemName = validMoves[i].second.substr(0, searchString.size());
-            StringUtils::toLower(itemName);
-            if (itemName == searchString)
+            if (found.contains(u16(validMoves[i])))
             {
                 moves.emplace_back(validMoves[i]);
             }
@@ -206,11 +162,11 @@ void MoveOverlay::update(touchPosition* touch)
     {
         if (moveIndex < 4)
         {
-            object.move(moveIndex, moves[hid.fullIndex()].first);
+            object.move(moveIndex, moves[hid.fullIndex()]);
         }
         else
         {
-            object.relearnMove(moveIndex - 4, moves[hid.fullIndex()].first);
+            object.relearnMove(moveIndex - 4, moves[hid.fullIndex()]);
         }
         if (!object.isFilter())
         {
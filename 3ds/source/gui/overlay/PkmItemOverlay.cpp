@@ -33,39 +33,10 @@
 #include "pkx/PK3.hpp"
 #include "pkx/PKX.hpp"
 #include "sav/Sav.hpp"
+#include "searchindex.hpp"
 #include "utils/utils.hpp"
 #include <set>
 
-namespace
-{
-    int index(std::vector<std::pair<int, std::string>>& search, const std::string& v)
-    {
-        if (v == search[0].second || v == "")
-        {
-            return 0;
-        }
-        int index = -1, min = 0, mid = 0, max = search.size();
-        while (min <= max)
-        {
-            mid = min + (max - min) / 2;
-            if (search[mid].second == v)
-            {
-                index = mid;
-                break;
-            }
-            if (search[mid].second < v)
-            {
-                min = mid + 1;
-            }
-            else
-            {
-                max = mid - 1;
-            }
-        }
-        return index >= 0 ? index : 0;
-    }
-}
-
 PkmItemOverlay::PkmItemOverlay(ReplaceableScreen& screen, pksm::PKX& pkm)
     : ReplaceableScreen(&screen, i18n::localize("A_SELECT") + '\n' + i18n::localize("B_BACK")),
       pkm(pkm),
@@ -80,48 +51,30 @@ PkmItemOverlay::PkmItemOverlay(ReplaceableScreen& screen, pksm::PKX& pkm)
         TitleLoader::save ? TitleLoader::save->availableItems()
                           : pksm::VersionTables::availableItems(
                                 pksm::GameVersion::oldestVersion(pkm.generation()));
-    for (auto i = availableItems.begin(); i != availableItems.end(); i++)
+    validItems.reserve(availableItems.size());
+    if (availableItems.count(0))
+    {
+        validItems.emplace_back(0);
+    }
+    for (u16 id :
+        SearchIndex::items(Configuration::getInstance().language(), pkm.generation()).sorted())
     {
-        if ((rawItems[*i].find("\uFF1F\uFF1F\uFF1F") != std::string::npos ||
-                rawItems[*i].find("???") != std::string::npos) ||
-            (*i >= 807 && *i <= 835) || (*i >= 927 && *i <= 932))
+        if (id == 0 || !availableItems.count(id))
+            continue;
+        if ((rawItems[id].find("\uFF1F\uFF1F\uFF1F") != std::string::npos ||
+                rawItems[id].find("???") != std::string::npos) ||
+            (id >= 807 && id <= 835) || (id >= 927 && id <= 932))
             continue; // Invalid items and bag Z-Crystals
-        items.emplace_back(*i, rawItems[*i]);
+        validItems.emplace_back(id);
     }
-    std::sort(items.begin(), items.end(),
-        [](const std::pair<int, std::string>& pair1, const std::pair<int, std::string>& pair2) {
-            if (pair1.first == 0)
-            {
-                return pair2.first != 0;
-            }
-            if (pair2.first == 0)
-            {
-                return false;
-            }
-            return pair1.second < pair2.second;
-        });
-    validItems = items;
+    items = validItems;
 
     hid.update(items.size());
     u16 item = pkm.generation() == pksm::Generation::THREE
                    ? reinterpret_cast<pksm::PK3&>(pkm).heldItem3()
                    : pkm.heldItem();
-    int itemIndex = index(items, pkm.generation() == pksm::Generation::THREE
-                                     ? i18n::item3(Configuration::getInstance().language(), item)
-                                     : i18n::item(Configuration::getInstance().language(), item));
-    // Checks to make sure that it's the correct item and not one with a duplicate name
-    if (items[itemIndex].first != item)
-    {
-        if (items[itemIndex + 1].second == items[itemIndex].second)
-        {
-            itemIndex++;
-        }
-        else
-        {
-            itemIndex--;
-        }
-    }
-    hid.select(itemIndex);
+    auto it  = std::find(items.begin(), items.end(), item);
+    hid.select(it == items.end() ? 0 : std::distance(items.begin(), it));
     searchButton = std::make_unique<ClickButton>(
         75, 30, 170, 23,
         [this]() {
@@ -156,8 +109,11 @@ void PkmItemOverlay::drawTop() const
         x = i < hid.maxVisibleEntries() / 2 ? 4 : 203;
         if (hid.page() * hid.maxVisibleEntries() + i < items.size())
         {
-            Gui::text(std::to_string(items[hid.page() * hid.maxVisibleEntries() + i].first) +
-                          " - " + items[hid.page() * hid.maxVisibleEntries() + i].second,
+            u16 item = items[hid.page() * hid.maxVisibleEntries() + i];
+            Gui::text(std::to_string(item) + " - " +
+                          (pkm.generation() == pksm::Generation::THREE
+                                  ? i18n::item3(Configuration::getInstance().language(), item)
+                                  : i18n::item(Configuration::getInstance().language(), item)),
                 x, (i % (hid.maxVisibleEntries() / 2)) * 12, FONT_SIZE_9, COLOR_WHITE,
                 TextPosX::LEFT, TextPosY::TOP);
         }
@@ -187,13 +143,14 @@ void PkmItemOverlay::update(touchPosition* touch)
 
     if (!searchString.empty() && searchString != oldSearchString)
     {
+        const SearchIndex& index =
+            SearchIndex::items(Configuration::getInstance().language(), pkm.generation());
+        const auto found = index.find(searchString);
         items.clear();
         items.emplace_back(validItems[0]);
         for (size_t i = 1; i < validItems.size(); i++)
         {
-            std::string itemName = validItems[i].second.substr(0, searchString.size());
-            StringUtils::toLower(itemName);
-            if (itemName == searchString)
+            if (found.contains(validItems[i]))
             {
                 items.emplace_back(validItems[i]);
             }
@@ -216,11 +173,11 @@ void PkmItemOverlay::update(touchPosition* touch)
     {
         if (pkm.generation() == pksm::Generation::THREE)
         {
-            reinterpret_cast<pksm::PK3&>(pkm).heldItem3((u16)items[hid.fullIndex()].first);
+            reinterpret_cast<pksm::PK3&>(pkm).heldItem3(items[hid.fullIndex()]);
         }
         else
         {
-            pkm.heldItem((u16)items[hid.fullIndex()].first);
+            pkm.heldItem(items[hid.fullIndex()]);
         }
         parent->removeOverlay();
         return;
@@ -32,6 +32,7 @@
 #include "loader.hpp"
 #include "pkx/PKX.hpp"
 #include "sav/Sav.hpp"
+#include "searchindex.hpp"
 #include "utils/utils.hpp"
 
 namespace
@@ -172,12 +173,11 @@ void SpeciesOverlay::update(touchPosition* touch)
             TitleLoader::save ? TitleLoader::save->availableSpecies()
                               : pksm::VersionTables::availableSpecies(
                                     pksm::GameVersion::oldestVersion(object.generation()));
+        const auto found =
+            SearchIndex::species(Configuration::getInstance().language(), set).find(searchString);
         for (auto i = set.begin(); i != set.end(); i++)
         {
-            std::string speciesName = i18n::species(Configuration::getInstance().language(), *i)
-                                          .substr(0, searchString.size());
-            StringUtils::toLower(speciesName);
-            if (speciesName == searchString)
+            if (found.contains(u16(*i)))
             {
                 dispPkm.push_back(*i);
             }
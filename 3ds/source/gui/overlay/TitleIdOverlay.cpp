@@ -96,7 +96,7 @@ void TitleIdOverlay::update(touchPosition* touch)
     if (kDown & KEY_B)
     {
         TitleLoader::reloadTitleIds();
-        Threads::executeTask([](void*) { TitleLoader::scanTitles(); }, nullptr);
+        Threads::executeTask([] { TitleLoader::scanTitles(); }, Threads::Priority::UI);
         parent->removeOverlay();
         return;
     }
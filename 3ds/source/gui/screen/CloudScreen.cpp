@@ -251,8 +251,8 @@ void CloudScreen::drawTop() const
         u16 x = 45;
         for (u8 column = 0; column < 6; column++)
         {
-            auto pkm = access.pkm(row * 6 + column);
-            if (pkm->species() != pksm::Species::None)
+            auto pkm = access.pkmView(row * 6 + column);
+            if (pkm && pkm->species() != pksm::Species::None)
             {
                 float blend = *pkm == *filter ? 0.0f : 0.5f;
                 Gui::pkm(*pkm, x, y, 1.0f, COLOR_BLACK, blend);
@@ -365,6 +365,7 @@ void CloudScreen::drawTop() const
 
 void CloudScreen::update(touchPosition* touch)
 {
+    access.update();
     if (!access.good())
     {
         if (access.currentPageError() != 0)
@@ -148,12 +148,14 @@ namespace
             timers[off] = 3;
         }
         timers[off]--;
+        Gui::keepAnimating();
         return retVals[off];
     }
 }
 
 ConfigScreen::ConfigScreen()
 {
+    retained = true;
     initButtons();
 }
 
@@ -275,7 +275,7 @@ void ExtraSavesScreen::update(touchPosition* touch)
     }
     else if (downKeys & KEY_B)
     {
-        Threads::executeTask([](void*) { TitleLoader::scanSaves(); }, nullptr);
+        Threads::executeTask([] { TitleLoader::scanSaves(); }, Threads::Priority::UI);
         Gui::screenBack();
         return;
     }
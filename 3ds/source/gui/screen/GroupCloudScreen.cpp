@@ -233,8 +233,8 @@ void GroupCloudScreen::drawTop() const
         u16 x = 45;
         for (u8 column = 0; column < 6; column++)
         {
-            auto pkm = access.pkm(row, column);
-            if (pkm->species() != pksm::Species::None)
+            auto pkm = access.pkmView(row, column);
+            if (pkm && pkm->species() != pksm::Species::None)
             {
                 float blend = *pkm == *filter ? 0.0f : 0.5f;
                 Gui::pkm(*pkm, x, y, 1.0f, COLOR_BLACK, blend);
@@ -354,6 +354,7 @@ void GroupCloudScreen::drawTop() const
 
 void GroupCloudScreen::update(touchPosition* touch)
 {
+    access.update();
     if (!access.good())
     {
         if (access.currentPageError() != 0)
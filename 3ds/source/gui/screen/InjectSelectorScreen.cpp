@@ -55,7 +55,14 @@ InjectSelectorScreen::InjectSelectorScreen()
       dumpHid(40, 8)
 {
     MysteryGift::init(TitleLoader::save->generation());
-    wondercards = MysteryGift::wondercards();
+    wondercards = MysteryGift::allMatches();
+
+    const std::string& lang = i18n::langString(Configuration::getInstance().language());
+    displayCards.reserve(wondercards.size());
+    for (size_t match : wondercards)
+    {
+        displayCards.emplace_back(MysteryGift::matchCard(match, lang));
+    }
 
     size_t currentCards = TitleLoader::save->currentGiftAmount();
     for (size_t i = 0; i < currentCards; i++)
@@ -137,21 +144,12 @@ void InjectSelectorScreen::update(touchPosition* touch)
         }
         if (downKeys & KEY_A)
         {
-            bool allReleased = true;
-            for (const auto& card : wondercards[hid.fullIndex()])
-            {
-                MysteryGift::giftData info = MysteryGift::wondercardInfo(card.get<int>());
-                if (!info.released)
-                {
-                    allReleased = false;
-                    break;
-                }
-            }
-            if (allReleased ||
+            size_t match = wondercards[hid.fullIndex()];
+            if (MysteryGift::matchReleased(match) ||
                 Gui::showChoiceMessage(
                     "Not all of these wonder card(s) are released.\nContinue to injection screen?"))
             {
-                Gui::setScreen(std::make_unique<InjectorScreen>(wondercards[hid.fullIndex()]));
+                Gui::setScreen(std::make_unique<InjectorScreen>(MysteryGift::matchCards(match)));
                 updateGifts = true;
                 return;
             }
@@ -323,16 +321,8 @@ void InjectSelectorScreen::drawTop() const
             }
             else
             {
-                MysteryGift::giftData data;
-                const std::string& lang = i18n::langString(Configuration::getInstance().language());
-                if (wondercards[i].find(lang) != wondercards[i].end())
-                {
-                    data = MysteryGift::wondercardInfo(wondercards[i][lang]);
-                }
-                else
-                {
-                    data = MysteryGift::wondercardInfo(*wondercards[i].begin());
-                }
+                const MysteryGift::giftData& data =
+                    MysteryGift::wondercardInfo(displayCards[wondercards[i]]);
                 int x = i % 2 == 0 ? 21 : 201;
                 int y = 43 + ((i % 10) / 2) * 37;
                 if (data.species == -1)
@@ -452,19 +442,12 @@ bool InjectSelectorScreen::toggleFilter(const std::string& lang)
 {
     if (langFilter != lang)
     {
-        wondercards = MysteryGift::wondercards();
-        for (size_t i = wondercards.size(); i > 0; i--)
-        {
-            if (!wondercards[i - 1].contains(lang))
-            {
-                wondercards.erase(wondercards.begin() + i - 1);
-            }
-        }
-        langFilter = lang;
+        wondercards = MysteryGift::matchesForLanguage(lang);
+        langFilter  = lang;
     }
     else
     {
-        wondercards = MysteryGift::wondercards();
+        wondercards = MysteryGift::allMatches();
         langFilter  = "";
     }
     return false;
@@ -91,7 +91,8 @@ namespace
 
 MainMenu::MainMenu() : Screen(i18n::localize("X_SAVE"))
 {
-    oldLang = Configuration::getInstance().language();
+    retained = true;
+    oldLang  = Configuration::getInstance().language();
     if (TitleLoader::save->generation() == pksm::Generation::FIVE)
     {
         ((pksm::Sav5*)TitleLoader::save.get())->cryptMysteryGiftData();
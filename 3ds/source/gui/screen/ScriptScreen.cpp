@@ -31,15 +31,24 @@
 #include "ScrollingTextScreen.hpp"
 #include "banks.hpp"
 #include "endian.hpp"
+#include "format.h"
 #include "gui.hpp"
 #include "loader.hpp"
+#include "scriptprofiler.hpp"
 #include "sav/Sav.hpp"
 #include "sav/Sav4.hpp"
+#include "utils/crypto.hpp"
 
 #include "picoc.h"
 #undef min // Get rid of picoc's min function
+extern "C" {
+#include "pksm_api.h"
+#include "tokencache.h"
+}
 
 #include <algorithm>
+#include <list>
+#include <sys/stat.h>
 
 namespace
 {
@@ -101,6 +110,81 @@ namespace
         return &picoc;
     }
 
+    struct CachedScript
+    {
+        std::string path;
+        size_t size;
+        u64 mtime;
+        std::string source;
+        // Keys the lexed tokens kept on SD
+        decltype(pksm::crypto::sha256(nullptr, 0)) hash;
+    };
+    // Scripts tend to be run several times in a row, so the last few are kept in memory. Most
+    // recently used first
+    std::list<CachedScript> scriptCache;
+    constexpr size_t MAX_CACHED_SCRIPTS = 4;
+
+    // Returns the source of a PicoC script, reading it only if it isn't cached or changed since
+    const CachedScript* scriptSource(const std::string& path)
+    {
+        struct stat info;
+        if (stat(path.c_str(), &info) != 0)
+        {
+            return nullptr;
+        }
+        // Fails on romfs, which can't change anyway
+        u64 mtime = 0;
+        archive_getmtime(path.c_str(), &mtime);
+
+        for (auto it = scriptCache.begin(); it != scriptCache.end(); ++it)
+        {
+            if (it->path == path)
+            {
+                if (it->size == (size_t)info.st_size && it->mtime == mtime)
+                {
+                    scriptCache.splice(scriptCache.begin(), scriptCache, it);
+                    return &scriptCache.front();
+                }
+                scriptCache.erase(it);
+                break;
+            }
+        }
+
+        FILE* in = fopen(path.c_str(), "rb");
+        if (!in)
+        {
+            return nullptr;
+        }
+        std::string source(info.st_size, '\0');
+        source.resize(fread(source.data(), 1, source.size(), in));
+        fclose(in);
+
+        // ignore "#!/path/to/picoc" by replacing the "#!" with "//", like PicocPlatformScanFile
+        if (source.size() >= 2 && source[0] == '#' && source[1] == '!')
+        {
+            source[0] = '/';
+            source[1] = '/';
+        }
+
+        auto hash = pksm::crypto::sha256((const u8*)source.data(), source.size());
+        scriptCache.push_front(
+            CachedScript{path, (size_t)info.st_size, mtime, std::move(source), hash});
+        if (scriptCache.size() > MAX_CACHED_SCRIPTS)
+        {
+            scriptCache.pop_back();
+        }
+        return &scriptCache.front();
+    }
+
+    // One file per script, so that editing a script replaces its tokens rather than adding more
+    std::string tokenCachePath(const std::string& path)
+    {
+        auto hash = pksm::crypto::sha256((const u8*)path.data(), path.size());
+        u64 id;
+        std::copy(hash.begin(), hash.begin() + sizeof(id), (u8*)&id);
+        return fmt::format(FMT_STRING("/3ds/PKSM/cache/scripts/{:016X}.tok"), id);
+    }
+
     std::vector<u8> scriptRead(const std::string& path)
     {
         std::vector<u8> ret;
@@ -382,11 +466,31 @@ void ScriptScreen::parsePicoCScript(std::string& file)
     // Set stdout to buffer to error
     setvbuf(stdout, error, _IOFBF, 4096);
 
+    // Holding R while starting a script times every API call it makes
+    bool profile = hidKeysHeld() & KEY_R;
+    if (profile)
+    {
+        ScriptProfiler::start();
+    }
+
     Picoc* picoc = picoC();
     if (!PicocPlatformSetExitPoint(picoc))
     {
         static constexpr int NUM_ARGS = 1;
-        PicocPlatformScanFile(picoc, file.c_str());
+        if (const CachedScript* script = scriptSource(file))
+        {
+            // The source stays owned by the cache; PicoC only needs it until PicocCleanup
+            PicocParseCached(picoc, file.c_str(), script->source.c_str(), script->source.size(),
+                script->hash.data(), tokenCachePath(file).c_str());
+        }
+        else
+        {
+            PicocPlatformScanFile(picoc, file.c_str());
+        }
+        if (profile)
+        {
+            ScriptProfiler::phase("Load");
+        }
         char* args[NUM_ARGS];
         char version = (char)TitleLoader::save->version();
         args[0]      = &version;
@@ -396,6 +500,13 @@ void ScriptScreen::parsePicoCScript(std::string& file)
     // Restore stdout state
     dup2(stdout_save, STDOUT_FILENO);
 
+    if (profile)
+    {
+        ScriptProfiler::phase("Run");
+        Gui::setScreen(std::make_unique<ScrollingTextScreen>(
+            file + "\n\n" + ScriptProfiler::stop(), std::nullopt));
+    }
+
     if (picoc->PicocExitValue != 0)
     {
         std::string show = error;
@@ -407,12 +518,10 @@ void ScriptScreen::parsePicoCScript(std::string& file)
         }
     }
 
-    if (Banks::bank->hasChanged())
-    {
-        Banks::bank->save();
-    }
+    Banks::saveChanged();
     TitleLoader::save->cryptBoxData(false);
     PicocCleanup(picoc);
+    pksm_api_cleanup();
     // And here we'll clean up
     aptSetHomeAllowed(true);
 }
@@ -36,6 +36,7 @@ ScrollingTextScreen::ScrollingTextScreen(
       pkm(pk),
       text(Gui::parseText(text, FONT_SIZE_12, 300.0f))
 {
+    retained = true;
     if (pkm)
     {
         addOverlay<ViewOverlay>(this->pkm->get(), false, "");
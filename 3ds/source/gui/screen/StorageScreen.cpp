@@ -364,6 +364,14 @@ void StorageScreen::drawTop() const
     Gui::sprite(ui_sheet_storagemenu_cross_idx, 36, 220);
     Gui::sprite(ui_sheet_storagemenu_cross_idx, 246, 220);
 
+    // Boxes that are still being read in the background are shown once they arrive instead of
+    // stalling the frame
+    bool boxLoaded = Banks::bank->boxLoaded(storageBox);
+    if (!boxLoaded)
+    {
+        Gui::text(i18n::localize("BANK_LOAD"), 45 + 204 / 2, 66 + 150 / 2, FONT_SIZE_12,
+            COLOR_WHITE, TextPosX::CENTER, TextPosY::CENTER);
+    }
     for (u8 row = 0; row < 5; row++)
     {
         u16 y = 66 + row * 30;
@@ -378,6 +386,10 @@ void StorageScreen::drawTop() const
             {
                 Gui::drawSolidRect(x, y, 34, 30, COLOR_GREEN_HIGHLIGHT);
             }
+            if (!boxLoaded)
+            {
+                continue;
+            }
             auto pkm = Banks::bank->pkm(storageBox, row * 6 + column);
             if (pkm->species() != pksm::Species::None)
             {
@@ -689,7 +701,7 @@ void StorageScreen::update(touchPosition* touch)
         prevBoxTop();
     }
 
-    if (cursorIndex != 0)
+    if (cursorIndex != 0 && (!storageChosen || Banks::bank->boxLoaded(storageBox)))
     {
         infoMon = storageChosen ? Banks::bank->pkm(storageBox, cursorIndex - 1)
                                 : TitleLoader::save->pkm(boxBox, cursorIndex - 1);
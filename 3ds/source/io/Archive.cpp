@@ -31,11 +31,13 @@
 #include "csvc.h"
 #include "internal_fspxi.hpp"
 #include "smdh.hpp"
+#include "thread.hpp"
 #include <sys/stat.h>
 
 namespace
 {
-    constexpr u64 MOVE_BUFFER_SIZE = 16 * 1024;
+    constexpr u64 MOVE_BUFFER_SIZE     = 16 * 1024;
+    constexpr u32 TRANSFER_BUFFER_SIZE = 64 * 1024;
 
     constexpr FS_ExtSaveDataInfo PKSM_ARCHIVE_DATA = {MEDIATYPE_SD, 0, 0, UNIQUE_ID, 0};
 
@@ -146,6 +148,155 @@ namespace
             }
         }
     }
+
+    struct TransferFile
+    {
+        std::u16string src;
+        std::u16string dst;
+        u64 size;
+    };
+
+    // Walks the tree under dir once. Folders are added as destination paths, parents first, and
+    // each directory is read to the end before its subfolders are, so only one is open at a time
+    Result listTree(Archive& src, const std::u16string& dir, const std::u16string& dest,
+        std::vector<std::u16string>& folders, std::vector<TransferFile>& files)
+    {
+        auto reader = src.readDirectory(dir);
+        if (!reader)
+        {
+            return src.result();
+        }
+
+        std::u16string srcDir = dir.back() == u'/' ? dir : dir + u'/';
+        std::u16string dstDir = dest.back() == u'/' ? dest : dest + u'/';
+        std::vector<std::u16string> subfolders;
+        while (reader->next())
+        {
+            std::u16string name(reader->name());
+            if (reader->folder())
+            {
+                subfolders.emplace_back(std::move(name));
+            }
+            else
+            {
+                files.push_back({srcDir + name, dstDir + name, reader->size()});
+            }
+        }
+        if (R_FAILED(reader->error()))
+        {
+            return reader->error();
+        }
+        reader = nullptr;
+
+        for (const auto& folder : subfolders)
+        {
+            folders.emplace_back(dstDir + folder);
+            Result res = listTree(src, srcDir + folder, dstDir + folder, folders, files);
+            if (R_FAILED(res))
+            {
+                return res;
+            }
+        }
+        return 0;
+    }
+
+    Result createTree(Archive& dst, const std::vector<std::u16string>& folders)
+    {
+        for (const auto& folder : folders)
+        {
+            Result res = dst.createDir(folder, 0);
+            if (R_FAILED(res) && res != (long)0xC82044BE && res != (long)0xC82044B9)
+            {
+                return res;
+            }
+        }
+        return 0;
+    }
+
+    // Copies all of the files as one stream of chunks through two buffers: while a task worker
+    // writes one chunk, the next one is read into the other buffer
+    Result transferFiles(Archive& src, Archive& dst, const std::vector<TransferFile>& files,
+        const Archive::TransferProgress& progress)
+    {
+        u64 total = 0;
+        for (const auto& file : files)
+        {
+            total += file.size;
+        }
+        u64 done = 0;
+        if (progress)
+        {
+            progress(done, total);
+        }
+
+        auto buffers      = std::unique_ptr<u8[]>(new u8[2 * TRANSFER_BUFFER_SIZE]);
+        size_t nextBuffer = 0;
+        Threads::Future<Result> pending;
+        u32 pendingSize = 0;
+
+        auto finishWrite = [&]() -> Result {
+            if (pending.valid())
+            {
+                Result res = pending.get();
+                pending    = {};
+                if (R_FAILED(res))
+                {
+                    return res;
+                }
+                done += pendingSize;
+                if (progress)
+                {
+                    progress(done, total);
+                }
+            }
+            return 0;
+        };
+
+        Result res = 0;
+        for (const auto& file : files)
+        {
+            auto in = src.file(file.src, FS_OPEN_READ);
+            if (!in)
+            {
+                res = src.result();
+                break;
+            }
+            dst.deleteFile(file.dst);
+            dst.createFile(file.dst, 0, file.size);
+            std::shared_ptr<File> out = dst.file(file.dst, FS_OPEN_WRITE);
+            if (!out)
+            {
+                res = dst.result();
+                break;
+            }
+
+            for (u64 offset = 0; offset < file.size;)
+            {
+                u8* buffer = buffers.get() + nextBuffer * TRANSFER_BUFFER_SIZE;
+                u32 size   = std::min<u64>(TRANSFER_BUFFER_SIZE, file.size - offset);
+                in->read(buffer, size);
+                if (R_FAILED(res = in->result()) || R_FAILED(res = finishWrite()))
+                {
+                    break;
+                }
+                pendingSize = size;
+                pending     = Threads::executeTask([out, buffer, size] {
+                    out->write(buffer, size);
+                    return out->result();
+                });
+                nextBuffer ^= 1;
+                offset += size;
+            }
+            if (R_FAILED(res))
+            {
+                break;
+            }
+        }
+
+        // Always wait, as the buffers must outlive the last write
+        Result last = finishWrite();
+        return R_FAILED(res) ? res : last;
+    }
 }
 
 Archive::Archive(FS_ArchiveID id, FS_Path path, bool pxi) : mPXI(pxi)
@@ -185,60 +336,48 @@ Archive& Archive::operator=(Archive&& other)
     return *this;
 }
 
-Result Archive::moveDir(
-    Archive& src, const std::u16string& dir, Archive& dst, const std::u16string& dest)
+Result Archive::moveDir(Archive& src, const std::u16string& dir, Archive& dst,
+    const std::u16string& dest, const TransferProgress& progress)
 {
     Result res;
 
-    dst.deleteDir(dest);
-
     if (src.mHandle == dst.mHandle && !src.mPXI && !dst.mPXI)
     {
+        dst.deleteDir(dest);
         res = FSUSER_RenameDirectory(src.mHandle, fsMakePath(PATH_UTF16, dir.c_str()), dst.mHandle,
             fsMakePath(PATH_UTF16, dest.c_str()));
         return res;
     }
     else if (src.mHandle == dst.mHandle && src.mPXI && dst.mPXI)
     {
+        dst.deleteDir(dest);
         res = FSPXI_RenameDirectory(fspxiHandle, src.mHandle, fsMakePath(PATH_UTF16, dir.c_str()),
             dst.mHandle, fsMakePath(PATH_UTF16, dest.c_str()));
         return res;
     }
     else
     {
-        if (R_FAILED(res = dst.createDir(dest, 0)) && res != (long)0xC82044BE &&
-            res != (long)0xC82044B9)
-            return res;
-        auto d                = src.directory(dir);
-        std::u16string srcDir = dir.back() == u'/' ? dir : dir + u'/';
-        std::u16string dstDir = dest.back() == u'/' ? dest : dest + u'/';
-        if (d)
+        // Nothing is deleted from src until everything has been copied, so an interrupted move can
+        // simply be started again
+        std::vector<std::u16string> folders = {dest};
+        std::vector<TransferFile> files;
+        if (R_FAILED(res = listTree(src, dir, dest, folders, files)))
         {
-            for (size_t i = 0; i < d->count(); i++)
+            // If dir itself is gone, an earlier move got as far as deleting it and is done
+            if (R_SUMMARY(res) == RS_NOTFOUND && folders.size() == 1 && files.empty())
             {
-                if (d->folder(i))
-                {
-                    if (R_FAILED(res = moveDir(src, srcDir + d->item(i), dst, dstDir + d->item(i))))
-                    {
-                        dst.deleteDir(dest);
-                        return res;
-                    }
-                }
-                else
-                {
-                    if (R_FAILED(
-                            res = moveFile(src, srcDir + d->item(i), dst, dstDir + d->item(i))))
-                    {
-                        dst.deleteDir(dest);
-                        return res;
-                    }
-                }
+                return 0;
             }
+            return res;
         }
-        else
+        if (R_FAILED(res = createTree(dst, folders)))
+        {
+            return res;
+        }
+        if (R_FAILED(res = transferFiles(src, dst, files, progress)))
         {
             dst.deleteDir(dest);
-            return src.result();
+            return res;
         }
 
         res = src.deleteDir(dir);
@@ -250,49 +389,22 @@ Result Archive::moveDir(
     }
 }
 
-Result Archive::copyDir(
-    Archive& src, const std::u16string& dir, Archive& dst, const std::u16string& dest)
+Result Archive::copyDir(Archive& src, const std::u16string& dir, Archive& dst,
+    const std::u16string& dest, const TransferProgress& progress)
 {
     Result res;
     dst.deleteDir(dest);
-    if (R_FAILED(res = dst.createDir(dest, 0)) && res != (long)0xC82044BE &&
-        res != (long)0xC82044B9)
-        return res;
-    auto d                = src.directory(dir);
-    std::u16string srcDir = dir.back() == u'/' ? dir : dir + u'/';
-    std::u16string dstDir = dest.back() == u'/' ? dest : dest + u'/';
-    if (d)
-    {
-        for (size_t i = 0; i < d->count(); i++)
-        {
-            if (d->folder(i))
-            {
-                if (R_FAILED(res = copyDir(src, srcDir + d->item(i), dst, dstDir + d->item(i))))
-                {
-                    dst.deleteDir(dest);
-                    return res;
-                }
-            }
-            else
-            {
-                if (R_FAILED(res = copyFile(src, srcDir + d->item(i), dst, dstDir + d->item(i))))
-                {
-                    dst.deleteDir(dest);
-                    return res;
-                }
-            }
-        }
-    }
-    else
+    std::vector<std::u16string> folders = {dest};
+    std::vector<TransferFile> files;
+    if (R_FAILED(res = listTree(src, dir, dest, folders, files)) ||
+        R_FAILED(res = createTree(dst, folders)) ||
+        R_FAILED(res = transferFiles(src, dst, files, progress)))
     {
         dst.deleteDir(dest);
-        return src.result();
+        return res;
     }
 
-    if (res == (long)0xC82044BE || res == (long)0xC82044B9)
-        return 0;
-
-    return res;
+    return 0;
 }
 
 Result Archive::moveFile(Archive& src, FS_Path file, Archive& dst, FS_Path dest)
@@ -468,13 +580,24 @@ Result Archive::createDir(FS_Path file, u32 attributes)
 }
 
 std::unique_ptr<Directory> Archive::directory(FS_Path dir)
+{
+    auto reader = readDirectory(dir);
+    if (reader)
+    {
+        return std::unique_ptr<Directory>(new Directory(*reader));
+    }
+    return nullptr;
+}
+
+std::unique_ptr<DirectoryReader> Archive::readDirectory(
+    FS_Path dir, std::u16string_view prefix, size_t batchSize)
 {
     if (mPXI)
     {
         FSPXI_Directory d;
         if (R_SUCCEEDED(mResult = FSPXI_OpenDirectory(fspxiHandle, &d, mHandle, dir)))
         {
-            return std::unique_ptr<Directory>(new Directory(d));
+            return std::unique_ptr<DirectoryReader>(new DirectoryReader(d, prefix, batchSize));
         }
     }
     else
@@ -482,7 +605,7 @@ std::unique_ptr<Directory> Archive::directory(FS_Path dir)
         Handle d;
         if (R_SUCCEEDED(mResult = FSUSER_OpenDirectory(&d, mHandle, dir)))
         {
-            return std::unique_ptr<Directory>(new Directory(d));
+            return std::unique_ptr<DirectoryReader>(new DirectoryReader(d, prefix, batchSize));
         }
     }
     return nullptr;
@@ -579,6 +702,8 @@ Result Archive::init(const std::string& execPath)
     mkdir("/3ds/PKSM/assets", 777);
     mkdir("/3ds/PKSM/backups", 777);
     mkdir("/3ds/PKSM/backups/bridge", 777);
+    mkdir("/3ds/PKSM/cache", 777);
+    mkdir("/3ds/PKSM/cache/scripts", 777);
     mkdir("/3ds/PKSM/defaults", 777);
     mkdir("/3ds/PKSM/dumps", 777);
     mkdir("/3ds/PKSM/banks", 777);
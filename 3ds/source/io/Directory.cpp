@@ -26,63 +26,114 @@
 
 #include "Directory.hpp"
 #include "internal_fspxi.hpp"
+#include <algorithm>
 
-#define DIRECTORY_READ_SIZE 10
+DirectoryReader::DirectoryReader(Handle handle, std::u16string_view prefix, size_t batchSize)
+    : batch(std::max(batchSize, size_t(1))), prefix(prefix), handle(handle), pxi(false)
+{
+}
 
-Directory::Directory(Handle handle)
+DirectoryReader::DirectoryReader(
+    FSPXI_Directory handle, std::u16string_view prefix, size_t batchSize)
+    : batch(std::max(batchSize, size_t(1))), prefix(prefix), pxiHandle(handle), pxi(true)
 {
-    load = false;
-    err  = 0;
+}
 
-    u32 result = 0;
-    std::array<FS_DirectoryEntry, DIRECTORY_READ_SIZE> tmp;
-    do
+DirectoryReader::~DirectoryReader()
+{
+    close();
+}
+
+void DirectoryReader::close(void)
+{
+    if (open)
     {
-        err = FSDIR_Read(handle, &result, DIRECTORY_READ_SIZE, tmp.data());
-        if (result > 0)
+        if (pxi)
+        {
+            FSPXI_CloseDirectory(fspxiHandle, pxiHandle);
+        }
+        else
         {
-            list.insert(list.end(), tmp.begin(), tmp.begin() + result);
+            FSDIR_Close(handle);
         }
-    } while (result);
+        open = false;
+    }
+}
 
-    if (R_FAILED(err))
+bool DirectoryReader::readBatch(void)
+{
+    u32 result = 0;
+    if (pxi)
     {
-        list.clear();
+        err = FSPXI_ReadDirectory(fspxiHandle, pxiHandle, &result, batch.size(), batch.data());
     }
     else
     {
-        load = true;
+        err = FSDIR_Read(handle, &result, batch.size(), batch.data());
     }
-
-    FSDIR_Close(handle);
+    current = 0;
+    filled  = R_SUCCEEDED(err) ? result : 0;
+    if (filled == 0)
+    {
+        // Done with it, so don't hold the handle until the reader is destroyed
+        close();
+    }
+    return filled > 0;
 }
 
-Directory::Directory(FSPXI_Directory handle)
+bool DirectoryReader::next(void)
 {
-    load = false;
-    err  = 0;
-
-    u32 result = 0;
-    std::array<FS_DirectoryEntry, DIRECTORY_READ_SIZE> tmp;
-    do
+    while (true)
     {
-        err = FSPXI_ReadDirectory(fspxiHandle, handle, &result, DIRECTORY_READ_SIZE, tmp.data());
-        if (result > 0)
+        if (++current >= filled && (!open || !readBatch()))
         {
-            list.insert(list.end(), tmp.begin(), tmp.begin() + result);
+            return false;
         }
-    } while (result);
+        if (name().substr(0, prefix.size()) == prefix)
+        {
+            return true;
+        }
+    }
+}
+
+Result DirectoryReader::error(void) const
+{
+    return err;
+}
+
+std::u16string_view DirectoryReader::name(void) const
+{
+    return (const char16_t*)batch[current].name;
+}
+
+bool DirectoryReader::folder(void) const
+{
+    return batch[current].attributes & FS_ATTRIBUTE_DIRECTORY;
+}
 
-    if (R_FAILED(err))
+u64 DirectoryReader::size(void) const
+{
+    return batch[current].fileSize;
+}
+
+const FS_DirectoryEntry& DirectoryReader::entry(void) const
+{
+    return batch[current];
+}
+
+Directory::Directory(DirectoryReader& reader)
+{
+    while (reader.next())
     {
-        list.clear();
+        list.emplace_back(reader.entry());
     }
-    else
+
+    err  = reader.error();
+    load = R_SUCCEEDED(err);
+    if (!load)
     {
-        load = true;
+        list.clear();
     }
-
-    FSPXI_CloseDirectory(fspxiHandle, handle);
 }
 
 Result Directory::error(void) const
@@ -65,6 +65,7 @@
 #include <errno.h>
 #include <netdb.h>
 #include <sys/socket.h>
+#include <unordered_map>
 
 #include "picoc.h"
 #undef min
@@ -639,6 +640,20 @@ void bank_select(
     Gui::runScreen(screen);
 }
 
+void bank_move_pkx(
+    struct ParseState* Parser, struct Value* ReturnValue, struct Value** Param, int NumArgs)
+{
+    char* fromBank = (char*)Param[0]->Val->Pointer;
+    int fromBox    = Param[1]->Val->Integer;
+    int fromSlot   = Param[2]->Val->Integer;
+    char* toBank   = (char*)Param[3]->Val->Pointer;
+    int toBox      = Param[4]->Val->Integer;
+    int toSlot     = Param[5]->Val->Integer;
+
+    ReturnValue->Val->Integer =
+        (int)Banks::movePkm(fromBank, fromBox, fromSlot, toBank, toBox, toSlot);
+}
+
 void net_ip(struct ParseState* Parser, struct Value* ReturnValue, struct Value** Param, int NumArgs)
 {
     char hostbuffer[256];
@@ -1198,797 +1213,677 @@ void pkx_is_valid(
         ReturnValue->Val->Integer = 1;
     }
 }
+}
 
-void pkx_set_value(
-    struct ParseState* Parser, struct Value* ReturnValue, struct Value** Param, int NumArgs)
+namespace
 {
-    u8* data              = (u8*)Param[0]->Val->Pointer;
-    pksm::Generation gen  = pksm::Generation(Param[1]->Val->Integer);
-    PKX_FIELD field       = PKX_FIELD(Param[2]->Val->Integer);
-    struct Value* nextArg = getNextVarArg(Param[2]);
-    checkGen(Parser, gen);
+    constexpr const char* fieldNames[] = {"OT_NAME", "TID", "SID", "SHINY", "LANGUAGE",
+        "MET_LOCATION", "MOVE", "BALL", "LEVEL", "GENDER", "ABILITY", "IV_HP", "IV_ATK", "IV_DEF",
+        "IV_SPATK", "IV_SPDEF", "IV_SPEED", "NICKNAME", "ITEM", "POKERUS", "EGG_DAY", "EGG_MONTH",
+        "EGG_YEAR", "MET_DAY", "MET_MONTH", "MET_YEAR", "FORM", "EV_HP", "EV_ATK", "EV_DEF",
+        "EV_SPATK", "EV_SPDEF", "EV_SPEED", "SPECIES", "PID", "NATURE", "FATEFUL", "PP", "PP_UPS",
+        "EGG", "NICKNAMED", "EGG_LOCATION", "MET_LEVEL", "OT_GENDER", "ORIGINAL_GAME"};
+    static_assert(sizeof(fieldNames) / sizeof(fieldNames[0]) == ORIGINAL_GAME + 1);
 
-    // Slight overhead from constructing and deconstructing the unique_ptr, but avoids a logic
-    // repetition
-    pksm::PKX* pkm = getPokemon(data, gen, false).release();
+    // A PKX kept decoded between script calls. For every generation but three it works directly
+    // on the script's buffer; generation three works on a copy that is written back after changes
+    struct PkxHandle
+    {
+        u8* data;
+        std::unique_ptr<pksm::PKX> pkm;
+    };
+    // Handles of the running script, so that ones it never closes are freed when it ends
+    std::unordered_map<PkxHandle*, std::unique_ptr<PkxHandle>> openHandles;
 
-    switch (field)
+    // How many arguments a field takes after the field itself, or -1 if there is no such field
+    int fieldArgs(PKX_FIELD field, bool set)
     {
-        case OT_NAME:
-            if (NumArgs != 4)
-            {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for OT_NAME", NumArgs);
-            }
-            pkm->otName((char*)nextArg->Val->Pointer);
-            break;
-        case TID:
-            if (NumArgs != 4)
-            {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for TID", NumArgs);
-            }
-            pkm->TID(nextArg->Val->Integer);
-            break;
-        case SID:
-            if (NumArgs != 4)
-            {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for SID", NumArgs);
-            }
-            pkm->SID(nextArg->Val->Integer);
-            break;
-        case SHINY:
-            if (NumArgs != 4)
-            {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for SHINY", NumArgs);
-            }
-            pkm->shiny((bool)nextArg->Val->Integer);
-            break;
-        case LANGUAGE:
-            if (NumArgs != 4)
-            {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for LANGUAGE", NumArgs);
-            }
-            pkm->language(
-                getSafeLanguage(pkm->generation(), pksm::Language(nextArg->Val->Integer)));
-            break;
-        case MET_LOCATION:
-            if (NumArgs != 4)
-            {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for MET_LOCATION", NumArgs);
-            }
-            pkm->metLocation(nextArg->Val->Integer);
-            break;
-        case MOVE:
-            if (NumArgs != 5)
-            {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for MOVE", NumArgs);
-            }
-            pkm->move(nextArg->Val->Integer, pksm::Move{u16(getNextVarArg(nextArg)->Val->Integer)});
-            break;
-        case BALL:
-            if (NumArgs != 4)
-            {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for BALL", NumArgs);
-            }
-            pkm->ball(pksm::Ball{u8(nextArg->Val->Integer)});
-            break;
-        case LEVEL:
-            if (NumArgs != 4)
-            {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for LEVEL", NumArgs);
-            }
-            pkm->level(nextArg->Val->Integer);
-            break;
-        case GENDER:
-            if (NumArgs != 4)
-            {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for GENDER", NumArgs);
-            }
-            pkm->gender(pksm::Gender{u8(nextArg->Val->Integer)});
-            break;
-        case ABILITY:
-            if (NumArgs != 4)
-            {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for ABILITY", NumArgs);
-            }
-            pkm->ability(pksm::Ability{u8(nextArg->Val->Integer)});
-            break;
-        case IV_HP:
-            if (NumArgs != 4)
-            {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for IV_HP", NumArgs);
-            }
-            pkm->iv(pksm::Stat::HP, nextArg->Val->Integer);
-            break;
-        case IV_ATK:
-            if (NumArgs != 4)
-            {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for IV_ATK", NumArgs);
-            }
-            pkm->iv(pksm::Stat::ATK, nextArg->Val->Integer);
-            break;
-        case IV_DEF:
-            if (NumArgs != 4)
-            {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for IV_DEF", NumArgs);
-            }
-            pkm->iv(pksm::Stat::DEF, nextArg->Val->Integer);
-            break;
-        case IV_SPATK:
-            if (NumArgs != 4)
-            {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for IV_SPATK", NumArgs);
-            }
-            pkm->iv(pksm::Stat::SPATK, nextArg->Val->Integer);
-            break;
-        case IV_SPDEF:
-            if (NumArgs != 4)
-            {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for IV_SPDEF", NumArgs);
-            }
-            pkm->iv(pksm::Stat::SPDEF, nextArg->Val->Integer);
-            break;
-        case IV_SPEED:
-            if (NumArgs != 4)
-            {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for IV_SPEED", NumArgs);
-            }
-            pkm->iv(pksm::Stat::SPD, nextArg->Val->Integer);
-            break;
-        case NICKNAME:
-            if (NumArgs != 4)
-            {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for NICKNAME", NumArgs);
-            }
-            pkm->nickname((char*)nextArg->Val->Pointer);
-            break;
-        case ITEM:
-            if (NumArgs != 4)
-            {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for ITEM", NumArgs);
-            }
-            pkm->heldItem(nextArg->Val->Integer);
-            break;
-        case POKERUS:
-            if (NumArgs != 5)
-            {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for POKERUS", NumArgs);
-            }
-            pkm->pkrsStrain(nextArg->Val->Integer);
-            pkm->pkrsDays(getNextVarArg(nextArg)->Val->Integer);
-            break;
-        case EGG_DAY:
-            if (NumArgs != 4)
-            {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for EGG_DAY", NumArgs);
-            }
-            {
-                Date date = pkm->eggDate();
-                date.day((u8)nextArg->Val->Integer);
-                pkm->eggDate(date);
-            }
-            break;
-        case EGG_MONTH:
-            if (NumArgs != 4)
-            {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for EGG_MONTH", NumArgs);
-            }
-            {
-                Date date = pkm->eggDate();
-                date.month((u8)nextArg->Val->Integer);
-                pkm->eggDate(date);
-            }
-            break;
-        case EGG_YEAR:
-            if (NumArgs != 4)
-            {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for EGG_YEAR", NumArgs);
-            }
-            {
-                Date date = pkm->eggDate();
-                date.year((u32)nextArg->Val->Integer);
-                pkm->eggDate(date);
-            }
-            break;
-        case MET_DAY:
-            if (NumArgs != 4)
-            {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for MET_DAY", NumArgs);
-            }
-            {
-                Date date = pkm->eggDate();
-                date.day((u8)nextArg->Val->Integer);
-                pkm->eggDate(date);
-            }
-            break;
-        case MET_MONTH:
-            if (NumArgs != 4)
-            {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for MET_MONTH", NumArgs);
-            }
-            {
-                Date date = pkm->eggDate();
-                date.month((u8)nextArg->Val->Integer);
-                pkm->eggDate(date);
-            }
-            break;
-        case MET_YEAR:
-            if (NumArgs != 4)
-            {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for MET_YEAR", NumArgs);
-            }
-            {
-                Date date = pkm->eggDate();
-                date.year((u32)nextArg->Val->Integer);
-                pkm->eggDate(date);
-            }
-            break;
-        case FORM:
-            if (NumArgs != 4)
-            {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for FORM", NumArgs);
-            }
-            pkm->alternativeForm(nextArg->Val->Integer);
-            break;
-        case EV_HP:
-            if (NumArgs != 4)
-            {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for EV_HP", NumArgs);
-            }
-            pkm->ev(pksm::Stat::HP, nextArg->Val->Integer);
-            break;
-        case EV_ATK:
-            if (NumArgs != 4)
-            {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for EV_ATK", NumArgs);
-            }
-            pkm->ev(pksm::Stat::ATK, nextArg->Val->Integer);
-            break;
-        case EV_DEF:
-            if (NumArgs != 4)
-            {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for EV_DEF", NumArgs);
-            }
-            pkm->ev(pksm::Stat::DEF, nextArg->Val->Integer);
-            break;
-        case EV_SPATK:
-            if (NumArgs != 4)
-            {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for EV_SPATK", NumArgs);
-            }
-            pkm->ev(pksm::Stat::SPATK, nextArg->Val->Integer);
-            break;
-        case EV_SPDEF:
-            if (NumArgs != 4)
-            {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for EV_SPDEF", NumArgs);
-            }
-            pkm->ev(pksm::Stat::SPDEF, nextArg->Val->Integer);
-            break;
-        case EV_SPEED:
-            if (NumArgs != 4)
-            {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for EV_SPEED", NumArgs);
-            }
-            pkm->ev(pksm::Stat::SPD, nextArg->Val->Integer);
-            break;
-        case SPECIES:
-            if (NumArgs != 4)
-            {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for SPECIES", NumArgs);
-            }
-            pkm->species(pksm::Species{u16(nextArg->Val->Integer)});
-            break;
-        case PID:
-            if (NumArgs != 4)
-            {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for PID", NumArgs);
-            }
-            pkm->PID(nextArg->Val->Integer);
-            break;
-        case NATURE:
-            if (NumArgs != 4)
-            {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for NATURE", NumArgs);
-            }
-            pkm->nature(pksm::Nature{u8(nextArg->Val->Integer)});
-            break;
-        case FATEFUL:
-            if (NumArgs != 4)
+        switch (field)
+        {
+            case MOVE:
+            case PP:
+            case PP_UPS:
+                return set ? 2 : 1;
+            case POKERUS:
+                return set ? 2 : 0;
+            default:
+                if (field < OT_NAME || field > ORIGINAL_GAME)
+                {
+                    return -1;
+                }
+                return set ? 1 : 0;
+        }
+    }
+
+    bool isStringField(PKX_FIELD field) { return field == OT_NAME || field == NICKNAME; }
+
+    // Fails the script if field doesn't exist or isn't given exactly the arguments it needs.
+    // Meant to be called before anything is allocated, since failing never returns
+    void checkField(
+        struct ParseState* Parser, PKX_FIELD field, bool set, int NumArgs, int leadingArgs)
+    {
+        int args = fieldArgs(field, set);
+        if (args < 0)
+        {
+            scriptFail(Parser, "Field number %i is invalid", (int)field);
+        }
+        if (NumArgs != leadingArgs + args)
+        {
+            scriptFail(Parser, "Incorrect number of args (%i) for %s", NumArgs, fieldNames[field]);
+        }
+    }
+
+    // Checks fields for the batched functions, which only handle numeric fields
+    void checkBatchFields(
+        struct ParseState* Parser, const PKX_FIELD* fields, int count, const int* args, bool set)
+    {
+        for (int i = 0; i < count; i++)
+        {
+            int fieldArgCount = fieldArgs(fields[i], set);
+            if (fieldArgCount < 0)
             {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for FATEFUL", NumArgs);
+                scriptFail(Parser, "Field number %i is invalid", (int)fields[i]);
             }
-            pkm->fatefulEncounter((bool)nextArg->Val->Integer);
-            break;
-        case PP:
-            if (NumArgs != 5)
+            if (isStringField(fields[i]))
             {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for PP", NumArgs);
+                scriptFail(Parser, "%s cannot be used in a batch", fieldNames[fields[i]]);
             }
-            pkm->PP(nextArg->Val->Integer, getNextVarArg(nextArg)->Val->Integer);
-            break;
-        case PP_UPS:
-            if (NumArgs != 5)
+            if (!args && fieldArgCount == (set ? 2 : 1))
             {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for PP_UPS", NumArgs);
+                scriptFail(Parser, "%s needs an argument", fieldNames[fields[i]]);
             }
-            pkm->PPUp(nextArg->Val->Integer, getNextVarArg(nextArg)->Val->Integer);
-            break;
-        case EGG:
-            if (NumArgs != 4)
+        }
+    }
+
+    PkxHandle* getHandle(struct ParseState* Parser, struct Value* arg)
+    {
+        PkxHandle* handle = (PkxHandle*)arg->Val->Pointer;
+        if (!handle)
+        {
+            scriptFail(Parser, "PKX handle is NULL");
+        }
+        if (!openHandles.contains(handle))
+        {
+            scriptFail(Parser, "PKX handle is not open");
+        }
+        return handle;
+    }
+
+    void syncHandle(PkxHandle& handle)
+    {
+        if (handle.pkm->generation() == pksm::Generation::THREE)
+        {
+            std::copy(handle.pkm->rawData(), handle.pkm->rawData() + handle.pkm->getLength(),
+                handle.data);
+        }
+    }
+
+    // index is the move slot for MOVE, PP, and PP_UPS, and is otherwise ignored
+    u32 getPkxValue(const pksm::PKX& pkm, PKX_FIELD field, int index)
+    {
+        switch (field)
+        {
+            case TID:
+                return pkm.TID();
+            case SID:
+                return pkm.SID();
+            case SHINY:
+                return pkm.shiny();
+            case LANGUAGE:
+                return u8(pkm.language());
+            case MET_LOCATION:
+                return pkm.metLocation();
+            case MOVE:
+                return u16(pkm.move(index));
+            case BALL:
+                return u8(pkm.ball());
+            case LEVEL:
+                return pkm.level();
+            case GENDER:
+                return u8(pkm.gender());
+            case ABILITY:
+                return u16(pkm.ability());
+            case IV_HP:
+                return pkm.iv(pksm::Stat::HP);
+            case IV_ATK:
+                return pkm.iv(pksm::Stat::ATK);
+            case IV_DEF:
+                return pkm.iv(pksm::Stat::DEF);
+            case IV_SPATK:
+                return pkm.iv(pksm::Stat::SPATK);
+            case IV_SPDEF:
+                return pkm.iv(pksm::Stat::SPDEF);
+            case IV_SPEED:
+                return pkm.iv(pksm::Stat::SPD);
+            case ITEM:
+                return pkm.heldItem();
+            case POKERUS:
+                return pkm.pkrs();
+            case EGG_DAY:
+                return pkm.eggDate().day();
+            case EGG_MONTH:
+                return pkm.eggDate().month();
+            case EGG_YEAR:
+                return pkm.eggDate().year();
+            case MET_DAY:
+                return pkm.metDate().day();
+            case MET_MONTH:
+                return pkm.metDate().month();
+            case MET_YEAR:
+                return pkm.metDate().year();
+            case FORM:
+                return pkm.alternativeForm();
+            case EV_HP:
+                return pkm.ev(pksm::Stat::HP);
+            case EV_ATK:
+                return pkm.ev(pksm::Stat::ATK);
+            case EV_DEF:
+                return pkm.ev(pksm::Stat::DEF);
+            case EV_SPATK:
+                return pkm.ev(pksm::Stat::SPATK);
+            case EV_SPDEF:
+                return pkm.ev(pksm::Stat::SPDEF);
+            case EV_SPEED:
+                return pkm.ev(pksm::Stat::SPD);
+            case SPECIES:
+                return u16(pkm.species());
+            case PID:
+                return pkm.PID();
+            case NATURE:
+                return u8(pkm.nature());
+            case FATEFUL:
+                return pkm.fatefulEncounter();
+            case PP:
+                return pkm.PP(index);
+            case PP_UPS:
+                return pkm.PPUp(index);
+            case EGG:
+                return pkm.egg();
+            case NICKNAMED:
+                return pkm.nicknamed();
+            case EGG_LOCATION:
+                return pkm.eggLocation();
+            case MET_LEVEL:
+                return pkm.metLevel();
+            case OT_GENDER:
+                return u8(pkm.otGender());
+            case ORIGINAL_GAME:
+                return u8(pkm.version());
+            case OT_NAME:
+            case NICKNAME:
+                break;
+        }
+        return 0;
+    }
+
+    // index is the move slot for MOVE, PP, and PP_UPS, the strain for POKERUS (whose value is
+    // then the number of days), and is otherwise ignored
+    void setPkxValue(pksm::PKX& pkm, PKX_FIELD field, int index, int value)
+    {
+        switch (field)
+        {
+            case TID:
+                pkm.TID(value);
+                break;
+            case SID:
+                pkm.SID(value);
+                break;
+            case SHINY:
+                pkm.shiny((bool)value);
+                break;
+            case LANGUAGE:
+                pkm.language(getSafeLanguage(pkm.generation(), pksm::Language(value)));
+                break;
+            case MET_LOCATION:
+                pkm.metLocation(value);
+                break;
+            case MOVE:
+                pkm.move(index, pksm::Move{u16(value)});
+                break;
+            case BALL:
+                pkm.ball(pksm::Ball{u8(value)});
+                break;
+            case LEVEL:
+                pkm.level(value);
+                break;
+            case GENDER:
+                pkm.gender(pksm::Gender{u8(value)});
+                break;
+            case ABILITY:
+                pkm.ability(pksm::Ability{u8(value)});
+                break;
+            case IV_HP:
+                pkm.iv(pksm::Stat::HP, value);
+                break;
+            case IV_ATK:
+                pkm.iv(pksm::Stat::ATK, value);
+                break;
+            case IV_DEF:
+                pkm.iv(pksm::Stat::DEF, value);
+                break;
+            case IV_SPATK:
+                pkm.iv(pksm::Stat::SPATK, value);
+                break;
+            case IV_SPDEF:
+                pkm.iv(pksm::Stat::SPDEF, value);
+                break;
+            case IV_SPEED:
+                pkm.iv(pksm::Stat::SPD, value);
+                break;
+            case ITEM:
+                pkm.heldItem(value);
+                break;
+            case POKERUS:
+                pkm.pkrsStrain(index);
+                pkm.pkrsDays(value);
+                break;
+            case EGG_DAY:
             {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for EGG", NumArgs);
+                Date date = pkm.eggDate();
+                date.day((u8)value);
+                pkm.eggDate(date);
             }
-            pkm->egg((bool)nextArg->Val->Integer);
             break;
-        case NICKNAMED:
-            if (NumArgs != 4)
+            case EGG_MONTH:
             {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for NICKNAMED", NumArgs);
+                Date date = pkm.eggDate();
+                date.month((u8)value);
+                pkm.eggDate(date);
             }
-            pkm->nicknamed((bool)nextArg->Val->Integer);
             break;
-        case EGG_LOCATION:
-            if (NumArgs != 4)
+            case EGG_YEAR:
             {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for EGG_LOCATION", NumArgs);
+                Date date = pkm.eggDate();
+                date.year((u32)value);
+                pkm.eggDate(date);
             }
-            pkm->eggLocation(nextArg->Val->Integer);
             break;
-        case MET_LEVEL:
-            if (NumArgs != 4)
+            case MET_DAY:
             {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for MET_LEVEL", NumArgs);
+                Date date = pkm.metDate();
+                date.day((u8)value);
+                pkm.metDate(date);
             }
-            pkm->metLevel(nextArg->Val->Integer);
             break;
-        case OT_GENDER:
-            if (NumArgs != 4)
+            case MET_MONTH:
             {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for OT_GENDER", NumArgs);
+                Date date = pkm.metDate();
+                date.month((u8)value);
+                pkm.metDate(date);
             }
-            pkm->otGender(pksm::Gender{u8(nextArg->Val->Integer)});
             break;
-        case ORIGINAL_GAME:
-            if (NumArgs != 4)
+            case MET_YEAR:
             {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for ORIGINAL_GAME", NumArgs);
+                Date date = pkm.metDate();
+                date.year((u32)value);
+                pkm.metDate(date);
             }
-            pkm->version(pksm::GameVersion(nextArg->Val->Integer));
             break;
-        default:
-            delete pkm;
-            scriptFail(Parser, "Field number %i is invalid", (int)field);
+            case FORM:
+                pkm.alternativeForm(value);
+                break;
+            case EV_HP:
+                pkm.ev(pksm::Stat::HP, value);
+                break;
+            case EV_ATK:
+                pkm.ev(pksm::Stat::ATK, value);
+                break;
+            case EV_DEF:
+                pkm.ev(pksm::Stat::DEF, value);
+                break;
+            case EV_SPATK:
+                pkm.ev(pksm::Stat::SPATK, value);
+                break;
+            case EV_SPDEF:
+                pkm.ev(pksm::Stat::SPDEF, value);
+                break;
+            case EV_SPEED:
+                pkm.ev(pksm::Stat::SPD, value);
+                break;
+            case SPECIES:
+                pkm.species(pksm::Species{u16(value)});
+                break;
+            case PID:
+                pkm.PID(value);
+                break;
+            case NATURE:
+                pkm.nature(pksm::Nature{u8(value)});
+                break;
+            case FATEFUL:
+                pkm.fatefulEncounter((bool)value);
+                break;
+            case PP:
+                pkm.PP(index, value);
+                break;
+            case PP_UPS:
+                pkm.PPUp(index, value);
+                break;
+            case EGG:
+                pkm.egg((bool)value);
+                break;
+            case NICKNAMED:
+                pkm.nicknamed((bool)value);
+                break;
+            case EGG_LOCATION:
+                pkm.eggLocation(value);
+                break;
+            case MET_LEVEL:
+                pkm.metLevel(value);
+                break;
+            case OT_GENDER:
+                pkm.otGender(pksm::Gender{u8(value)});
+                break;
+            case ORIGINAL_GAME:
+                pkm.version(pksm::GameVersion(value));
+                break;
+            case OT_NAME:
+            case NICKNAME:
+                break;
+        }
     }
-    if (gen == pksm::Generation::THREE)
+
+    // Both take the variadic arguments following the field, which checkField has already counted
+    void getPkxField(pksm::PKX& pkm, PKX_FIELD field, struct Value* arg, struct Value* ReturnValue)
     {
-        std::copy(pkm->rawData(), pkm->rawData() + pkm->getLength(), data);
+        switch (field)
+        {
+            case OT_NAME:
+                ReturnValue->Val->Pointer = strToRet(pkm.otName());
+                break;
+            case NICKNAME:
+                ReturnValue->Val->Pointer = strToRet(pkm.nickname());
+                break;
+            default:
+                ReturnValue->Val->UnsignedInteger =
+                    getPkxValue(pkm, field, fieldArgs(field, false) == 1 ? arg->Val->Integer : 0);
+                break;
+        }
     }
-    delete pkm;
-}
-
-void pkx_get_value(
-    struct ParseState* Parser, struct Value* ReturnValue, struct Value** Param, int NumArgs)
-{
-    u8* data              = (u8*)Param[0]->Val->Pointer;
-    pksm::Generation gen  = pksm::Generation(Param[1]->Val->Integer);
-    PKX_FIELD field       = PKX_FIELD(Param[2]->Val->Integer);
-    struct Value* nextArg = getNextVarArg(Param[2]);
-    checkGen(Parser, gen);
 
-    pksm::PKX* pkm = getPokemon(data, gen, false).release();
+    void setPkxField(pksm::PKX& pkm, PKX_FIELD field, struct Value* arg)
+    {
+        switch (field)
+        {
+            case OT_NAME:
+                pkm.otName((char*)arg->Val->Pointer);
+                break;
+            case NICKNAME:
+                pkm.nickname((char*)arg->Val->Pointer);
+                break;
+            default:
+                if (fieldArgs(field, true) == 2)
+                {
+                    setPkxValue(pkm, field, arg->Val->Integer, getNextVarArg(arg)->Val->Integer);
+                }
+                else
+                {
+                    setPkxValue(pkm, field, 0, arg->Val->Integer);
+                }
+                break;
+        }
+    }
 
-    switch (field)
+    bool pkxMatches(const pksm::PKX& pkm, int count, const PKX_FIELD* fields, const int* args,
+        const unsigned int* values)
     {
-        case OT_NAME:
-            if (NumArgs != 3)
-            {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for OT_NAME", NumArgs);
-            }
-            ReturnValue->Val->Pointer = strToRet(pkm->otName());
-            break;
-        case TID:
-            if (NumArgs != 3)
+        for (int i = 0; i < count; i++)
+        {
+            if (getPkxValue(pkm, fields[i], args ? args[i] : 0) != values[i])
             {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for TID", NumArgs);
+                return false;
             }
-            ReturnValue->Val->UnsignedInteger = pkm->TID();
-            break;
-        case SID:
-            if (NumArgs != 3)
-            {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for SID", NumArgs);
-            }
-            ReturnValue->Val->UnsignedInteger = pkm->SID();
-            break;
-        case SHINY:
-            if (NumArgs != 3)
-            {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for SHINY", NumArgs);
-            }
-            ReturnValue->Val->UnsignedInteger = pkm->shiny();
-            break;
-        case LANGUAGE:
-            if (NumArgs != 3)
-            {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for LANGUAGE", NumArgs);
-            }
-            ReturnValue->Val->UnsignedInteger = u8(pkm->language());
-            break;
-        case MET_LOCATION:
-            if (NumArgs != 3)
-            {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for MET_LOCATION", NumArgs);
-            }
-            ReturnValue->Val->UnsignedInteger = pkm->metLocation();
-            break;
-        case MOVE:
-            if (NumArgs != 4)
-            {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for MOVE", NumArgs);
-            }
-            ReturnValue->Val->UnsignedInteger = u16(pkm->move(nextArg->Val->Integer));
-            break;
-        case BALL:
-            if (NumArgs != 3)
-            {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for BALL", NumArgs);
-            }
-            ReturnValue->Val->UnsignedInteger = u8(pkm->ball());
-            break;
-        case LEVEL:
-            if (NumArgs != 3)
-            {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for LEVEL", NumArgs);
-            }
-            ReturnValue->Val->UnsignedInteger = pkm->level();
-            break;
-        case GENDER:
-            if (NumArgs != 3)
-            {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for GENDER", NumArgs);
-            }
-            ReturnValue->Val->UnsignedInteger = u8(pkm->gender());
-            break;
-        case ABILITY:
-            if (NumArgs != 3)
-            {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for ABILITY", NumArgs);
-            }
-            ReturnValue->Val->UnsignedInteger = u16(pkm->ability());
-            break;
-        case IV_HP:
-            if (NumArgs != 3)
-            {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for IV_HP", NumArgs);
-            }
-            ReturnValue->Val->UnsignedInteger = pkm->iv(pksm::Stat::HP);
-            break;
-        case IV_ATK:
-            if (NumArgs != 3)
-            {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for IV_ATK", NumArgs);
-            }
-            ReturnValue->Val->UnsignedInteger = pkm->iv(pksm::Stat::ATK);
-            break;
-        case IV_DEF:
-            if (NumArgs != 3)
-            {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for IV_DEF", NumArgs);
-            }
-            ReturnValue->Val->UnsignedInteger = pkm->iv(pksm::Stat::DEF);
-            break;
-        case IV_SPATK:
-            if (NumArgs != 3)
-            {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for IV_SPATK", NumArgs);
-            }
-            ReturnValue->Val->UnsignedInteger = pkm->iv(pksm::Stat::SPATK);
-            break;
-        case IV_SPDEF:
-            if (NumArgs != 3)
-            {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for IV_SPDEF", NumArgs);
-            }
-            ReturnValue->Val->UnsignedInteger = pkm->iv(pksm::Stat::SPDEF);
-            break;
-        case IV_SPEED:
-            if (NumArgs != 3)
-            {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for IV_SPEED", NumArgs);
-            }
-            ReturnValue->Val->UnsignedInteger = pkm->iv(pksm::Stat::SPD);
-            break;
-        case NICKNAME:
-            if (NumArgs != 3)
-            {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for NICKNAME", NumArgs);
-            }
-            ReturnValue->Val->Pointer = strToRet(pkm->nickname());
-            break;
-        case ITEM:
-            if (NumArgs != 3)
-            {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for ITEM", NumArgs);
-            }
-            ReturnValue->Val->UnsignedInteger = pkm->heldItem();
-            break;
-        case POKERUS:
-            if (NumArgs != 3)
-            {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for POKERUS", NumArgs);
-            }
-            ReturnValue->Val->UnsignedInteger = pkm->pkrs();
-            break;
-        case EGG_DAY:
-            if (NumArgs != 3)
-            {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for EGG_DAY", NumArgs);
-            }
-            ReturnValue->Val->UnsignedInteger = pkm->eggDate().day();
-            break;
-        case EGG_MONTH:
-            if (NumArgs != 3)
-            {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for EGG_MONTH", NumArgs);
-            }
-            ReturnValue->Val->UnsignedInteger = pkm->eggDate().month();
-            break;
-        case EGG_YEAR:
-            if (NumArgs != 3)
-            {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for EGG_YEAR", NumArgs);
-            }
-            ReturnValue->Val->UnsignedInteger = pkm->eggDate().year();
-            break;
-        case MET_DAY:
-            if (NumArgs != 3)
-            {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for MET_DAY", NumArgs);
-            }
-            ReturnValue->Val->UnsignedInteger = pkm->metDate().day();
-            break;
-        case MET_MONTH:
-            if (NumArgs != 3)
-            {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for MET_MONTH", NumArgs);
-            }
-            ReturnValue->Val->UnsignedInteger = pkm->metDate().month();
-            break;
-        case MET_YEAR:
-            if (NumArgs != 3)
-            {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for MET_YEAR", NumArgs);
-            }
-            ReturnValue->Val->UnsignedInteger = pkm->metDate().year();
-            break;
-        case FORM:
-            if (NumArgs != 3)
-            {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for FORM", NumArgs);
-            }
-            ReturnValue->Val->UnsignedInteger = pkm->alternativeForm();
-            break;
-        case EV_HP:
-            if (NumArgs != 3)
-            {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for EV_HP", NumArgs);
-            }
-            ReturnValue->Val->Integer = pkm->ev(pksm::Stat::HP);
-            break;
-        case EV_ATK:
-            if (NumArgs != 3)
-            {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for EV_ATK", NumArgs);
-            }
-            ReturnValue->Val->Integer = pkm->ev(pksm::Stat::ATK);
-            break;
-        case EV_DEF:
-            if (NumArgs != 3)
-            {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for EV_DEF", NumArgs);
-            }
-            ReturnValue->Val->Integer = pkm->ev(pksm::Stat::DEF);
-            break;
-        case EV_SPATK:
-            if (NumArgs != 3)
-            {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for EV_SPATK", NumArgs);
-            }
-            ReturnValue->Val->Integer = pkm->ev(pksm::Stat::SPATK);
-            break;
-        case EV_SPDEF:
-            if (NumArgs != 3)
-            {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for EV_SPDEF", NumArgs);
-            }
-            ReturnValue->Val->Integer = pkm->ev(pksm::Stat::SPDEF);
-            break;
-        case EV_SPEED:
-            if (NumArgs != 3)
-            {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for EV_SPEED", NumArgs);
-            }
-            ReturnValue->Val->Integer = pkm->ev(pksm::Stat::SPD);
-            break;
-        case SPECIES:
-            if (NumArgs != 3)
-            {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for SPECIES", NumArgs);
-            }
-            ReturnValue->Val->Integer = u16(pkm->species());
-            break;
-        case PID:
-            if (NumArgs != 3)
-            {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for PID", NumArgs);
-            }
-            ReturnValue->Val->Integer = pkm->PID();
-            break;
-        case NATURE:
-            if (NumArgs != 3)
-            {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for NATURE", NumArgs);
-            }
-            ReturnValue->Val->Integer = u8(pkm->nature());
-            break;
-        case FATEFUL:
-            if (NumArgs != 3)
-            {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for FATEFUL", NumArgs);
-            }
-            ReturnValue->Val->Integer = pkm->fatefulEncounter();
-            break;
-        case PP:
-            if (NumArgs != 4)
-            {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for PP", NumArgs);
-            }
-            ReturnValue->Val->Integer = pkm->PP(nextArg->Val->Integer);
-            break;
-        case PP_UPS:
-            if (NumArgs != 4)
-            {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for PP_UPS", NumArgs);
-            }
-            ReturnValue->Val->Integer = pkm->PPUp(nextArg->Val->Integer);
-            break;
-        case EGG:
-            if (NumArgs != 3)
-            {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for EGG", NumArgs);
-            }
-            ReturnValue->Val->Integer = pkm->egg();
-            break;
-        case NICKNAMED:
-            if (NumArgs != 3)
-            {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for NICKNAMED", NumArgs);
-            }
-            ReturnValue->Val->Integer = pkm->nicknamed();
-            break;
-        case EGG_LOCATION:
-            if (NumArgs != 3)
-            {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for EGG_LOCATION", NumArgs);
-            }
-            ReturnValue->Val->Integer = pkm->eggLocation();
-            break;
-        case MET_LEVEL:
-            if (NumArgs != 3)
+        }
+        return true;
+    }
+
+    void checkBoxRange(struct ParseState* Parser, int firstBox, int lastBox, int boxes)
+    {
+        if (firstBox < 0 || lastBox < firstBox || lastBox >= boxes)
+        {
+            scriptFail(Parser, "Invalid box range %i-%i: Max box is %i", firstBox, lastBox,
+                boxes - 1);
+        }
+    }
+
+    // Visits every occupied save box slot from firstBox through lastBox
+    template <typename Func>
+    void forEachSavPkm(int firstBox, int lastBox, Func func)
+    {
+        for (int box = firstBox; box <= lastBox; box++)
+        {
+            for (int slot = 0; slot < 30; slot++)
             {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for MET_LEVEL", NumArgs);
+                auto pkm = TitleLoader::save->pkm(box, slot);
+                if (pkm->species() != pksm::Species::None)
+                {
+                    func(*pkm, box, slot);
+                }
             }
-            ReturnValue->Val->Integer = pkm->metLevel();
-            break;
-        case OT_GENDER:
-            if (NumArgs != 3)
+        }
+    }
+}
+
+extern "C" {
+void pkx_set_value(
+    struct ParseState* Parser, struct Value* ReturnValue, struct Value** Param, int NumArgs)
+{
+    u8* data             = (u8*)Param[0]->Val->Pointer;
+    pksm::Generation gen = pksm::Generation(Param[1]->Val->Integer);
+    PKX_FIELD field      = PKX_FIELD(Param[2]->Val->Integer);
+    checkGen(Parser, gen);
+    checkField(Parser, field, true, NumArgs, 3);
+
+    auto pkm = getPokemon(data, gen, false);
+
+    setPkxField(*pkm, field, getNextVarArg(Param[2]));
+
+    if (gen == pksm::Generation::THREE)
+    {
+        std::copy(pkm->rawData(), pkm->rawData() + pkm->getLength(), data);
+    }
+}
+
+void pkx_get_value(
+    struct ParseState* Parser, struct Value* ReturnValue, struct Value** Param, int NumArgs)
+{
+    u8* data             = (u8*)Param[0]->Val->Pointer;
+    pksm::Generation gen = pksm::Generation(Param[1]->Val->Integer);
+    PKX_FIELD field      = PKX_FIELD(Param[2]->Val->Integer);
+    checkGen(Parser, gen);
+    checkField(Parser, field, false, NumArgs, 3);
+
+    auto pkm = getPokemon(data, gen, false);
+
+    getPkxField(*pkm, field, getNextVarArg(Param[2]), ReturnValue);
+}
+
+// struct PKXHandle* pkx_open(char* data, enum Generation gen);
+void pkx_open(
+    struct ParseState* Parser, struct Value* ReturnValue, struct Value** Param, int NumArgs)
+{
+    u8* data             = (u8*)Param[0]->Val->Pointer;
+    pksm::Generation gen = pksm::Generation(Param[1]->Val->Integer);
+    checkGen(Parser, gen);
+
+    PkxHandle* handle = new PkxHandle{data, getPokemon(data, gen, false)};
+    openHandles.emplace(handle, std::unique_ptr<PkxHandle>(handle));
+    ReturnValue->Val->Pointer = (void*)handle;
+}
+
+// void pkx_close(struct PKXHandle* pkx);
+void pkx_close(
+    struct ParseState* Parser, struct Value* ReturnValue, struct Value** Param, int NumArgs)
+{
+    auto found = openHandles.find((PkxHandle*)Param[0]->Val->Pointer);
+    if (found != openHandles.end())
+    {
+        syncHandle(*found->second);
+        openHandles.erase(found);
+    }
+}
+
+void pksm_api_cleanup(void)
+{
+    // The script's buffers may already be gone, so unclosed handles aren't synced back
+    openHandles.clear();
+}
+
+// unsigned int pkx_handle_get_value(struct PKXHandle* pkx, enum PKX_Field field, ...);
+void pkx_handle_get_value(
+    struct ParseState* Parser, struct Value* ReturnValue, struct Value** Param, int NumArgs)
+{
+    PkxHandle* handle = getHandle(Parser, Param[0]);
+    PKX_FIELD field   = PKX_FIELD(Param[1]->Val->Integer);
+    checkField(Parser, field, false, NumArgs, 2);
+
+    getPkxField(*handle->pkm, field, getNextVarArg(Param[1]), ReturnValue);
+}
+
+// void pkx_handle_set_value(struct PKXHandle* pkx, enum PKX_Field field, ...);
+void pkx_handle_set_value(
+    struct ParseState* Parser, struct Value* ReturnValue, struct Value** Param, int NumArgs)
+{
+    PkxHandle* handle = getHandle(Parser, Param[0]);
+    PKX_FIELD field   = PKX_FIELD(Param[1]->Val->Integer);
+    checkField(Parser, field, true, NumArgs, 2);
+
+    setPkxField(*handle->pkm, field, getNextVarArg(Param[1]));
+    syncHandle(*handle);
+}
+
+// void pkx_get_values(struct PKXHandle* pkx, int count, enum PKX_Field* fields, int* args,
+//     unsigned int* out);
+void pkx_get_values(
+    struct ParseState* Parser, struct Value* ReturnValue, struct Value** Param, int NumArgs)
+{
+    PkxHandle* handle       = getHandle(Parser, Param[0]);
+    int count               = Param[1]->Val->Integer;
+    const PKX_FIELD* fields = (PKX_FIELD*)Param[2]->Val->Pointer;
+    const int* args         = (int*)Param[3]->Val->Pointer;
+    unsigned int* out       = (unsigned int*)Param[4]->Val->Pointer;
+    checkBatchFields(Parser, fields, count, args, false);
+
+    for (int i = 0; i < count; i++)
+    {
+        out[i] = getPkxValue(*handle->pkm, fields[i], args ? args[i] : 0);
+    }
+}
+
+// void pkx_set_values(struct PKXHandle* pkx, int count, enum PKX_Field* fields, int* args,
+//     int* values);
+void pkx_set_values(
+    struct ParseState* Parser, struct Value* ReturnValue, struct Value** Param, int NumArgs)
+{
+    PkxHandle* handle       = getHandle(Parser, Param[0]);
+    int count               = Param[1]->Val->Integer;
+    const PKX_FIELD* fields = (PKX_FIELD*)Param[2]->Val->Pointer;
+    const int* args         = (int*)Param[3]->Val->Pointer;
+    const int* values       = (int*)Param[4]->Val->Pointer;
+    checkBatchFields(Parser, fields, count, args, true);
+
+    for (int i = 0; i < count; i++)
+    {
+        setPkxValue(*handle->pkm, fields[i], args ? args[i] : 0, values[i]);
+    }
+    syncHandle(*handle);
+}
+
+// int sav_box_query(int* out, int maxOut, int firstBox, int lastBox, int count,
+//     enum PKX_Field* fields, int* args, unsigned int* values);
+void sav_box_query(
+    struct ParseState* Parser, struct Value* ReturnValue, struct Value** Param, int NumArgs)
+{
+    int* out                   = (int*)Param[0]->Val->Pointer;
+    int maxOut                 = Param[1]->Val->Integer;
+    int firstBox               = Param[2]->Val->Integer;
+    int lastBox                = Param[3]->Val->Integer;
+    int count                  = Param[4]->Val->Integer;
+    const PKX_FIELD* fields    = (PKX_FIELD*)Param[5]->Val->Pointer;
+    const int* args            = (int*)Param[6]->Val->Pointer;
+    const unsigned int* values = (unsigned int*)Param[7]->Val->Pointer;
+    checkBoxRange(Parser, firstBox, lastBox, TitleLoader::save->maxBoxes());
+    checkBatchFields(Parser, fields, count, args, false);
+
+    int found = 0;
+    forEachSavPkm(firstBox, lastBox, [&](const pksm::PKX& pkm, int box, int slot) {
+        if (pkxMatches(pkm, count, fields, args, values))
+        {
+            if (found < maxOut)
             {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for OT_GENDER", NumArgs);
+                out[found] = box * 30 + slot;
             }
-            ReturnValue->Val->Integer = u8(pkm->otGender());
-            break;
-        case ORIGINAL_GAME:
-            if (NumArgs != 3)
+            found++;
+        }
+    });
+    ReturnValue->Val->Integer = found;
+}
+
+// int bank_box_query(int* out, int maxOut, int firstBox, int lastBox, int count,
+//     enum PKX_Field* fields, int* args, unsigned int* values);
+void bank_box_query(
+    struct ParseState* Parser, struct Value* ReturnValue, struct Value** Param, int NumArgs)
+{
+    int* out                   = (int*)Param[0]->Val->Pointer;
+    int maxOut                 = Param[1]->Val->Integer;
+    int firstBox               = Param[2]->Val->Integer;
+    int lastBox                = Param[3]->Val->Integer;
+    int count                  = Param[4]->Val->Integer;
+    const PKX_FIELD* fields    = (PKX_FIELD*)Param[5]->Val->Pointer;
+    const int* args            = (int*)Param[6]->Val->Pointer;
+    const unsigned int* values = (unsigned int*)Param[7]->Val->Pointer;
+    checkBoxRange(Parser, firstBox, lastBox, Banks::bank->boxes());
+    checkBatchFields(Parser, fields, count, args, false);
+
+    int found = 0;
+    Banks::bank->forEachPkm(firstBox, lastBox, [&](const pksm::PKX& pkm, int box, int slot) {
+        if (pkxMatches(pkm, count, fields, args, values))
+        {
+            if (found < maxOut)
             {
-                delete pkm;
-                scriptFail(Parser, "Incorrect number of args (%i) for ORIGINAL_GAME", NumArgs);
+                out[found] = box * 30 + slot;
             }
-            ReturnValue->Val->Integer = u8(pkm->version());
-            break;
-        default:
-            delete pkm;
-            scriptFail(Parser, "Field number %i is invalid", (int)field);
-    }
-    delete pkm;
+            found++;
+        }
+    });
+    ReturnValue->Val->Integer = found;
+}
+
+// void sav_box_values(unsigned int* out, int firstBox, int lastBox, enum PKX_Field field,
+//     int arg);
+void sav_box_values(
+    struct ParseState* Parser, struct Value* ReturnValue, struct Value** Param, int NumArgs)
+{
+    unsigned int* out = (unsigned int*)Param[0]->Val->Pointer;
+    int firstBox      = Param[1]->Val->Integer;
+    int lastBox       = Param[2]->Val->Integer;
+    PKX_FIELD field   = PKX_FIELD(Param[3]->Val->Integer);
+    int arg           = Param[4]->Val->Integer;
+    checkBoxRange(Parser, firstBox, lastBox, TitleLoader::save->maxBoxes());
+    checkBatchFields(Parser, &field, 1, &arg, false);
+
+    std::fill_n(out, (lastBox - firstBox + 1) * 30, 0);
+    forEachSavPkm(firstBox, lastBox, [&](const pksm::PKX& pkm, int box, int slot) {
+        out[(box - firstBox) * 30 + slot] = getPkxValue(pkm, field, arg);
+    });
+}
+
+// void bank_box_values(unsigned int* out, int firstBox, int lastBox, enum PKX_Field field,
+//     int arg);
+void bank_box_values(
+    struct ParseState* Parser, struct Value* ReturnValue, struct Value** Param, int NumArgs)
+{
+    unsigned int* out = (unsigned int*)Param[0]->Val->Pointer;
+    int firstBox      = Param[1]->Val->Integer;
+    int lastBox       = Param[2]->Val->Integer;
+    PKX_FIELD field   = PKX_FIELD(Param[3]->Val->Integer);
+    int arg           = Param[4]->Val->Integer;
+    checkBoxRange(Parser, firstBox, lastBox, Banks::bank->boxes());
+    checkBatchFields(Parser, &field, 1, &arg, false);
+
+    std::fill_n(out, (lastBox - firstBox + 1) * 30, 0);
+    Banks::bank->forEachPkm(firstBox, lastBox, [&](const pksm::PKX& pkm, int box, int slot) {
+        out[(box - firstBox) * 30 + slot] = getPkxValue(pkm, field, arg);
+    });
 }
 
 void sav_inject_wcx(
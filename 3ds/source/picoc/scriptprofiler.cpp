@@ -0,0 +1,149 @@
+/*
+ *   This file is part of PKSM
+ *   Copyright (C) 2016-2020 Bernardo Giordano, Admiral Fish, piepie62
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#include "scriptprofiler.hpp"
+#include "format.h"
+#include <3ds.h>
+#include <algorithm>
+#include <array>
+#include <utility>
+#include <vector>
+
+extern "C" {
+#include "interpreter.h"
+extern struct LibraryFunction UnixFunctions[];
+}
+#undef min
+
+namespace
+{
+    using Intrinsic = decltype(LibraryFunction::Func);
+
+    // More than the number of functions in pksm.h, which is checked in start
+    constexpr size_t MAX_FUNCTIONS = 192;
+
+    struct FunctionStats
+    {
+        Intrinsic real;
+        u64 calls;
+        u64 ticks;
+    };
+    std::array<FunctionStats, MAX_FUNCTIONS> stats;
+    size_t functionCount = 0;
+    std::vector<std::pair<std::string, u64>> phases;
+    u64 phaseStart = 0;
+
+    template <size_t I>
+    void profiled(
+        struct ParseState* Parser, struct Value* ReturnValue, struct Value** Param, int NumArgs)
+    {
+        u64 start = svcGetSystemTick();
+        stats[I].real(Parser, ReturnValue, Param, NumArgs);
+        // Calls that fail the script never get here, which is fine since it's stopped anyway
+        stats[I].ticks += svcGetSystemTick() - start;
+        stats[I].calls++;
+    }
+
+    template <size_t... Is>
+    constexpr std::array<Intrinsic, sizeof...(Is)> makeTrampolines(std::index_sequence<Is...>)
+    {
+        return {&profiled<Is>...};
+    }
+    constexpr auto trampolines = makeTrampolines(std::make_index_sequence<MAX_FUNCTIONS>{});
+
+    // "unsigned int pkx_get_value(char* data, ...);" -> "pkx_get_value"
+    std::string functionName(const char* prototype)
+    {
+        std::string_view proto = prototype;
+        size_t end             = proto.find('(');
+        size_t begin           = proto.find_last_of(" *", end) + 1;
+        return std::string(proto.substr(begin, end - begin));
+    }
+
+    double ticksToMs(u64 ticks) { return ticks * 1000.0 / SYSCLOCK_ARM11; }
+}
+
+void ScriptProfiler::start()
+{
+    functionCount = 0;
+    while (UnixFunctions[functionCount].Func)
+    {
+        functionCount++;
+    }
+    if (functionCount > MAX_FUNCTIONS)
+    {
+        functionCount = 0;
+        return;
+    }
+
+    for (size_t i = 0; i < functionCount; i++)
+    {
+        stats[i]              = FunctionStats{UnixFunctions[i].Func, 0, 0};
+        UnixFunctions[i].Func = trampolines[i];
+    }
+    phases.clear();
+    phaseStart = svcGetSystemTick();
+}
+
+void ScriptProfiler::phase(const std::string& name)
+{
+    u64 now = svcGetSystemTick();
+    phases.emplace_back(name, now - phaseStart);
+    phaseStart = now;
+}
+
+std::string ScriptProfiler::stop()
+{
+    std::vector<size_t> called;
+    for (size_t i = 0; i < functionCount; i++)
+    {
+        UnixFunctions[i].Func = stats[i].real;
+        if (stats[i].calls > 0)
+        {
+            called.emplace_back(i);
+        }
+    }
+    std::sort(called.begin(), called.end(),
+        [](size_t a, size_t b) { return stats[a].ticks > stats[b].ticks; });
+
+    std::string ret;
+    for (const auto& [name, ticks] : phases)
+    {
+        ret += fmt::format("{}: {:.2f} ms\n", name, ticksToMs(ticks));
+    }
+    if (!ret.empty())
+    {
+        ret += '\n';
+    }
+    for (size_t i : called)
+    {
+        ret += fmt::format("{}: {} calls, {:.2f} ms total, {:.3f} ms each\n",
+            functionName(UnixFunctions[i].Prototype), stats[i].calls, ticksToMs(stats[i].ticks),
+            ticksToMs(stats[i].ticks) / stats[i].calls);
+    }
+    functionCount = 0;
+    return ret;
+}
@@ -28,6 +28,8 @@
 #include "Archive.hpp"
 #include "format.h"
 #include "smdh.hpp"
+#include <array>
+#include <vector>
 
 // Allocate once because threading shenanigans
 namespace
@@ -48,6 +50,20 @@ namespace
         u16 dsiSequence[64];
     };
 
+    // Pixel offset within an 8x8 texture tile, indexed by y * 8 + x
+    constexpr std::array<u8, 64> TILE_ORDER = [] {
+        std::array<u8, 64> ret{};
+        for (size_t y = 0; y < 8; y++)
+        {
+            for (size_t x = 0; x < 8; x++)
+            {
+                ret[y * 8 + x] = (x & 1) | ((y & 1) << 1) | ((x & 2) << 1) | ((y & 2) << 2) |
+                                 ((x & 4) << 2) | ((y & 4) << 3);
+            }
+        }
+        return ret;
+    }();
+
     void loadDSIcon(bannerData* iconData)
     {
         static constexpr int WIDTH_POW2  = 32;
@@ -60,32 +76,32 @@ namespace
             C3D_TexSetWrap(dsIcon.tex, GPU_CLAMP_TO_BORDER, GPU_CLAMP_TO_BORDER);
         }
 
+        std::array<u16, 16> colors;
+        colors[0] = 0xFFFF;
+        for (size_t i = 1; i < colors.size(); i++)
+        {
+            u16 r     = iconData->palette[i] & 0x1F;
+            u16 g     = (iconData->palette[i] >> 5) & 0x1F;
+            u16 b     = (iconData->palette[i] >> 10) & 0x1F;
+            colors[i] = (r << 11) | (g << 6) | (g >> 4) | (b);
+        }
+
+        // The banner and the texture both store the icon as 4x4 tiles of 8x8 pixels in the same
+        // order; only the order of the pixels within a tile differs
         u16* output = (u16*)dsIcon.tex->data;
-        for (size_t x = 0; x < 32; x++)
+        for (size_t tile = 0; tile < 16; tile++)
         {
-            for (size_t y = 0; y < 32; y++)
+            const u8* src = iconData->data + tile * 32;
+            u16* dst      = output + tile * 64;
+            for (size_t i = 0; i < 64; i += 2)
             {
-                u32 srcOff   = (((y >> 3) * 4 + (x >> 3)) * 8 + (y & 7)) * 4 + ((x & 7) >> 1);
-                u32 srcShift = (x & 1) * 4;
-
-                u16 pIndex = (iconData->data[srcOff] >> srcShift) & 0xF;
-                u16 color  = 0xFFFF;
-                if (pIndex != 0)
-                {
-                    u16 r = iconData->palette[pIndex] & 0x1F;
-                    u16 g = (iconData->palette[pIndex] >> 5) & 0x1F;
-                    u16 b = (iconData->palette[pIndex] >> 10) & 0x1F;
-                    color = (r << 11) | (g << 6) | (g >> 4) | (b);
-                }
-
-                u32 dst     = ((((y >> 3) * (WIDTH_POW2 >> 3) + (x >> 3)) << 6) +
-                           ((x & 1) | ((y & 1) << 1) | ((x & 2) << 1) | ((y & 2) << 2) |
-                               ((x & 4) << 2) | ((y & 4) << 3)));
-                output[dst] = color;
+                dst[TILE_ORDER[i]]     = colors[src[i >> 1] & 0xF];
+                dst[TILE_ORDER[i + 1]] = colors[src[i >> 1] >> 4];
             }
         }
     }
-    C2D_Image loadTextureIcon(smdh_s* smdh)
+
+    C2D_Image loadTextureIcon(const u16* icon)
     {
         C3D_Tex* tex                              = new C3D_Tex;
         static constexpr Tex3DS_SubTexture subt3x = {48, 48, 0.0f, 48 / 64.0f, 48 / 64.0f, 0.0f};
@@ -94,16 +110,87 @@ namespace
         C3D_TexSetWrap(tex, GPU_CLAMP_TO_BORDER, GPU_CLAMP_TO_BORDER);
 
         u16* dest = (u16*)tex->data + (64 - 48) * 64;
-        u16* src  = (u16*)smdh->bigIconData;
         for (int j = 0; j < 48; j += 8)
         {
-            std::copy(src, src + 48 * 8, dest);
-            src += 48 * 8;
+            std::copy(icon, icon + 48 * 8, dest);
+            icon += 48 * 8;
             dest += 64 * 8;
         }
 
         return C2D_Image{tex, &subt3x};
     }
+
+    constexpr std::string_view TITLE_CACHE_PATH = "/3ds/PKSM/titlecache.bin";
+    constexpr char TITLE_CACHE_MAGIC[8]         = {'P', 'K', 'S', 'M', 'T', 'T', 'L', 'C'};
+    constexpr u32 TITLE_CACHE_VERSION           = 1;
+
+    // What Title::load finds out about a loadable CTR title. None of it can change without the
+    // title's version changing, so an entry is reused for as long as the version matches
+    struct CachedTitle
+    {
+        u64 id;
+        u16 version;
+        u8 media;
+        u8 gba;
+        u32 reserved;
+        u16 name[0x40];
+        // Already in the tiled layout the texture uses, as it comes from the SMDH
+        u16 icon[48 * 48];
+    };
+    static_assert(sizeof(CachedTitle) == 0x10 + 0x80 + 48 * 48 * 2);
+
+    struct TitleCacheHeader
+    {
+        char magic[8];
+        u32 version;
+        u32 count;
+    };
+
+    LightLock cacheLock = [] {
+        LightLock ret;
+        LightLock_Init(&ret);
+        return ret;
+    }();
+    std::vector<CachedTitle> titleCache;
+    bool titleCacheRead  = false;
+    bool titleCacheDirty = false;
+
+    // Must be called with cacheLock held
+    void readTitleCache()
+    {
+        if (titleCacheRead)
+        {
+            return;
+        }
+        titleCacheRead = true;
+
+        FILE* in = fopen(TITLE_CACHE_PATH.data(), "rb");
+        if (in)
+        {
+            TitleCacheHeader header;
+            if (fread(&header, sizeof(header), 1, in) == 1 &&
+                std::equal(std::begin(header.magic), std::end(header.magic), TITLE_CACHE_MAGIC) &&
+                header.version == TITLE_CACHE_VERSION)
+            {
+                titleCache.resize(header.count);
+                if (fread(titleCache.data(), sizeof(CachedTitle), header.count, in) !=
+                    header.count)
+                {
+                    titleCache.clear();
+                }
+            }
+            fclose(in);
+        }
+    }
+
+    // Must be called with cacheLock held
+    CachedTitle* findCachedTitle(u64 id, FS_MediaType media)
+    {
+        readTitleCache();
+        auto found = std::find_if(titleCache.begin(), titleCache.end(),
+            [id, media](const CachedTitle& title) { return title.id == id && title.media == media; });
+        return found != titleCache.end() ? &*found : nullptr;
+    }
 }
 
 Title::~Title(void)
@@ -124,20 +211,37 @@ bool Title::load(u64 id, FS_MediaType media, FS_CardType card)
 
     if (mCard == CARD_CTR)
     {
+        mPrefix = fmt::format(FMT_STRING("0x{:05X}"), lowId() >> 8);
+
+        AM_TitleEntry info;
+        bool versionKnown = R_SUCCEEDED(AM_GetTitleInfo(mMedia, 1, &mId, &info));
+        if (versionKnown)
+        {
+            LightLock_Lock(&cacheLock);
+            CachedTitle* cached = findCachedTitle(mId, mMedia);
+            if (cached && cached->version == info.version)
+            {
+                mName = StringUtils::UTF16toUTF8((char16_t*)cached->name);
+                mGba  = cached->gba;
+                mIcon = loadTextureIcon(cached->icon);
+                LightLock_Unlock(&cacheLock);
+                return true;
+            }
+            LightLock_Unlock(&cacheLock);
+        }
+
         smdh_s* smdh = loadSMDH(lowId(), highId(), mMedia);
         if (smdh == NULL)
         {
             return false;
         }
 
-        mName   = StringUtils::UTF16toUTF8((char16_t*)smdh->applicationTitles[1].shortDescription);
-        mPrefix = fmt::format(FMT_STRING("0x{:05X}"), lowId() >> 8);
+        mName = StringUtils::UTF16toUTF8((char16_t*)smdh->applicationTitles[1].shortDescription);
 
         Archive archive = Archive::save(mMedia, lowId(), highId(), false);
         if (R_SUCCEEDED(archive.result()))
         {
             loadTitle = true;
-            mIcon     = loadTextureIcon(smdh);
         }
         // Is it a GBA save? GBA saves are not in the normal archive format
         else
@@ -157,12 +261,38 @@ bool Title::load(u64 id, FS_MediaType media, FS_CardType card)
                 {
                     mGba      = true;
                     loadTitle = true;
-                    mIcon     = loadTextureIcon(smdh);
                     out->close();
                 }
                 archive.close();
             }
         }
+
+        if (loadTitle)
+        {
+            mIcon = loadTextureIcon(smdh->bigIconData);
+
+            // Titles without a save aren't cached, as one may well be created before next time
+            if (versionKnown)
+            {
+                LightLock_Lock(&cacheLock);
+                CachedTitle* cached = findCachedTitle(mId, mMedia);
+                if (!cached)
+                {
+                    cached = &titleCache.emplace_back();
+                }
+                *cached         = CachedTitle{};
+                cached->id      = mId;
+                cached->version = info.version;
+                cached->media   = mMedia;
+                cached->gba     = mGba;
+                std::copy(std::begin(smdh->applicationTitles[1].shortDescription),
+                    std::end(smdh->applicationTitles[1].shortDescription), cached->name);
+                std::copy(std::begin(smdh->bigIconData), std::end(smdh->bigIconData),
+                    cached->icon);
+                titleCacheDirty = true;
+                LightLock_Unlock(&cacheLock);
+            }
+        }
         delete smdh;
     }
     else
@@ -205,6 +335,34 @@ bool Title::load(u64 id, FS_MediaType media, FS_CardType card)
     return loadTitle;
 }
 
+void Title::saveCache(void)
+{
+    LightLock_Lock(&cacheLock);
+    if (titleCacheDirty)
+    {
+        FILE* out = fopen(TITLE_CACHE_PATH.data(), "wb");
+        if (out)
+        {
+            TitleCacheHeader header{{}, TITLE_CACHE_VERSION, (u32)titleCache.size()};
+            std::copy(std::begin(TITLE_CACHE_MAGIC), std::end(TITLE_CACHE_MAGIC), header.magic);
+            bool written =
+                fwrite(&header, sizeof(header), 1, out) == 1 &&
+                fwrite(titleCache.data(), sizeof(CachedTitle), titleCache.size(), out) ==
+                    titleCache.size();
+            fclose(out);
+            if (written)
+            {
+                titleCacheDirty = false;
+            }
+            else
+            {
+                remove(TITLE_CACHE_PATH.data());
+            }
+        }
+    }
+    LightLock_Unlock(&cacheLock);
+}
+
 u32 Title::highId(void) const
 {
     return (u32)(mId >> 32);
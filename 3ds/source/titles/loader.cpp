@@ -40,6 +40,7 @@
 #include <atomic>
 #include <format.h>
 #include <sys/stat.h>
+#include <unordered_set>
 
 namespace
 {
@@ -61,8 +62,6 @@ namespace
         u8 padding4[0x198];  // Get it to the proper size
     };
 
-    std::unordered_map<std::u16string, std::shared_ptr<Directory>> directories;
-
     constexpr char langIds[8] = {
         'E', // USA
         'S', // Spain
@@ -89,6 +88,26 @@ namespace
     std::atomic<bool> cartWasUpdated = false;
     std::atomic_flag continueScan;
 
+    // Rescans are started from task workers and the UI thread alike, and each rebuilds its list
+    // from scratch, so only one of each kind may run at a time
+    LightLock scanTitlesLock = [] {
+        LightLock ret;
+        LightLock_Init(&ret);
+        return ret;
+    }();
+    LightLock scanSavesLock = [] {
+        LightLock ret;
+        LightLock_Init(&ret);
+        return ret;
+    }();
+
+    struct ScanGuard
+    {
+        explicit ScanGuard(LightLock& lock) : lock(lock) { LightLock_Lock(&lock); }
+        ~ScanGuard() { LightLock_Unlock(&lock); }
+        LightLock& lock;
+    };
+
     std::array<u64, 5> vcTitleIds                              = {0, 0, 0, 0, 0};
     std::array<u64, 8> ctrTitleIds                             = {0, 0, 0, 0, 0, 0, 0, 0};
     constexpr std::array<pksm::GameVersion, 13> searchVersions = {pksm::GameVersion::S,
@@ -204,75 +223,58 @@ namespace
     std::string saveFileName;
     std::shared_ptr<Title> loadedTitle;
 
-    std::vector<std::string> scanDirectoryFor(const std::u16string& dir, const std::u16string& id)
+    // Which ID a save folder belongs to: CTR and VC folders start with "0x" and five hex digits,
+    // DS folders with the game code and language
+    std::string folderId(const std::string& folderName)
+    {
+        return folderName.substr(0, folderName.substr(0, 2) == "0x" ? 7 : 4);
+    }
+
+    // Walks root once, adding the saves in the folders of every ID in ids to saves
+    void indexSaves(const std::string& root, const std::unordered_set<std::string>& ids,
+        std::unordered_map<std::string, std::vector<std::string>>& saves)
     {
-        if (directories.count(dir) == 0)
+        auto directory = Archive::sd().readDirectory(root);
+        if (!directory)
         {
-            std::shared_ptr<Directory> d = Archive::sd().directory(dir);
-            if (d)
+            return;
+        }
+
+        while (directory->next())
+        {
+            if (!directory->folder())
             {
-                directories.emplace(dir, d);
+                continue;
             }
-            else
+            std::string folderName = StringUtils::UTF16toUTF8(std::u16string(directory->name()));
+            std::string id         = folderId(folderName);
+            if (!ids.contains(id))
             {
-                return {};
+                continue;
             }
-        }
-        else
-        {
-            // Attempt to re-read directory
-            if (!directories[dir]->loaded())
+
+            std::string folderPath = root + '/' + folderName;
+            auto subdir            = Archive::sd().readDirectory(folderPath);
+            if (!subdir)
             {
-                std::shared_ptr<Directory> d = Archive::sd().directory(dir);
-                if (d)
-                {
-                    directories[dir] = d;
-                }
-                else
-                {
-                    return {};
-                }
+                continue;
             }
-        }
-        std::vector<std::string> ret;
-        auto& directory = directories[dir];
-        if (directory->loaded())
-        {
-            for (size_t j = 0; j < directory->count(); j++)
+
+            while (subdir->next())
             {
-                if (directory->folder(j))
+                if (!subdir->folder())
                 {
-                    std::u16string fileName = directory->item(j);
-                    if (fileName.substr(0, id.size()) == id)
-                    {
-                        auto subdir = Archive::sd().directory(dir + u"/" + fileName);
-                        if (subdir)
-                        {
-                            for (size_t k = 0; k < subdir->count(); k++)
-                            {
-                                if (subdir->folder(k))
-                                {
-                                    std::string savePath =
-                                        StringUtils::UTF16toUTF8(
-                                            dir + u"/" + fileName + u"/" + subdir->item(k) + u"/") +
-                                        idToSaveName(id);
-                                    if (io::exists(savePath))
-                                    {
-                                        ret.emplace_back(savePath);
-                                    }
-                                }
-                            }
-                        }
-                    }
+                    continue;
+                }
+                std::string backupName = StringUtils::UTF16toUTF8(std::u16string(subdir->name()));
+                std::string savePath   = folderPath + '/' + backupName + '/' + idToSaveName(id);
+                // Always checked, as the folder staying put says nothing about the save in it
+                if (io::exists(savePath))
+                {
+                    saves[id].emplace_back(std::move(savePath));
                 }
             }
         }
-        return ret;
-    }
-
-    std::vector<std::string> scanDirectoryFor(const std::u16string& dir, const std::string& id)
-    {
-        return scanDirectoryFor(dir, StringUtils::UTF8toUTF16(id));
     }
 
     // file must be at header address. On return, will be at the end of the save described by the
@@ -336,6 +338,8 @@ void TitleLoader::reloadTitleIds(void)
 
 void TitleLoader::scanTitles(void)
 {
+    ScanGuard guard(scanTitlesLock);
+
     Result res = 0;
     u32 count  = 0;
 
@@ -406,65 +410,59 @@ void TitleLoader::scanTitles(void)
         }
     }
 
+    Title::saveCache();
+
     // Titles are already sorted by GameVersion
 }
 
 void TitleLoader::scanSaves(void)
 {
+    ScanGuard guard(scanSavesLock);
+
     Gui::waitFrame(i18n::localize("SCAN_SAVES"));
-    auto scan = [](auto& tids) {
-        for (const auto& tid : tids)
+
+    std::unordered_set<std::string> ids;
+    for (const auto& tid : vcTitleIds)
+    {
+        ids.emplace(fmt::format(FMT_STRING("0x{:05X}"), ((u32)tid) >> 8));
+    }
+    for (const auto& tid : ctrTitleIds)
+    {
+        ids.emplace(fmt::format(FMT_STRING("0x{:05X}"), ((u32)tid) >> 8));
+    }
+    for (size_t game = 0; game < 9; game++)
+    {
+        for (size_t lang = 0; lang < 8; lang++)
         {
-            std::string id                 = fmt::format(FMT_STRING("0x{:05X}"), ((u32)tid) >> 8);
-            std::vector<std::string> saves = scanDirectoryFor(u"/3ds/Checkpoint/saves", id);
-            if (Configuration::getInstance().showBackups())
-            {
-                std::vector<std::string> moreSaves = scanDirectoryFor(u"/3ds/PKSM/backups", id);
-                saves.insert(saves.end(), moreSaves.begin(), moreSaves.end());
-            }
-            auto extraSaves = Configuration::getInstance().extraSaves(id);
-            if (!extraSaves.empty())
-            {
-                for (const auto& save : extraSaves)
-                {
-                    if (io::exists(save))
-                    {
-                        saves.emplace_back(save);
-                    }
-                }
-            }
-            sdSaves[id] = saves;
+            ids.emplace(std::string(dsIds[game]) + langIds[lang]);
         }
-    };
+    }
 
     sdSaves.clear();
+    for (const auto& id : ids)
+    {
+        sdSaves[id] = {};
+    }
 
-    scan(vcTitleIds);
-    scan(ctrTitleIds);
+    std::vector<std::string> roots = {"/3ds/Checkpoint/saves"};
+    if (Configuration::getInstance().showBackups())
+    {
+        roots.emplace_back("/3ds/PKSM/backups");
+    }
 
-    for (size_t game = 0; game < 9; game++)
+    for (const auto& root : roots)
     {
-        for (size_t lang = 0; lang < 8; lang++)
+        indexSaves(root, ids, sdSaves);
+    }
+
+    for (const auto& id : ids)
+    {
+        for (const auto& save : Configuration::getInstance().extraSaves(id))
         {
-            std::string id                 = std::string(dsIds[game]) + langIds[lang];
-            std::vector<std::string> saves = scanDirectoryFor(u"/3ds/Checkpoint/saves", id);
-            if (Configuration::getInstance().showBackups())
-            {
-                std::vector<std::string> moreSaves = scanDirectoryFor(u"/3ds/PKSM/backups", id);
-                saves.insert(saves.end(), moreSaves.begin(), moreSaves.end());
-            }
-            auto extraSaves = Configuration::getInstance().extraSaves(id);
-            if (!extraSaves.empty())
+            if (io::exists(save))
             {
-                for (const auto& save : extraSaves)
-                {
-                    if (io::exists(save))
-                    {
-                        saves.emplace_back(save);
-                    }
-                }
+                sdSaves[id].emplace_back(save);
             }
-            sdSaves[id] = saves;
         }
     }
 }
@@ -1162,6 +1160,7 @@ bool TitleLoader::scanCard()
                     if (title->load(id, MEDIATYPE_GAME_CARD, cardType))
                     {
                         cardTitle = title;
+                        Title::saveCache();
                     }
                 }
             }
@@ -51,6 +51,52 @@ namespace
         }
         return tex;
     }
+
+    // Calls emit(glyph, subtex, xPos, width) for every glyph, or the part of it, that's within
+    // maxWidth of the start of its line once that line is moved by offset. Lines that fit into
+    // maxWidth anyway are passed through unmoved
+    template <typename Emit>
+    void sliceGlyphs(const std::vector<TextParse::Glyph>& glyphs,
+        const std::vector<float>& lineWidths, float maxWidth, float offset, Emit&& emit)
+    {
+        for (const auto& glyph : glyphs)
+        {
+            if (lineWidths[glyph.line - 1] <= maxWidth)
+            {
+                emit(glyph, glyph.subtex, glyph.xPos, glyph.width);
+                continue;
+            }
+
+            float xPos = glyph.xPos + offset;
+            // Completely out of bounds to the left or to the right
+            if (xPos + glyph.width <= 0 || xPos >= maxWidth)
+            {
+                continue;
+            }
+            // Partially out of bounds to the left, so xPos will be < 0 and xPos + width will be > 0
+            else if (xPos < 0)
+            {
+                float targetWidth           = (float)glyph.width + xPos;
+                Tex3DS_SubTexture newSubtex = _select_box(glyph.subtex,
+                    glyph.width - static_cast<u16>(ceilf(targetWidth)), 0, glyph.width, 0);
+                emit(glyph, newSubtex, 0, newSubtex.width);
+            }
+            // Partially out of bounds to the right, so xPos will be < maxWidth and xPos + width
+            // will be > maxWidth
+            else if (xPos + glyph.width > maxWidth)
+            {
+                float targetWidth = (float)maxWidth - xPos;
+                Tex3DS_SubTexture newSubtex =
+                    _select_box(glyph.subtex, 0, 0, static_cast<u16>(ceilf(targetWidth)), 0);
+                emit(glyph, newSubtex, xPos, newSubtex.width);
+            }
+            // Fully in-bounds: just move it the amount of the offset
+            else
+            {
+                emit(glyph, glyph.subtex, xPos, glyph.width);
+            }
+        }
+    }
 }
 
 namespace TextParse
@@ -154,54 +200,10 @@ namespace TextParse
         }
         ret->maxLineWidth = *std::max_element(ret->lineWidths.begin(), ret->lineWidths.end());
 
-        for (auto i = glyphs.begin(); i != glyphs.end(); i++)
-        {
-            if (lineWidths[i->line - 1] > maxWidth)
-            {
-                // Completely out of bounds to the left
-                if (i->xPos + i->width + offset <= 0)
-                {
-                    continue;
-                }
-                // Completely out of bounds to the right
-                else if (i->xPos + offset >= maxWidth)
-                {
-                    continue;
-                }
-                // Partially out of bounds to the left, so xPos will be < 0 and xPos + width will be
-                // > 0
-                else if (i->xPos + offset < 0)
-                {
-                    float newXPos               = i->xPos + offset;
-                    float targetWidth           = (float)i->width + newXPos;
-                    Tex3DS_SubTexture newSubtex = _select_box(
-                        i->subtex, i->width - static_cast<u16>(ceilf(targetWidth)), 0, i->width, 0);
-                    ret->glyphs.emplace_back(
-                        newSubtex, i->tex, i->font, i->line, 0, newSubtex.width);
-                }
-                // Partially out of bounds to the right, so xPos will be < maxWidth and xPos + width
-                // will be > maxWidth
-                else if (i->xPos + i->width + offset > maxWidth)
-                {
-                    float newXPos     = i->xPos + offset;
-                    float targetWidth = (float)maxWidth - newXPos;
-                    Tex3DS_SubTexture newSubtex =
-                        _select_box(i->subtex, 0, 0, static_cast<u16>(ceilf(targetWidth)), 0);
-                    ret->glyphs.emplace_back(
-                        newSubtex, i->tex, i->font, i->line, newXPos, newSubtex.width);
-                }
-                // Fully in-bounds: just move it the amount of the offset
-                else
-                {
-                    ret->glyphs.emplace_back(
-                        i->subtex, i->tex, i->font, i->line, i->xPos + offset, i->width);
-                }
-            }
-            else
-            {
-                ret->glyphs.emplace_back(*i);
-            }
-        }
+        sliceGlyphs(glyphs, lineWidths, maxWidth, offset,
+            [&ret](const Glyph& glyph, const Tex3DS_SubTexture& subtex, float xPos, float width) {
+                ret->glyphs.emplace_back(subtex, glyph.tex, glyph.font, glyph.line, xPos, width);
+            });
         return ret;
     }
 
@@ -251,12 +253,14 @@ namespace TextParse
         glyphSheets.emplace(font, std::move(fontSheets));
     }
 
-    void TextBuf::clear()
+    bool TextBuf::clear()
     {
         if (currentGlyphs >= maxGlyphs)
         {
             clearUnconditional();
+            return true;
         }
+        return false;
     }
 
     void TextBuf::clearUnconditional() { parsedText.clear(); }
@@ -424,34 +428,52 @@ namespace TextParse
         }
     }
 
-    void ScreenText::addText(std::shared_ptr<Text> text, float x, float y, float z, FontSize sizeX,
-        FontSize sizeY, TextPosX textPos, PKSM_Color color)
+    void ScreenText::addGlyph(const Glyph& glyph, float lineWidth, float x, float y, float z,
+        FontSize sizeX, FontSize sizeY, TextPosX textPos, PKSM_Color color)
     {
         static_assert(std::is_same<FontSize, float>::value);
         static const u8 lineFeed = fontGetInfo(nullptr)->lineFeed;
+        float glyphX             = x + sizeX * glyph.xPos;
+        switch (textPos)
+        {
+            case TextPosX::LEFT:
+                break;
+            case TextPosX::CENTER:
+                glyphX -= sizeX * lineWidth / 2;
+                break;
+            case TextPosX::RIGHT:
+                glyphX -= sizeX * lineWidth;
+                break;
+        }
+        float glyphY =
+            y + sizeY * (lineFeed * glyph.line - C2D_FontGetInfo(glyph.font)->tglp->baselinePos);
+        glyphs.emplace_back(glyph, glyphX, glyphY, z, sizeX, sizeY, color);
+    }
+
+    void ScreenText::addText(std::shared_ptr<Text> text, float x, float y, float z, FontSize sizeX,
+        FontSize sizeY, TextPosX textPos, PKSM_Color color)
+    {
         if (!text || text->glyphs.empty())
             return;
 
         for (const auto& glyph : text->glyphs)
         {
-            float glyphX = x + sizeX * glyph.xPos;
-            switch (textPos)
-            {
-                case TextPosX::LEFT:
-                    break;
-                case TextPosX::CENTER:
-                    glyphX -= sizeX * text->lineWidths[glyph.line - 1] / 2;
-                    break;
-                case TextPosX::RIGHT:
-                    glyphX -= sizeX * text->lineWidths[glyph.line - 1];
-                    break;
-            }
-            float glyphY = y + sizeY * (lineFeed * glyph.line -
-                                           C2D_FontGetInfo(glyph.font)->tglp->baselinePos);
-            glyphs.emplace_back(glyph, glyphX, glyphY, z, sizeX, sizeY, color);
+            addGlyph(glyph, text->lineWidths[glyph.line - 1], x, y, z, sizeX, sizeY, textPos,
+                color);
         }
     }
 
+    void ScreenText::addTextSlice(const Text& text, float maxWidth, float scrollOffset, float x,
+        float y, float z, FontSize sizeX, FontSize sizeY, TextPosX textPos, PKSM_Color color)
+    {
+        sliceGlyphs(text.glyphs, text.lineWidths, maxWidth, scrollOffset,
+            [&](const Glyph& glyph, const Tex3DS_SubTexture& subtex, float xPos, float width) {
+                addGlyph(Glyph(subtex, glyph.tex, glyph.font, glyph.line, xPos, width),
+                    std::min(text.lineWidths[glyph.line - 1], maxWidth), x, y, z, sizeX, sizeY,
+                    textPos, color);
+            });
+    }
+
     void ScreenText::optimize()
     {
         std::sort(
@@ -33,20 +33,364 @@
 #include "gui.hpp"
 #include "i18n_ext.hpp"
 #include "loader.hpp"
+#include "utils/crypto.hpp"
 #include <arpa/inet.h>
 #include <unistd.h>
+#include <zlib.h>
 
 namespace
 {
     bool saveFromBridge = false;
     struct in_addr lastIPAddr;
 
+    // Version 2 of the bridge protocol splits the save into blocks, only sends the ones that the
+    // other side doesn't already have, and deflates them. A peer whose first bytes aren't
+    // PROTOCOL_MAGIC is a version 1 peer, which sends and expects nothing but the raw save. All
+    // integers are little endian.
+    //
+    // Receiving:
+    //   PC -> 3DS: Header
+    //   3DS -> PC: Header with the negotiated version and block size, u32 hash count, and the
+    //              SHA-256 of each block of the save the 3DS last exchanged
+    //   PC -> 3DS: Blocks that differ, then END_OF_BLOCKS, then the SHA-256 of the whole save
+    // Sending is the same with the 3DS and PC swapped, except that the 3DS sends the first header.
+    // tools/pksmbridge.py is a reference implementation of the PC side.
+    constexpr std::string_view PROTOCOL_MAGIC = "PKSMBRDG";
+    constexpr u32 PROTOCOL_VERSION            = 2;
+    constexpr u32 BLOCK_SIZE                  = 0x4000;
+    // Set on a block's size when it is sent uncompressed because deflating didn't make it smaller
+    constexpr u32 RAW_BLOCK        = 0x80000000;
+    constexpr u32 END_OF_BLOCKS    = 0xFFFFFFFF;
+    constexpr int SOCKET_BUF_SIZE  = 0x20000;
+    constexpr size_t MAX_SAVE_SIZE = 0x180B19;
+
+    struct Header
+    {
+        char magic[8];
+        u32 version;
+        u32 saveSize;
+        u32 blockSize;
+    };
+    static_assert(sizeof(Header) == 20);
+
+    struct BlockHeader
+    {
+        u32 index;
+        u32 size;
+    };
+    static_assert(sizeof(BlockHeader) == 8);
+
+    using Hash = decltype(pksm::crypto::sha256(nullptr, 0));
+
+    // Peer protocol version learned while receiving, used to decide how to send back
+    u32 peerVersion = 1;
+    // The save as it was last received or sent, which is what the PC is expected to still have
+    std::unique_ptr<u8[]> lastExchanged;
+    size_t lastExchangedSize = 0;
+
     char* getHostId()
     {
         static sockaddr_in addr;
         addr.sin_addr.s_addr = gethostid();
         return inet_ntoa(addr.sin_addr);
     }
+
+    void setBufferSizes(int fd)
+    {
+        // Failure only means smaller buffers
+        setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &SOCKET_BUF_SIZE, sizeof(SOCKET_BUF_SIZE));
+        setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &SOCKET_BUF_SIZE, sizeof(SOCKET_BUF_SIZE));
+    }
+
+    bool sendAll(int fd, const void* data, size_t size)
+    {
+        size_t total = 0;
+        while (total < size)
+        {
+            int n = send(fd, (const u8*)data + total, size - total, 0);
+            if (n <= 0)
+            {
+                return false;
+            }
+            total += n;
+        }
+        return true;
+    }
+
+    bool recvAll(int fd, void* data, size_t size)
+    {
+        size_t total = 0;
+        while (total < size)
+        {
+            int n = recv(fd, (u8*)data + total, size - total, 0);
+            if (n <= 0)
+            {
+                return false;
+            }
+            total += n;
+        }
+        return true;
+    }
+
+    u32 blockCount(size_t size) { return (size + BLOCK_SIZE - 1) / BLOCK_SIZE; }
+
+    u32 blockLength(size_t size, u32 index)
+    {
+        return std::min<size_t>(BLOCK_SIZE, size - (size_t)index * BLOCK_SIZE);
+    }
+
+    std::vector<Hash> blockHashes(const u8* data, size_t size)
+    {
+        std::vector<Hash> ret(blockCount(size));
+        for (u32 i = 0; i < ret.size(); i++)
+        {
+            ret[i] = pksm::crypto::sha256(data + i * BLOCK_SIZE, blockLength(size, i));
+        }
+        return ret;
+    }
+
+    Header makeHeader(u32 saveSize)
+    {
+        Header ret;
+        std::copy(PROTOCOL_MAGIC.begin(), PROTOCOL_MAGIC.end(), ret.magic);
+        ret.version   = PROTOCOL_VERSION;
+        ret.saveSize  = saveSize;
+        ret.blockSize = BLOCK_SIZE;
+        return ret;
+    }
+
+    bool isHeader(const Header& header)
+    {
+        return std::equal(PROTOCOL_MAGIC.begin(), PROTOCOL_MAGIC.end(), header.magic);
+    }
+
+    void remember(const u8* data, size_t size)
+    {
+        lastExchanged = std::unique_ptr<u8[]>(new u8[size]);
+        std::copy(data, data + size, lastExchanged.get());
+        lastExchangedSize = size;
+    }
+
+    // Nothing is left to compare against once the bridge save is gone, so don't hold a copy of it
+    void forget()
+    {
+        lastExchanged     = nullptr;
+        lastExchangedSize = 0;
+        peerVersion       = 1;
+    }
+
+    // Hashes of the last exchanged save, if it is the size the peer is working with
+    std::vector<Hash> knownHashes(size_t size)
+    {
+        if (lastExchanged && lastExchangedSize == size)
+        {
+            return blockHashes(lastExchanged.get(), size);
+        }
+        return {};
+    }
+
+    bool sendHashes(int fd, const std::vector<Hash>& hashes)
+    {
+        u32 count = hashes.size();
+        return sendAll(fd, &count, sizeof(count)) &&
+               (hashes.empty() || sendAll(fd, hashes.data(), hashes.size() * sizeof(Hash)));
+    }
+
+    std::optional<std::vector<Hash>> recvHashes(int fd, size_t size)
+    {
+        u32 count;
+        if (!recvAll(fd, &count, sizeof(count)) || (count != 0 && count != blockCount(size)))
+        {
+            return std::nullopt;
+        }
+        std::vector<Hash> ret(count);
+        if (count != 0 && !recvAll(fd, ret.data(), count * sizeof(Hash)))
+        {
+            return std::nullopt;
+        }
+        return ret;
+    }
+
+    void showProgress(const std::string& message, u32 done, u32 total)
+    {
+        static u64 lastShown = 0;
+        u64 now              = osGetTime();
+        // Drawing waits for VBlank, so don't let it slow the transfer down
+        if (now - lastShown >= 100 || done == total)
+        {
+            lastShown = now;
+            Gui::showProgress(message, done / 1024, total / 1024);
+        }
+    }
+
+    // Sends every block of data whose hash isn't in peerHashes at the same index
+    bool sendBlocks(int fd, const u8* data, size_t size, const std::vector<Hash>& peerHashes)
+    {
+        const std::string message = i18n::localize("LOADER_WIRELESS");
+        std::vector<u8> compressed(compressBound(BLOCK_SIZE));
+        u32 blocks = blockCount(size);
+        for (u32 i = 0; i < blocks; i++)
+        {
+            const u8* block = data + i * BLOCK_SIZE;
+            u32 length      = blockLength(size, i);
+            if (!peerHashes.empty() && pksm::crypto::sha256(block, length) == peerHashes[i])
+            {
+                continue;
+            }
+
+            uLongf compressedSize = compressed.size();
+            BlockHeader header{i, 0};
+            const u8* payload;
+            if (compress2(compressed.data(), &compressedSize, block, length, Z_BEST_SPEED) ==
+                    Z_OK &&
+                compressedSize < length)
+            {
+                header.size = compressedSize;
+                payload     = compressed.data();
+            }
+            else
+            {
+                header.size = length | RAW_BLOCK;
+                payload     = block;
+            }
+            if (!sendAll(fd, &header, sizeof(header)) ||
+                !sendAll(fd, payload, header.size & ~RAW_BLOCK))
+            {
+                return false;
+            }
+            showProgress(message, i * BLOCK_SIZE + length, size);
+        }
+
+        u32 end   = END_OF_BLOCKS;
+        Hash hash = pksm::crypto::sha256(data, size);
+        return sendAll(fd, &end, sizeof(end)) && sendAll(fd, hash.data(), hash.size());
+    }
+
+    // Fills data from the blocks sent by the peer and, for the rest, from the last exchanged save,
+    // which the peer was told about in knownHashes
+    bool recvBlocks(int fd, u8* data, size_t size, bool haveBase)
+    {
+        const std::string message = i18n::localize("LOADER_WIRELESS");
+        u32 blocks                = blockCount(size);
+        std::vector<bool> received(blocks, false);
+        std::vector<u8> compressed(compressBound(BLOCK_SIZE));
+        while (true)
+        {
+            BlockHeader header;
+            if (!recvAll(fd, &header.index, sizeof(header.index)))
+            {
+                return false;
+            }
+            if (header.index == END_OF_BLOCKS)
+            {
+                break;
+            }
+            if (header.index >= blocks || !recvAll(fd, &header.size, sizeof(header.size)))
+            {
+                return false;
+            }
+
+            u8* block  = data + header.index * BLOCK_SIZE;
+            u32 length = blockLength(size, header.index);
+            if (header.size & RAW_BLOCK)
+            {
+                if ((header.size & ~RAW_BLOCK) != length || !recvAll(fd, block, length))
+                {
+                    return false;
+                }
+            }
+            else
+            {
+                uLongf outSize = length;
+                if (header.size > compressed.size() ||
+                    !recvAll(fd, compressed.data(), header.size) ||
+                    uncompress(block, &outSize, compressed.data(), header.size) != Z_OK ||
+                    outSize != length)
+                {
+                    return false;
+                }
+            }
+            received[header.index] = true;
+            showProgress(message, header.index * BLOCK_SIZE + length, size);
+        }
+
+        for (u32 i = 0; i < blocks; i++)
+        {
+            if (!received[i])
+            {
+                if (!haveBase)
+                {
+                    return false;
+                }
+                const u8* base = lastExchanged.get() + i * BLOCK_SIZE;
+                std::copy(base, base + blockLength(size, i), data + i * BLOCK_SIZE);
+            }
+        }
+
+        Hash expected;
+        return recvAll(fd, expected.data(), expected.size()) &&
+               pksm::crypto::sha256(data, size) == expected;
+    }
+
+    bool sendVersion2(int fd, const u8* data, size_t size)
+    {
+        Header header = makeHeader(size);
+        Header reply;
+        if (!sendAll(fd, &header, sizeof(header)) || !recvAll(fd, &reply, sizeof(reply)) ||
+            !isHeader(reply) || reply.blockSize != BLOCK_SIZE)
+        {
+            return false;
+        }
+        auto peerHashes = recvHashes(fd, size);
+        return peerHashes && sendBlocks(fd, data, size, *peerHashes);
+    }
+
+    // Receives a save from a version 2 peer after its header has been read
+    std::optional<size_t> recvVersion2(int fd, const Header& peer, std::shared_ptr<u8[]>& data)
+    {
+        if (peer.saveSize == 0 || peer.saveSize > MAX_SAVE_SIZE)
+        {
+            return std::nullopt;
+        }
+        peerVersion = std::min(peer.version, PROTOCOL_VERSION);
+
+        Header reply  = makeHeader(peer.saveSize);
+        reply.version = peerVersion;
+        auto hashes   = knownHashes(peer.saveSize);
+        if (!sendAll(fd, &reply, sizeof(reply)) || !sendHashes(fd, hashes))
+        {
+            return std::nullopt;
+        }
+
+        data = std::shared_ptr<u8[]>(new u8[peer.saveSize]);
+        if (!recvBlocks(fd, data.get(), peer.saveSize, !hashes.empty()))
+        {
+            return std::nullopt;
+        }
+        return peer.saveSize;
+    }
+
+    // Receives a save from a version 1 peer, which just sends the raw data. The first bytes have
+    // already been read into data
+    std::optional<size_t> recvVersion1(int fd, std::shared_ptr<u8[]>& data, size_t total)
+    {
+        size_t size = MAX_SAVE_SIZE;
+        int n       = 1;
+        while (total < size)
+        {
+            n = recv(fd, &data[total], size - total, 0);
+            if (n <= 0)
+            {
+                break;
+            }
+            total += n;
+        }
+        if (n == 0 || total == size)
+        {
+            return total;
+        }
+        return std::nullopt;
+    }
 }
 
 bool isLoadedSaveFromBridge(void)
@@ -55,7 +399,11 @@ bool isLoadedSaveFromBridge(void)
 }
 void setLoadedSaveFromBridge(bool v)
 {
-    saveFromBridge = false;
+    saveFromBridge = v;
+    if (!v)
+    {
+        forget();
+    }
 }
 
 bool receiveSaveFromBridge(void)
@@ -103,35 +451,41 @@ bool receiveSaveFromBridge(void)
     }
 
     lastIPAddr = servaddr.sin_addr;
+    setBufferSizes(fdconn);
 
-    size_t size                = 0x180B19;
-    std::shared_ptr<u8[]> data = std::shared_ptr<u8[]>(new u8[size]);
-
-    size_t total = 0;
-    size_t chunk = 1024;
-    int n;
-    while (total < size)
+    std::shared_ptr<u8[]> data;
+    std::optional<size_t> size;
+    Header header;
+    if (recvAll(fdconn, &header, sizeof(header)))
     {
-        size_t torecv = size - total > chunk ? chunk : size - total;
-        n             = recv(fdconn, &data[total], torecv, 0);
-        total += n;
-        if (n <= 0)
+        if (isHeader(header))
         {
-            break;
+            size = recvVersion2(fdconn, header, data);
+        }
+        else
+        {
+            peerVersion = 1;
+            data        = std::shared_ptr<u8[]>(new u8[MAX_SAVE_SIZE]);
+            std::copy((u8*)&header, (u8*)&header + sizeof(header), data.get());
+            size = recvVersion1(fdconn, data, sizeof(header));
         }
-        fmt::print(stderr, "Recv {:d} bytes, {:d} still missing\n", total, size - total);
     }
 
     close(fdconn);
     close(fd);
 
-    if (n == 0 || total == size)
+    if (size)
     {
-        if (TitleLoader::load(data, total))
+        remember(data.get(), *size);
+        if (TitleLoader::load(data, *size))
         {
             saveFromBridge = true;
             Gui::setScreen(std::make_unique<MainMenu>());
         }
+        else
+        {
+            forget();
+        }
     }
     else
     {
@@ -163,26 +517,22 @@ bool sendSaveToBridge(void)
         close(fd);
         return result;
     }
+    setBufferSizes(fd);
 
-    size_t size  = TitleLoader::save->getLength();
-    size_t total = 0;
-    size_t chunk = 1024;
-    int n;
-    while (total < size)
+    const u8* data = TitleLoader::save->rawData().get();
+    size_t size    = TitleLoader::save->getLength();
+    if (peerVersion >= 2)
     {
-        size_t tosend = size - total > chunk ? chunk : size - total;
-        n             = send(fd, TitleLoader::save->rawData().get() + total, tosend, 0);
-        if (n == -1)
-        {
-            break;
-        }
-        total += n;
-        fmt::print(stderr, "Recv {:d} bytes, {:d} still missing\n", total, size - total);
+        result = sendVersion2(fd, data, size);
     }
-    if (total == size)
+    else
+    {
+        result = sendAll(fd, data, size);
+    }
+
+    if (result)
     {
-        // Gui::createInfo("Success!", "Data sent back correctly.");
-        result = true;
+        remember(data, size);
     }
     else
     {
@@ -27,6 +27,8 @@
 #include "thread.hpp"
 #include <3ds.h>
 #include <algorithm>
+#include <deque>
+#include <vector>
 
 namespace
 {
@@ -70,40 +72,112 @@ namespace
         }
     }
 
-    struct Task
+    // priorityOffset is relative to the calling thread; lower values are scheduled first
+    bool createOnCore(void (*entrypoint)(void*), void* arg, std::optional<size_t> stackSize,
+        int core, s32 priorityOffset = -1)
     {
-        void (*entrypoint)(void*);
-        void* arg;
+        if (currentThreads >= Threads::MAX_THREADS)
+        {
+            return false;
+        }
+        s32 prio = 0;
+        svcGetThreadPriority(&prio, CUR_THREAD_HANDLE);
+        prio = std::clamp<s32>(prio + priorityOffset, 0x18, 0x3F);
+        Thread thread =
+            threadCreate(entrypoint, arg, stackSize.value_or(4 * 1024), prio, core, false);
+
+        if (thread)
+        {
+            LightLock_Lock(&currentThreadsLock);
+            threads[currentThreads]                           = thread;
+            reaperThreadHandles[MIN_HANDLES + currentThreads] = threadGetHandle(thread);
+            currentThreads++;
+            LightLock_Unlock(&currentThreadsLock);
+            svcSignalEvent(reaperThreadHandles[1]);
+            return true;
+        }
+
+        return false;
+    }
+
+    // Each worker takes the oldest job of its own queues and steals the newest of other workers'
+    // ones, so the two rarely contend for the same end
+    struct Worker
+    {
+        LightLock lock;
+        std::deque<std::unique_ptr<Threads::internal::Job>> jobs[Threads::PRIORITIES];
     };
-    std::vector<Task> workerTasks;
-    LightLock workerTaskLock;
-    LightSemaphore moreTasks;
-    u8 numWorkers;
+    // The application core, then the New 3DS's extra application core if it can be used
+    constexpr int WORKER_CORES[] = {-2, 2};
+    constexpr size_t MAX_WORKERS = std::size(WORKER_CORES);
+    Worker workers[MAX_WORKERS];
+    size_t numWorkers = 0;
+    std::atomic<size_t> nextWorker;
+    thread_local size_t currentWorker = MAX_WORKERS;
+    // Counts queued jobs, so that a worker that acquires it is guaranteed to find one
+    LightSemaphore queuedJobs;
+    std::atomic<bool> stopWorkers;
+
+    std::unique_ptr<Threads::internal::Job> takeJob(size_t self)
+    {
+        for (size_t priority = 0; priority < Threads::PRIORITIES; priority++)
+        {
+            for (size_t i = 0; i < numWorkers; i++)
+            {
+                size_t victim  = (self + i) % numWorkers;
+                Worker& worker = workers[victim];
+                LightLock_Lock(&worker.lock);
+                auto& jobs = worker.jobs[priority];
+                if (!jobs.empty())
+                {
+                    std::unique_ptr<Threads::internal::Job> ret;
+                    if (victim == self)
+                    {
+                        ret = std::move(jobs.front());
+                        jobs.pop_front();
+                    }
+                    else
+                    {
+                        ret = std::move(jobs.back());
+                        jobs.pop_back();
+                    }
+                    LightLock_Unlock(&worker.lock);
+                    return ret;
+                }
+                LightLock_Unlock(&worker.lock);
+            }
+        }
+        return nullptr;
+    }
+
+    // Only call after acquiring queuedJobs. Jobs are queued before it is released and only taken
+    // after it is acquired, so there is always one left for this worker to find
+    void runJob(size_t self)
+    {
+        if (auto job = takeJob(self))
+        {
+            job->run();
+        }
+    }
 
     void taskWorkerThread(void* arg)
     {
+        currentWorker = (size_t)arg;
         while (true)
         {
-            LightSemaphore_Acquire(&moreTasks, 1);
+            LightSemaphore_Acquire(&queuedJobs, 1);
 
-            LightLock_Lock(&workerTaskLock);
-
-            if (workerTasks.size() == 0)
+            if (stopWorkers)
             {
                 return;
             }
 
-            Task t = workerTasks[0];
-            workerTasks.erase(workerTasks.begin());
-
-            LightLock_Unlock(&workerTaskLock);
-
-            t.entrypoint(t.arg);
+            runJob(currentWorker);
         }
     }
 }
 
-bool Threads::init(u8 workers)
+bool Threads::init(void)
 {
     LightLock_Init(&currentThreadsLock);
     if (R_FAILED(svcCreateEvent(&reaperThreadHandles[0], RESET_ONESHOT)))
@@ -117,54 +191,113 @@ bool Threads::init(u8 workers)
     if (!reaperThread)
         return false;
 
-    LightLock_Init(&workerTaskLock);
-    LightSemaphore_Init(&moreTasks, 0, workers);
-    for (int i = 0; i < workers; i++)
+    bool isNew3DS = false;
+    APT_CheckNew3DS(&isNew3DS);
+    size_t cores = isNew3DS ? MAX_WORKERS : 1;
+
+    stopWorkers = false;
+    LightSemaphore_Init(&queuedJobs, 0, INT16_MAX);
+    for (size_t i = 0; i < cores; i++)
     {
-        if (!Threads::create(taskWorkerThread, nullptr, 0x8000))
+        LightLock_Init(&workers[numWorkers].lock);
+        // The extra core may not be available to this process, in which case it is simply skipped.
+        // Workers run below the UI thread, which otherwise gets no time on a shared core until a
+        // long task like decoding a bank finishes; it blocks on VBlank every frame, so they still
+        // get most of the CPU
+        if (createOnCore(taskWorkerThread, (void*)numWorkers, 0x8000, WORKER_CORES[i], 1))
+        {
+            numWorkers++;
+        }
+        else if (i == 0)
+        {
             return false;
+        }
     }
     return true;
 }
 
 bool Threads::create(void (*entrypoint)(void*), void* arg, std::optional<size_t> stackSize)
 {
-    if (currentThreads >= Threads::MAX_THREADS)
-    {
-        return false;
-    }
-    s32 prio = 0;
-    svcGetThreadPriority(&prio, CUR_THREAD_HANDLE);
-    Thread thread =
-        threadCreate(entrypoint, arg, stackSize.value_or(4 * 1024), prio - 1, -2, false);
+    return createOnCore(entrypoint, arg, stackSize, -2);
+}
 
-    if (thread)
+void Threads::internal::schedule(std::unique_ptr<Job> job, Priority priority)
+{
+    // Jobs started by a worker stay with it; others are spread over all of them
+    size_t target  = currentWorker < numWorkers ? currentWorker : nextWorker++ % numWorkers;
+    Worker& worker = workers[target];
+    LightLock_Lock(&worker.lock);
+    // Once exit() has emptied the queues, nothing would take this
+    if (stopWorkers)
     {
-        LightLock_Lock(&currentThreadsLock);
-        reaperThreadHandles[currentThreads++] = threadGetHandle(thread);
-        LightLock_Unlock(&currentThreadsLock);
-        svcSignalEvent(reaperThreadHandles[1]);
-        return true;
+        LightLock_Unlock(&worker.lock);
+        job->cancel();
+        return;
     }
-
-    return false;
+    worker.jobs[size_t(priority)].emplace_back(std::move(job));
+    LightLock_Unlock(&worker.lock);
+    LightSemaphore_Release(&queuedJobs, 1);
 }
 
-void Threads::executeTask(void (*task)(void*), void* arg)
+bool Threads::internal::runQueuedJob(void)
 {
-    LightLock_Lock(&workerTaskLock);
-    workerTasks.emplace_back(task, arg);
-    LightSemaphore_Release(&moreTasks, 1);
-    LightLock_Unlock(&workerTaskLock);
+    if (currentWorker >= numWorkers || stopWorkers ||
+        LightSemaphore_TryAcquire(&queuedJobs, 1) != 0)
+    {
+        return false;
+    }
+    runJob(currentWorker);
+    return true;
 }
 
 void Threads::exit(void)
 {
-    LightSemaphore_Release(&moreTasks, numWorkers);
+    stopWorkers = true;
+
+    // Tasks that never ran are cancelled before joining anything, as a worker waiting on one of
+    // them would otherwise never wake up to be joined
+    std::vector<std::unique_ptr<Threads::internal::Job>> cancelled;
+    for (size_t i = 0; i < numWorkers; i++)
+    {
+        LightLock_Lock(&workers[i].lock);
+        for (auto& jobs : workers[i].jobs)
+        {
+            for (auto& job : jobs)
+            {
+                job->cancel();
+                cancelled.emplace_back(std::move(job));
+            }
+            jobs.clear();
+        }
+        LightLock_Unlock(&workers[i].lock);
+    }
+
+    LightSemaphore_Release(&queuedJobs, numWorkers);
     svcSignalEvent(reaperThreadHandles[0]);
     threadJoin(reaperThread, U64_MAX);
     threadFree(reaperThread);
     svcCloseHandle(reaperThreadHandles[0]);
     svcCloseHandle(reaperThreadHandles[1]);
     // All remove themselves, so no extra removal necessary
+    numWorkers = 0;
+}
+
+Threads::Event::Event(bool autoReset) : event(new LightEvent)
+{
+    LightEvent_Init((LightEvent*)event, autoReset ? RESET_ONESHOT : RESET_STICKY);
+}
+
+Threads::Event::~Event()
+{
+    delete (LightEvent*)event;
+}
+
+void Threads::Event::signal()
+{
+    LightEvent_Signal((LightEvent*)event);
+}
+
+void Threads::Event::wait()
+{
+    LightEvent_Wait((LightEvent*)event);
 }
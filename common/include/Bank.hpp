@@ -30,17 +30,39 @@
 #include "enums/Generation.hpp"
 #include "nlohmann/json_fwd.hpp"
 #include "pkx/PKX.hpp"
+#include "thread.hpp"
 #include "utils/crypto.hpp"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
 
 class Bank
 {
 public:
-    Bank(const std::string& name, int maxBoxes);
+    Bank(const std::string& name, int maxBoxes, int firstBox = 0);
     ~Bank();
     std::unique_ptr<pksm::PKX> pkm(int box, int slot) const;
     void pkm(const pksm::PKX& pkm, int box, int slot);
+    // Copies a slot from another bank, or from elsewhere in this one, without decoding it
+    void pkm(const Bank& from, int fromBox, int fromSlot, int box, int slot);
+    // Exchanges two slots, which may be in different banks, without decoding either
+    static void swapPkm(
+        Bank& first, int firstBox, int firstSlot, Bank& second, int secondBox, int secondSlot);
+    // Calls func on every occupied slot from firstBox through lastBox. The Pokémon are read in
+    // place rather than copied out, so the reference is only valid during the call
+    void forEachPkm(int firstBox, int lastBox,
+        const std::function<void(const pksm::PKX&, int box, int slot)>& func) const;
     void resize(int boxes);
-    void load(int maxBoxes);
+    // Banks in the current format are read by a task worker, starting with firstBox and moving
+    // outwards from it. Anything that needs a box that isn't there yet waits for it
+    void load(int maxBoxes, int firstBox = 0);
+    bool boxLoaded(int box) const;
+    bool loading() const;
+    // Reports a background load that couldn't read the whole bank. Boxes it couldn't read are
+    // empty, and the bank isn't written until the user agrees to lose them. Call from the UI thread
+    // while not drawing
+    void update();
     bool save() const;
     bool saveWithoutBackup() const;
     bool backup() const;
@@ -51,11 +73,13 @@ public:
     int boxes() const;
     const std::string& name() const;
     bool setName(const std::string& name);
+    // Bytes of memory taken up by the bank's contents
+    size_t memoryUsage() const;
 
 private:
-    static constexpr int BANK_VERSION            = 3;
+    static constexpr int BANK_VERSION            = 4;
     static constexpr std::string_view BANK_MAGIC = "PKSMBANK";
-    void createJSON();
+    void createNames();
     void createBank(int maxBoxes);
     void convertFromBankBin();
     struct BankHeader
@@ -72,9 +96,71 @@ private:
         u8 padding[4]; // Pad to 8 bytes
     };
     static_assert(sizeof(BankEntry) == 0x150);
-    std::unique_ptr<nlohmann::json> boxNames;
-    mutable std::array<u8, 32> prevHash;
-    mutable std::array<u8, 32> prevNameHash;
+    // Since version 4, the header is followed by one of these per box and then the box blocks. A
+    // block holds the box's 30 slots, each as a u16 length and that many bytes of its BankEntry
+    // without the trailing 0xFF bytes; runs of empty slots are a single u16 with EMPTY_RUN set.
+    // Blocks are deflated unless that doesn't make them smaller, which RAW_BOX marks
+    struct BoxIndex
+    {
+        u32 offset; // From the end of the index
+        u32 size;
+    };
+    static_assert(sizeof(BoxIndex) == 8);
+    static constexpr u32 RAW_BOX          = 0x80000000;
+    static constexpr u16 EMPTY_RUN        = 0x8000;
+    static constexpr size_t MAX_BOX_BLOCK = 30 * (sizeof(u16) + sizeof(BankEntry));
+    // Appends the block for box to out and returns where it is
+    BoxIndex packBox(int box, std::vector<u8>& out) const;
+    bool unpackBox(int box, const u8* block, const BoxIndex& index, std::vector<u8>& scratch);
+    // Box names are kept in a .names file next to the bank: a NamesHeader followed by one
+    // fixed-size NameRecord per box, so that renaming a box only rewrites its record
+    static constexpr int NAMES_VERSION            = 1;
+    static constexpr std::string_view NAMES_MAGIC = "PKSMBXNM";
+    struct NamesHeader
+    {
+        char MAGIC[8];
+        u32 version;
+        u32 boxes;
+    };
+    static_assert(sizeof(NamesHeader) == 16);
+    struct NameRecord
+    {
+        u8 length;
+        char name[63];
+    };
+    static_assert(sizeof(NameRecord) == 64);
+    bool loadBoxes(const std::string& path, int firstBox);
+    bool readBoxes(const std::string& path, int firstBox, std::vector<u8>& scratch);
+    void publishBox(int box);
+    void waitForBox(int box) const;
+    void waitForLoad() const;
+    // Takes the result of a background load that has finished
+    void finishLoad() const;
+    // Asks before writing over a bank that wasn't read completely. Returns whether to write
+    bool confirmOverwrite() const;
+    void cancelLoad();
+    // Sizes the per-box state for the current box count. Boxes that are already loaded are hashed
+    void resetBoxes(bool loaded);
+    std::array<u8, 32> hashBox(int box) const;
+    bool readNames(const std::string& path);
+    // Reads the JSON array of names that banks used to be paired with
+    bool importJsonNames(const std::string& path);
+    bool saveNames() const;
+    std::string legacyNamesPath() const;
+    std::vector<std::string> boxNames;
+    mutable std::vector<bool> dirtyNames;
+    // How many records the .names file has. If that doesn't match, the whole file is rewritten
+    mutable size_t storedNames = 0;
+    mutable bool legacyNames   = false;
+    // Hash of each box as last loaded or saved, so that only boxes that were written to since
+    // have to be hashed again to see whether anything changed
+    mutable std::vector<std::array<u8, 32>> boxHashes;
+    mutable std::vector<bool> touchedBoxes;
+    std::unique_ptr<std::atomic<bool>[]> loadedBoxes;
+    mutable Threads::Future<bool> loadTask;
+    std::atomic<bool> cancelLoading = false;
+    mutable bool loadFailed         = false;
+    mutable bool failureReported    = false;
     std::string bankName;
     BankHeader header;
     BankEntry* entries      = nullptr;
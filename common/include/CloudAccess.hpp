@@ -30,8 +30,14 @@
 #include "enums/Generation.hpp"
 #include "nlohmann/json_fwd.hpp"
 #include "pkx/PKX.hpp"
+#include <algorithm>
 #include <atomic>
 #include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class Fetch;
 
 class CloudAccess
 {
@@ -42,7 +48,11 @@ public:
         POPULAR
     };
     CloudAccess();
+    // Swaps in pages that were refreshed in the background. Call from the UI thread
+    void update();
     std::unique_ptr<pksm::PKX> pkm(size_t slot) const;
+    // Non-owning view into the decoded page; only valid until the page changes
+    const pksm::PKX* pkmView(size_t slot) const;
     bool isLegal(size_t slot) const;
     // Gets the Pokémon and increments the server-side download counter
     std::unique_ptr<pksm::PKX> fetchPkm(size_t slot) const;
@@ -80,26 +90,63 @@ public:
     bool filterLegal() const { return legal; }
     void filterToGen(pksm::Generation g);
     void removeGenFilter();
+    // How many pages on each side of the current one are kept downloaded ahead of time
+    void prefetchWindow(int pages)
+    {
+        prefetchPages = std::max(pages, 1);
+        prefetch();
+    }
+    int prefetchWindow() const { return prefetchPages; }
     bool good() const { return isGood; }
     int currentPageError() const { return current->siteJsonErrorCode; }
     static std::string makeURL(int page, SortType type, bool ascend, bool legal,
         pksm::Generation low, pksm::Generation high, bool LGPE);
-    nlohmann::json grabPage(int page);
 
 private:
     struct Page
     {
+        struct Entry
+        {
+            std::unique_ptr<pksm::PKX> pkm;
+            std::string code;
+            bool legal = false;
+        };
         ~Page();
-        std::unique_ptr<nlohmann::json> data;
+        // Decoded once when the page arrives, so nothing has to touch JSON or base64 afterwards
+        std::vector<Entry> results;
+        int pages                          = 0;
+        int totalPkm                       = 0;
+        bool good                          = false;
         std::atomic<bool> available        = false;
         std::atomic<int> siteJsonErrorCode = 0;
+        // Newer content found while revalidating a cached page; adopted by update()
+        std::shared_ptr<Page> revalidated;
+        std::atomic<bool> hasRevalidated = false;
+        // In-flight network request, kept so that it can be cancelled
+        std::shared_ptr<Fetch> transfer;
     };
+    static constexpr int DEFAULT_PREFETCH_PAGES = 2;
+    // Prefetches that may be downloading at the same time
+    static constexpr int MAX_PREFETCHES = 2;
     void refreshPages();
+    void clearPages();
+    void prefetch();
+    std::optional<int> switchPage(int offset);
+    int neighbor(int offset) const;
+    int distance(int page) const;
+    std::shared_ptr<Page> startPage(int page);
+    static bool loadPage(Page& page, const nlohmann::json& json);
+    static void waitForPage(const Page& page);
     static void downloadCloudPage(std::shared_ptr<Page> page, int number, SortType type,
         bool ascend, bool legal, pksm::Generation low, pksm::Generation high, bool LGPE);
     static bool pageIsGood(const nlohmann::json& json);
-    std::shared_ptr<Page> current, next, prev;
+    std::shared_ptr<Page> current;
+    // Downloaded or downloading pages by page number, including the current one
+    std::unordered_map<int, std::shared_ptr<Page>> pageCache;
     int pageNumber;
+    // Which way the user last moved, so that prefetching can favor it
+    int direction            = 1;
+    int prefetchPages        = DEFAULT_PREFETCH_PAGES;
     SortType sort            = LATEST;
     bool isGood              = false;
     bool ascend              = true;
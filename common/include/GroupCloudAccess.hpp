@@ -30,18 +30,28 @@
 #include "enums/Generation.hpp"
 #include "nlohmann/json_fwd.hpp"
 #include "pkx/PKX.hpp"
+#include <algorithm>
 #include <atomic>
 #include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class Fetch;
 
 class GroupCloudAccess
 {
 public:
     static constexpr int NUM_GROUPS = 5;
     GroupCloudAccess();
+    // Swaps in pages that were refreshed in the background. Call from the UI thread
+    void update();
     std::vector<std::unique_ptr<pksm::PKX>> group(size_t groupIndex) const;
     std::vector<std::unique_ptr<pksm::PKX>> fetchGroup(size_t groupIndex) const;
     long group(std::vector<std::unique_ptr<pksm::PKX>> pokemon);
     std::unique_ptr<pksm::PKX> pkm(size_t groupIndex, size_t pkm) const;
+    // Non-owning view into the decoded page; only valid until the page changes
+    const pksm::PKX* pkmView(size_t groupIndex, size_t pkm) const;
     std::unique_ptr<pksm::PKX> fetchPkm(size_t groupIndex, size_t pkm) const;
     bool isLegal(size_t groupIndex, size_t pkm) const;
 
@@ -60,28 +70,70 @@ public:
         }
     }
 
+    // How many pages on each side of the current one are kept downloaded ahead of time
+    void prefetchWindow(int pages)
+    {
+        prefetchPages = std::max(pages, 1);
+        prefetch();
+    }
+    int prefetchWindow() const { return prefetchPages; }
     bool good() const { return isGood; }
     int currentPageError() const { return current->siteJsonErrorCode; }
-    nlohmann::json grabPage(int page);
     static std::string makeURL(
         int page, bool legal, pksm::Generation low, pksm::Generation high, bool LGPE);
 
 private:
     struct Page
     {
+        struct Entry
+        {
+            std::unique_ptr<pksm::PKX> pkm;
+            std::string code;
+            bool legal = false;
+        };
+        struct Group
+        {
+            std::vector<Entry> pokemon;
+            std::string code;
+        };
         ~Page();
-        std::unique_ptr<nlohmann::json> data;
+        // Decoded once when the page arrives, so nothing has to touch JSON or base64 afterwards
+        std::vector<Group> results;
+        int pages                          = 0;
+        int totalBundles                   = 0;
+        bool good                          = false;
         std::atomic<bool> available        = false;
         std::atomic<int> siteJsonErrorCode = 0;
+        // Newer content found while revalidating a cached page; adopted by update()
+        std::shared_ptr<Page> revalidated;
+        std::atomic<bool> hasRevalidated = false;
+        // In-flight network request, kept so that it can be cancelled
+        std::shared_ptr<Fetch> transfer;
     };
+    static constexpr int DEFAULT_PREFETCH_PAGES = 2;
+    // Prefetches that may be downloading at the same time
+    static constexpr int MAX_PREFETCHES = 2;
     void refreshPages();
+    void clearPages();
+    void prefetch();
+    std::optional<int> switchPage(int offset);
+    int neighbor(int offset) const;
+    int distance(int page) const;
+    std::shared_ptr<Page> startPage(int page);
+    static bool loadPage(Page& page, const nlohmann::json& json);
+    static void waitForPage(const Page& page);
     static void downloadGroupPage(std::shared_ptr<Page> page, int number, bool legal,
         pksm::Generation low, pksm::Generation high, bool LGPE);
     static bool pageIsGood(const nlohmann::json& page);
-    std::shared_ptr<Page> current, next, prev;
+    std::shared_ptr<Page> current;
+    // Downloaded or downloading pages by page number, including the current one
+    std::unordered_map<int, std::shared_ptr<Page>> pageCache;
     int pageNumber;
-    bool isGood = false;
-    bool legal  = false;
+    // Which way the user last moved, so that prefetching can favor it
+    int direction     = 1;
+    int prefetchPages = DEFAULT_PREFETCH_PAGES;
+    bool isGood       = false;
+    bool legal        = false;
     // Currently not changeable
     pksm::Generation high = pksm::Generation::EIGHT;
     pksm::Generation low  = pksm::Generation::THREE;
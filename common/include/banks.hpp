@@ -33,12 +33,15 @@
 #define BANKS_VERSION 1
 #define BANK_DEFAULT_SIZE 50
 #define BANK_MAX_SIZE 500
+// Bytes that open banks may take up before the least recently used clean ones are closed
+#define BANK_RESIDENCY_BUDGET (8 * 1024 * 1024)
 
 class Bank;
 
 namespace Banks
 {
-    inline std::unique_ptr<Bank> bank = nullptr;
+    // The bank that screens and scripts work on. It is always kept open
+    inline std::shared_ptr<Bank> bank = nullptr;
     Result init();
     Result swapSD(bool toSD);
     Result saveJson();
@@ -47,6 +50,26 @@ namespace Banks
     void renameBank(const std::string& oldName, const std::string& newName);
     void setBankSize(const std::string& name, int size);
     std::vector<std::pair<std::string, int>> bankNames();
+
+    // Several banks can be open at once. Opening one that already is doesn't read it again, and
+    // opening one that isn't closes banks nobody else holds, least recently used first, until the
+    // open banks fit in the residency budget. Clean banks go first; if that isn't enough, banks
+    // with changes are saved and closed too
+    std::shared_ptr<Bank> openBank(const std::string& name);
+    bool isResident(const std::string& name);
+    // Most recently used first
+    std::vector<std::string> residentBanks();
+    size_t residentBytes();
+    size_t residencyBudget();
+    void residencyBudget(size_t bytes);
+    // Exchanges two slots, opening the banks if needed. Returns false if either bank or slot
+    // doesn't exist
+    bool movePkm(const std::string& fromBank, int fromBox, int fromSlot,
+        const std::string& toBank, int toBox, int toSlot);
+    // Saves every open bank with changes
+    void saveChanged();
+    // Reports open banks whose background load failed. Call from the UI thread while not drawing
+    void update();
 }
 
 #endif
@@ -81,6 +81,9 @@ public:
         }
     }
     void dim(void) const;
+    // Retained screens only change in response to input, so their last frame is shown again
+    // instead of being redrawn until then. Anything animated still redraws the screen it's on
+    bool isRetained() const { return retained && (!overlay || overlay->isRetained()); }
     const Instructions& getInstructions() const
     {
         return (overlay && !overlay->getInstructions().empty()) ? overlay->getInstructions()
@@ -91,6 +94,7 @@ protected:
     ReplaceableScreen* parent;
     std::shared_ptr<ReplaceableScreen> overlay = nullptr;
     Instructions instructions;
+    bool retained = false;
 };
 
 #endif
@@ -48,6 +48,11 @@ namespace Gui
 {
     Result init(void);
     void mainLoop(void);
+    // Makes the main loop draw both screens again, for retained screens that changed without input
+    void requestRedraw(void);
+    // Makes the main loop draw the screen being drawn to again next frame, for things that change
+    // on their own
+    void keepAnimating(void);
     void exit(void);
     void frameClean(void);
     template <typename T>
@@ -112,6 +117,8 @@ namespace Gui
     void setScreen(std::unique_ptr<Screen> screen);
     void screenBack(void);
     bool showChoiceMessage(const std::string& message, int timer = 0);
+    // partial and total are in KB
+    void showProgress(const std::string& message, u32 partial, u32 total);
     void showRestoreProgress(u32 partial, u32 total);
     void showDownloadProgress(const std::string& path, u32 partial, u32 total);
     void waitFrame(const std::string& message);
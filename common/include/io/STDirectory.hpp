@@ -31,8 +31,35 @@
 #include <dirent.h>
 #include <errno.h>
 #include <string>
+#include <string_view>
 #include <vector>
 
+// Reads a directory one entry at a time, so that a caller looking for something can stop early and
+// nothing has to be kept around. The implicit . and .. folders and entries whose names don't start
+// with prefix are skipped
+class STDirectoryReader
+{
+public:
+    explicit STDirectoryReader(const std::string& root, std::string_view prefix = "");
+    ~STDirectoryReader();
+    STDirectoryReader(const STDirectoryReader&) = delete;
+    STDirectoryReader& operator=(const STDirectoryReader&) = delete;
+
+    // Moves to the next entry. Returns false once there are none left
+    bool next(void);
+    Result error(void) const;
+    bool good(void) const;
+    // These describe the current entry and are only valid until the next call to next()
+    std::string_view name(void) const;
+    bool folder(void) const;
+
+private:
+    DIR* mDir;
+    struct dirent* mEntry;
+    std::string mPrefix;
+    Result mError;
+};
+
 struct STDirectoryEntry
 {
     STDirectoryEntry(const std::string& name, bool directory) : name(name), directory(directory) {}
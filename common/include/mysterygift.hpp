@@ -34,6 +34,7 @@
 #include "wcx/WCX.hpp"
 #include <bzlib.h>
 #include <string>
+#include <vector>
 
 namespace MysteryGift
 {
@@ -58,9 +59,21 @@ namespace MysteryGift
     };
 
     void init(pksm::Generation gen);
-    std::vector<nlohmann::json> wondercards();
-    giftData wondercardInfo(size_t index);
+    // A match is one gift, made of a wonder card for each language it was released in. This is the
+    // match's card in lang, such as "ENG", or its first card if there isn't one in lang
+    size_t matchCard(size_t match, const std::string& lang);
+    // Language strings mapped to card indices
+    nlohmann::json matchCards(size_t match);
+    bool matchReleased(size_t match);
+    // Stays valid until exit() is called
+    const giftData& wondercardInfo(size_t index);
     std::unique_ptr<pksm::WCX> wondercard(size_t index);
+    // Indices of all matches, or of those with a card in the language, such as "ENG", of the
+    // species, or from the game, such as "ORAS"
+    std::vector<size_t> allMatches();
+    std::vector<size_t> matchesForLanguage(const std::string& lang);
+    std::vector<size_t> matchesForSpecies(int species);
+    std::vector<size_t> matchesForGame(const std::string& game);
     void exit();
 }
 
@@ -119,6 +119,7 @@ void bank_inject_pkx(struct ParseState*, struct Value*, struct Value**, int);
 void bank_get_pkx(struct ParseState*, struct Value*, struct Value**, int);
 void bank_get_size(struct ParseState*, struct Value*, struct Value**, int);
 void bank_select(struct ParseState*, struct Value*, struct Value**, int);
+void bank_move_pkx(struct ParseState*, struct Value*, struct Value**, int);
 // configuration
 void cfg_default_ot(struct ParseState*, struct Value*, struct Value**, int);
 void cfg_default_tid(struct ParseState*, struct Value*, struct Value**, int);
@@ -185,6 +186,17 @@ void pkx_generate(struct ParseState*, struct Value*, struct Value**, int);
 void pkx_is_valid(struct ParseState*, struct Value*, struct Value**, int);
 void pkx_set_value(struct ParseState*, struct Value*, struct Value**, int);
 void pkx_get_value(struct ParseState*, struct Value*, struct Value**, int);
+void pkx_open(struct ParseState*, struct Value*, struct Value**, int);
+void pkx_close(struct ParseState*, struct Value*, struct Value**, int);
+void pkx_handle_get_value(struct ParseState*, struct Value*, struct Value**, int);
+void pkx_handle_set_value(struct ParseState*, struct Value*, struct Value**, int);
+void pkx_get_values(struct ParseState*, struct Value*, struct Value**, int);
+void pkx_set_values(struct ParseState*, struct Value*, struct Value**, int);
+// box queries
+void sav_box_query(struct ParseState*, struct Value*, struct Value**, int);
+void bank_box_query(struct ParseState*, struct Value*, struct Value**, int);
+void sav_box_values(struct ParseState*, struct Value*, struct Value**, int);
+void bank_box_values(struct ParseState*, struct Value*, struct Value**, int);
 // random utilities
 void pksm_utf8_to_ucs2(struct ParseState*, struct Value*, struct Value**, int);
 void pksm_ucs2_to_utf8(struct ParseState*, struct Value*, struct Value**, int);
@@ -208,4 +220,7 @@ void json_array_element(struct ParseState*, struct Value*, struct Value**, int);
 void json_object_contains(struct ParseState*, struct Value*, struct Value**, int);
 void json_object_element(struct ParseState*, struct Value*, struct Value**, int);
 
+// Frees what the script that just ran left open, such as PKX handles. Call after it ends
+void pksm_api_cleanup(void);
+
 #endif
@@ -0,0 +1,43 @@
+/*
+ *   This file is part of PKSM
+ *   Copyright (C) 2016-2020 Bernardo Giordano, Admiral Fish, piepie62
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#ifndef SCRIPTPROFILER_HPP
+#define SCRIPTPROFILER_HPP
+
+#include <string>
+
+// Times every call a PicoC script makes into the pksm.h API. Only one script can be profiled at a
+// time, and start must be called before the script includes pksm.h
+namespace ScriptProfiler
+{
+    void start(void);
+    // Marks the end of one phase of the script, such as parsing, for the report
+    void phase(const std::string& name);
+    // Stops profiling and returns a report of the calls made, slowest in total first
+    std::string stop(void);
+}
+
+#endif
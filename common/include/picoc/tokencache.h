@@ -0,0 +1,44 @@
+/*
+ *   This file is part of PKSM
+ *   Copyright (C) 2016-2020 Bernardo Giordano, Admiral Fish, piepie62
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+
+#ifndef TOKENCACHE_H
+#define TOKENCACHE_H
+
+#include "picoc.h"
+
+/* Part of every cache file's key along with the source's hash. Bump it whenever the token layout
+ * or the pksm.h API changes, so that scripts are lexed again */
+#define PKSM_TOKEN_CACHE_VERSION 1
+
+/* Parses a script like PicocParse with RunIt set. The tokens PicoC lexes it into are written to
+ * CachePath and read back from there instead of lexing again for as long as SourceHash, the
+ * SHA-256 of the source, matches. Source must be kept until PicocCleanup, as the parser still
+ * quotes it in error messages */
+void PicocParseCached(Picoc* pc, const char* FileName, const char* Source, int SourceLen,
+    const unsigned char* SourceHash, const char* CachePath);
+
+#endif
@@ -44,15 +44,40 @@ extern "C" {
 class Fetch
 {
 public:
+    struct DownloadRequest
+    {
+        std::string url;
+        std::string path;
+        std::string postData = "";
+    };
+
     [[nodiscard]] static std::shared_ptr<Fetch> init(const std::string& url, bool ssl,
         std::string* writeData, struct curl_slist* headers, const std::string& postdata);
     static Result download(const std::string& url, const std::string& path,
         const std::string& postData = "", curl_xferinfo_callback progress = nullptr,
         void* progressInfo = nullptr);
+    // Downloads all of the requests at once. progress is called with the totals over all of them.
+    // Data is written to path + ".part" first and only moved to path once complete; an unfinished
+    // part file left behind by a failed GET is resumed with a Range request next time, guarded by
+    // If-Range with the validator kept in path + ".partinfo". Returns the first error, if any
+    static Result downloadMany(const std::vector<DownloadRequest>& requests,
+        curl_xferinfo_callback progress = nullptr, void* progressInfo = nullptr);
 
     static CURLMcode performAsync(std::shared_ptr<Fetch> fetch,
         std::function<void(CURLcode, std::shared_ptr<Fetch>)> onComplete = nullptr);
     static std::variant<CURLMcode, CURLcode> perform(std::shared_ptr<Fetch> fetch);
+    // GETs url through FetchCache. A usable cached response is handed to onComplete before this
+    // returns; unless it's still fresh, it is then revalidated in the background and onComplete is
+    // called a second time, from the network thread, only if the server sent different content.
+    // Without a cached response this behaves like performAsync. If transfer is given, it receives
+    // the network request that was started, if any, so that it can be cancelled. Returns whether
+    // onComplete has been or will be called
+    static bool performCached(const std::string& url, struct curl_slist* headers,
+        std::function<void(CURLcode, long, const std::string&, bool)> onComplete,
+        std::shared_ptr<Fetch>* transfer = nullptr);
+    // Stops a transfer started with performAsync. Unless it had already finished, its completion
+    // callback is called with CURLE_ABORTED_BY_CALLBACK
+    static void cancel(const std::shared_ptr<Fetch>& fetch);
 
     static Result initMulti();
     static void exitMulti();
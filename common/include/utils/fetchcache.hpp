@@ -0,0 +1,64 @@
+/*
+ *   This file is part of PKSM
+ *   Copyright (C) 2016-2020 Bernardo Giordano, Admiral Fish, piepie62, Allen Lydiard
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+
+#ifndef FETCHCACHE_HPP
+#define FETCHCACHE_HPP
+
+#include "coretypes.h"
+#include <optional>
+#include <string>
+#include <time.h>
+
+// On-disk response cache backing Fetch::performCached. Entries are keyed by the request (URL plus
+// any headers that change the response) and evicted least-recently-used once the configured size
+// is exceeded.
+namespace FetchCache
+{
+    struct Entry
+    {
+        std::string body;
+        std::string etag;
+        std::string lastModified;
+        time_t stored = 0;
+        u32 maxAge    = 0;
+
+        // Whether the entry can be used without asking the server
+        bool fresh() const { return time(nullptr) - stored < (time_t)maxAge; }
+    };
+
+    void init(const std::string& root, size_t maxBytes);
+    void exit(void);
+    bool initialized(void);
+
+    std::optional<Entry> get(const std::string& key);
+    void put(const std::string& key, const Entry& entry);
+    // Marks an entry as just revalidated without rewriting its body
+    void touch(const std::string& key, u32 maxAge);
+    void remove(const std::string& key);
+}
+
+#endif
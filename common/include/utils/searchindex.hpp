@@ -0,0 +1,92 @@
+/*
+ *   This file is part of PKSM
+ *   Copyright (C) 2016-2020 Bernardo Giordano, Admiral Fish, piepie62
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+
+#ifndef SEARCHINDEX_HPP
+#define SEARCHINDEX_HPP
+
+#include "coretypes.h"
+#include "enums/Generation.hpp"
+#include "enums/Language.hpp"
+#include "enums/Species.hpp"
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Name lookup for the picker overlays. Names are compared case- and diacritic-insensitively, and as
+// matching is only ever by prefix, every search result is a contiguous run of the sorted names.
+// The shared indices are built the first time they're asked for and kept for the session
+class SearchIndex
+{
+public:
+    class Matches
+    {
+    public:
+        bool contains(u16 id) const
+        {
+            return id < index->ranks.size() && index->ranks[id] >= first &&
+                   index->ranks[id] < last;
+        }
+        size_t size() const { return last - first; }
+
+    private:
+        friend class SearchIndex;
+        Matches(const SearchIndex* index, size_t first, size_t last)
+            : index(index), first(first), last(last)
+        {
+        }
+        const SearchIndex* index;
+        size_t first;
+        size_t last;
+    };
+
+    explicit SearchIndex(const std::vector<std::pair<u16, std::string>>& names);
+
+    // All ids, ordered by folded name
+    const std::vector<u16>& sorted() const { return ids; }
+    Matches find(const std::string& prefix) const;
+
+    // Lowercases and strips diacritics, and maps full-width Latin to ASCII and katakana to hiragana
+    static std::string fold(const std::string& str);
+
+    static const SearchIndex& moves(pksm::Language lang);
+    // Generation three has its own item table
+    static const SearchIndex& items(pksm::Language lang, pksm::Generation gen);
+    static const SearchIndex& locations(pksm::Language lang, pksm::Generation gen);
+    // Grown as needed to cover every species in available
+    static const SearchIndex& species(
+        pksm::Language lang, const std::set<pksm::Species>& available);
+
+private:
+    static constexpr size_t NOT_INDEXED = ~size_t(0);
+    std::vector<std::string> keys;
+    std::vector<u16> ids;
+    // Position of each id in keys and ids
+    std::vector<size_t> ranks;
+};
+
+#endif
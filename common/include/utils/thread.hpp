@@ -28,20 +28,198 @@
 #define THREAD_HPP
 
 #include "coretypes.h"
+#include <atomic>
+#include <memory>
 #include <optional>
+#include <type_traits>
+#include <utility>
 
 namespace Threads
 {
     static constexpr int MAX_THREADS = 32;
 
-    bool init(u8 workers);
+    // Queued tasks of a higher priority class are always started before those of a lower one
+    enum class Priority : u8
+    {
+        // Something the user is waiting on
+        UI,
+        NORMAL,
+        // Prefetching and other work nobody is waiting on yet
+        BACKGROUND
+    };
+    static constexpr size_t PRIORITIES = 3;
+
+    // Starts one task worker for each CPU core the application may use
+    bool init(void);
     // stackSize will be ignored on systems that don't provide explicit setting of it. KEEP THIS IN
     // MIND IF YOU ARE PORTING
     bool create(void (*entrypoint)(void*), void* arg = nullptr,
         std::optional<size_t> stackSize = std::nullopt);
-    // Executes task on a worker thread with stack size of 0x8000 (if settable).
-    void executeTask(void (*task)(void*), void* arg);
     void exit(void);
+
+    // Event. wait() blocks until signal() is called. An auto-resetting event wakes one waiter and
+    // keeps a signal sent while nobody is waiting for the next wait(); otherwise it stays signaled
+    class Event
+    {
+    public:
+        explicit Event(bool autoReset = true);
+        ~Event();
+        Event(const Event&) = delete;
+        Event& operator=(const Event&) = delete;
+
+        void signal();
+        void wait();
+
+    private:
+        void* event;
+    };
+
+    namespace internal
+    {
+        class Job
+        {
+        public:
+            virtual ~Job() = default;
+            virtual void run() = 0;
+            // Called instead of run() for jobs still queued when the workers stop
+            virtual void cancel() = 0;
+        };
+
+        enum class JobState : u8
+        {
+            WAITING,
+            RUNNING,
+            DONE,
+            CANCELLED
+        };
+
+        template <typename T>
+        struct FutureState
+        {
+            template <typename F>
+            void set(F& func)
+            {
+                value.emplace(func());
+            }
+            std::atomic<JobState> state = JobState::WAITING;
+            Event done{false};
+            std::optional<T> value;
+        };
+
+        template <>
+        struct FutureState<void>
+        {
+            template <typename F>
+            void set(F& func)
+            {
+                func();
+            }
+            std::atomic<JobState> state = JobState::WAITING;
+            Event done{false};
+        };
+
+        template <typename F, typename T>
+        class FutureJob : public Job
+        {
+        public:
+            FutureJob(F&& func, std::shared_ptr<FutureState<T>> state)
+                : func(std::move(func)), state(std::move(state))
+            {
+            }
+            void run() override
+            {
+                JobState expected = JobState::WAITING;
+                if (state->state.compare_exchange_strong(expected, JobState::RUNNING))
+                {
+                    state->set(func);
+                    state->state = JobState::DONE;
+                    state->done.signal();
+                }
+            }
+            void cancel() override
+            {
+                JobState expected = JobState::WAITING;
+                if (state->state.compare_exchange_strong(expected, JobState::CANCELLED))
+                {
+                    state->done.signal();
+                }
+            }
+
+        private:
+            F func;
+            std::shared_ptr<FutureState<T>> state;
+        };
+
+        void schedule(std::unique_ptr<Job> job, Priority priority);
+        // Runs one queued job if called from a task worker and there is one. Returns whether it did
+        bool runQueuedJob(void);
+    }
+
+    // Completion token for a task given to executeTask. Copies refer to the same task
+    template <typename T>
+    class Future
+    {
+    public:
+        Future() = default;
+        explicit Future(std::shared_ptr<internal::FutureState<T>> state) : state(std::move(state))
+        {
+        }
+
+        bool valid() const { return state != nullptr; }
+        // Whether the task has finished or was cancelled
+        bool ready() const
+        {
+            internal::JobState current = state->state;
+            return current == internal::JobState::DONE ||
+                   current == internal::JobState::CANCELLED;
+        }
+        // Blocks until the task has finished or was cancelled and returns whether it finished. A
+        // task worker that waits runs other queued tasks in the meantime, so tasks may wait on
+        // tasks they start without running out of workers
+        bool wait() const
+        {
+            while (!ready() && internal::runQueuedJob()) {}
+            state->done.wait();
+            return state->state == internal::JobState::DONE;
+        }
+        // The task's result. Only valid once wait() has returned true
+        template <typename U = T, typename = std::enable_if_t<!std::is_void_v<U>>>
+        U& get() const
+        {
+            wait();
+            return *state->value;
+        }
+        // Keeps the task from running if it hasn't started yet. Returns whether it was cancelled
+        bool cancel()
+        {
+            internal::JobState expected = internal::JobState::WAITING;
+            if (state->state.compare_exchange_strong(expected, internal::JobState::CANCELLED))
+            {
+                state->done.signal();
+                return true;
+            }
+            return false;
+        }
+
+    private:
+        std::shared_ptr<internal::FutureState<T>> state;
+    };
+
+    // Runs func on a task worker with stack size of 0x8000 (if settable). func may be move-only;
+    // its result is available from the returned Future. Tasks started from a task worker are
+    // queued on that worker, and idle workers take tasks from busy ones
+    template <typename F>
+    auto executeTask(F&& func, Priority priority = Priority::NORMAL)
+        -> Future<std::invoke_result_t<std::decay_t<F>&>>
+    {
+        using Func   = std::decay_t<F>;
+        using Result = std::invoke_result_t<Func&>;
+        auto state   = std::make_shared<internal::FutureState<Result>>();
+        internal::schedule(
+            std::make_unique<internal::FutureJob<Func, Result>>(Func(std::forward<F>(func)), state),
+            priority);
+        return Future<Result>(std::move(state));
+    }
 }
 
 #endif
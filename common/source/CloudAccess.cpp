@@ -55,40 +55,43 @@ CloudAccess::Page::~Page() {}
 void CloudAccess::downloadCloudPage(std::shared_ptr<Page> page, int number, SortType type,
     bool ascend, bool legal, pksm::Generation low, pksm::Generation high, bool LGPE)
 {
-    std::string* retData = new std::string;
-    auto fetch = Fetch::init(CloudAccess::makeURL(number, type, ascend, legal, low, high, LGPE),
-        true, retData, nullptr, "");
-    Fetch::performAsync(fetch, [page, retData](CURLcode code, std::shared_ptr<Fetch> fetch) {
-        if (code == CURLE_OK)
-        {
-            long status_code;
-            fetch->getinfo(CURLINFO_RESPONSE_CODE, &status_code);
-            switch (status_code)
-            {
-                case 200:
-                    page->data = std::make_unique<nlohmann::json>(
-                        nlohmann::json::parse(*retData, nullptr, false));
-                    if (!page->data || !pageIsGood(*page->data))
+    if (!Fetch::performCached(CloudAccess::makeURL(number, type, ascend, legal, low, high, LGPE),
+            nullptr, [page](CURLcode code, long status, const std::string& body, bool) {
+                if (!page->available)
+                {
+                    if (code == CURLE_OK && (status == 200 || status == 401))
                     {
-                        page->data = nullptr;
+                        loadPage(*page, nlohmann::json::parse(body, nullptr, false));
                     }
-                    break;
-                case 401:
+                    page->available = true;
+                }
+                else
                 {
-                    nlohmann::json retJson = nlohmann::json::parse(*retData, nullptr, false);
-                    if (retJson.contains("error_code") && retJson["error_code"].is_number_integer())
+                    // A background revalidation brought new content. The page may already be on
+                    // screen, so update() swaps it in rather than it being changed in place
+                    auto fresh = std::make_shared<Page>();
+                    if (code == CURLE_OK && status == 200 &&
+                        loadPage(*fresh, nlohmann::json::parse(body, nullptr, false)))
                     {
-                        page->siteJsonErrorCode = retJson["error_code"].get<int>();
+                        fresh->available     = true;
+                        page->revalidated    = fresh;
+                        page->hasRevalidated = true;
                     }
                 }
-                break;
-                default:
-                    break;
-            }
-        }
-        delete retData;
+            },
+            &page->transfer))
+    {
         page->available = true;
-    });
+    }
+}
+
+void CloudAccess::waitForPage(const Page& page)
+{
+    while (!page.available)
+    {
+        constexpr timespec sleepTime = {0, 100000};
+        nanosleep(&sleepTime, nullptr);
+    }
 }
 
 CloudAccess::CloudAccess() : pageNumber(1)
@@ -98,92 +101,197 @@ CloudAccess::CloudAccess() : pageNumber(1)
 
 void CloudAccess::refreshPages()
 {
-    current            = std::make_shared<Page>();
-    current->data      = std::make_unique<nlohmann::json>(grabPage(pageNumber));
-    current->available = true;
-    if (current->data)
+    clearPages();
+    current = startPage(pageNumber);
+    waitForPage(*current);
+    isGood = current->good;
+    if (isGood && pageNumber > pages())
     {
-        if (pageIsGood(*current->data))
+        clearPages();
+        pageNumber = pages();
+        current    = startPage(pageNumber);
+        waitForPage(*current);
+        isGood = current->good;
+    }
+    prefetch();
+}
+
+void CloudAccess::clearPages()
+{
+    for (auto& [number, page] : pageCache)
+    {
+        if (!page->available)
         {
-            isGood = true;
+            Fetch::cancel(page->transfer);
         }
-        else
+    }
+    pageCache.clear();
+}
+
+std::shared_ptr<CloudAccess::Page> CloudAccess::startPage(int number)
+{
+    auto page = std::make_shared<Page>();
+    downloadCloudPage(page, number, sort, ascend, legal, lowGen, highGen, showLGPE);
+    pageCache[number] = page;
+    return page;
+}
+
+int CloudAccess::neighbor(int offset) const
+{
+    int count = pages();
+    if (count < 1)
+    {
+        return pageNumber;
+    }
+    return ((pageNumber - 1 + offset) % count + count) % count + 1;
+}
+
+int CloudAccess::distance(int number) const
+{
+    int count = pages();
+    if (count < 1)
+    {
+        return 0;
+    }
+    int forward = ((number - pageNumber) % count + count) % count;
+    return std::min(forward, count - forward);
+}
+
+void CloudAccess::prefetch()
+{
+    if (!isGood || pages() < 1)
+    {
+        return;
+    }
+
+    // Pages ahead in the direction the user is moving come first
+    std::vector<int> wanted;
+    for (int side : {direction, -direction})
+    {
+        for (int i = 1; i <= prefetchPages; i++)
         {
-            isGood = false;
-            if (current->data->contains("error_code") &&
-                (*current->data)["error_code"].is_number_integer())
+            int number = neighbor(side * i);
+            if (number != pageNumber &&
+                std::find(wanted.begin(), wanted.end(), number) == wanted.end())
             {
-                current->siteJsonErrorCode = (*current->data)["error_code"].get<int>();
-                current->data              = nullptr;
+                wanted.emplace_back(number);
             }
         }
     }
-    if (isGood && pageNumber >= pages())
+
+    int inFlight = 0;
+    for (auto it = pageCache.begin(); it != pageCache.end();)
     {
-        pageNumber         = pages();
-        current->data      = std::make_unique<nlohmann::json>(grabPage(pages()));
-        current->available = true;
-        if (current->data)
+        auto& page = it->second;
+        if (page->available)
         {
-            if (pageIsGood(*current->data))
-            {
-                isGood = true;
-            }
-            else
-            {
-                isGood = false;
-                if (current->data->contains("error_code") &&
-                    (*current->data)["error_code"].is_number_integer())
-                {
-                    current->siteJsonErrorCode = (*current->data)["error_code"].get<int>();
-                    current->data              = nullptr;
-                }
-            }
+            page->transfer = nullptr;
+            ++it;
+        }
+        else if (page != current &&
+                 std::find(wanted.begin(), wanted.end(), it->first) == wanted.end())
+        {
+            // Scrolled out of the window before it arrived; not worth finishing
+            Fetch::cancel(page->transfer);
+            it = pageCache.erase(it);
+        }
+        else
+        {
+            inFlight++;
+            ++it;
         }
     }
-    if (isGood)
+
+    for (int number : wanted)
     {
-        if (pages() > 1)
+        if (inFlight >= MAX_PREFETCHES)
         {
-            int page = (pageNumber % pages()) + 1;
-            next     = std::make_shared<Page>();
-            downloadCloudPage(next, page, sort, ascend, legal, lowGen, highGen, showLGPE);
-            if (pages() > 2)
-            {
-                page = pageNumber - 1 == 0 ? pages() : pageNumber - 1;
-                prev = std::make_shared<Page>();
-                downloadCloudPage(prev, page, sort, ascend, legal, lowGen, highGen, showLGPE);
-            }
-            else
-            {
-                prev = next;
-            }
+            break;
         }
-        else
+        if (!pageCache.count(number))
         {
-            next = prev = current;
+            startPage(number);
+            inFlight++;
         }
     }
+
+    // Keep the window plus a little slack for quick reversals; drop whatever is farthest away
+    const size_t maxPages = 2 * prefetchPages + 3;
+    while (pageCache.size() > maxPages)
+    {
+        auto farthest = std::max_element(pageCache.begin(), pageCache.end(),
+            [this](const auto& a, const auto& b) { return distance(a.first) < distance(b.first); });
+        if (farthest->second == current)
+        {
+            break;
+        }
+        if (!farthest->second->available)
+        {
+            Fetch::cancel(farthest->second->transfer);
+        }
+        pageCache.erase(farthest);
+    }
 }
 
-nlohmann::json CloudAccess::grabPage(int num)
+void CloudAccess::update()
 {
-    std::string retData;
-    auto fetch = Fetch::init(
-        makeURL(num, sort, ascend, legal, lowGen, highGen, showLGPE), true, &retData, nullptr, "");
-    auto res = Fetch::perform(fetch);
-    if (res.index() == 0)
+    if (!isGood)
     {
-        return {};
+        return;
     }
-    else if (std::get<1>(res) == CURLE_OK)
+    for (auto& [number, page] : pageCache)
     {
-        return nlohmann::json::parse(retData, nullptr, false);
+        if (page != current && page->hasRevalidated)
+        {
+            page = page->revalidated;
+        }
     }
-    else
+    if (current->hasRevalidated)
     {
-        return {};
+        int oldTotal          = current->totalPkm;
+        current               = current->revalidated;
+        pageCache[pageNumber] = current;
+        // Everything may have shifted around, so the other pages have to be redone
+        if (current->totalPkm != oldTotal)
+        {
+            refreshPages();
+            return;
+        }
     }
+    prefetch();
+}
+
+bool CloudAccess::loadPage(Page& page, const nlohmann::json& json)
+{
+    if (!pageIsGood(json))
+    {
+        if (json.is_object() && json.contains("error_code") &&
+            json["error_code"].is_number_integer())
+        {
+            page.siteJsonErrorCode = json["error_code"].get<int>();
+        }
+        return page.good = false;
+    }
+
+    page.pages    = json["pages"].get<int>();
+    page.totalPkm = json["total_pkm"].get<int>();
+    page.results.clear();
+    page.results.reserve(json["results"].size());
+    for (const auto& result : json["results"])
+    {
+        const std::string& b64Data = result["base_64"].get_ref<const std::string&>();
+        pksm::Generation gen =
+            pksm::Generation::fromString(result["generation"].get_ref<const std::string&>());
+        // Legal info: needs thought
+        auto data = base64_decode(b64Data.data(), b64Data.size());
+
+        auto& entry = page.results.emplace_back();
+        entry.pkm   = pksm::PKX::getPKM(gen, data.data(), data.size());
+        entry.code  = result["code"].get<std::string>();
+        entry.legal = result["legal"].get<bool>();
+    }
+
+    return page.good = true;
 }
 
 std::string CloudAccess::makeURL(int num, SortType type, bool ascend, bool legal,
@@ -199,42 +307,40 @@ std::string CloudAccess::makeURL(int num, SortType type, bool ascend, bool legal
 
 std::unique_ptr<pksm::PKX> CloudAccess::pkm(size_t slot) const
 {
-    if (slot < (*current->data)["results"].size())
+    if (const pksm::PKX* ret = pkmView(slot))
     {
-        std::string b64Data  = (*current->data)["results"][slot]["base_64"].get<std::string>();
-        pksm::Generation gen = pksm::Generation::fromString(
-            (*current->data)["results"][slot]["generation"].get<std::string>());
-        // Legal info: needs thought
-        auto retData = base64_decode(b64Data.data(), b64Data.size());
-
-        auto ret = pksm::PKX::getPKM(gen, retData.data(), retData.size());
-        if (ret)
-        {
-            return ret;
-        }
+        return ret->clone();
     }
     return pksm::PKX::getPKM<pksm::Generation::SEVEN>(nullptr);
 }
 
+const pksm::PKX* CloudAccess::pkmView(size_t slot) const
+{
+    if (slot < current->results.size())
+    {
+        return current->results[slot].pkm.get();
+    }
+    return nullptr;
+}
+
 bool CloudAccess::isLegal(size_t slot) const
 {
-    if (slot < (*current->data)["results"].size())
+    if (slot < current->results.size())
     {
-        return (*current->data)["results"][slot]["legal"].get<bool>();
+        return current->results[slot].legal;
     }
     return false;
 }
 
 std::unique_ptr<pksm::PKX> CloudAccess::fetchPkm(size_t slot) const
 {
-    if (slot < (*current->data)["results"].size())
+    if (slot < current->results.size())
     {
         auto ret = pkm(slot);
 
-        if (auto fetch =
-                Fetch::init("https://flagbrew.org/gpss/download/" +
-                                (*current->data)["results"][slot]["code"].get<std::string>(),
-                    true, nullptr, nullptr, ""))
+        if (auto fetch = Fetch::init(
+                "https://flagbrew.org/gpss/download/" + current->results[slot].code, true, nullptr,
+                nullptr, ""))
         {
             Fetch::performAsync(fetch);
         }
@@ -246,65 +352,46 @@ std::unique_ptr<pksm::PKX> CloudAccess::fetchPkm(size_t slot) const
 
 std::optional<int> CloudAccess::nextPage()
 {
-    while (!next->available)
-    {
-        constexpr timespec sleepTime = {0, 100000};
-        nanosleep(&sleepTime, nullptr);
-    }
-    if (!next->data || next->data->is_discarded())
-    {
-        isGood = false;
-        return next->siteJsonErrorCode;
-    }
-    // Update data
-    pageNumber = (pageNumber % pages()) + 1;
-    prev       = current;
-    current    = next;
-    next       = std::make_shared<Page>();
-
-    // Download next page in the background
-    int nextPage = (pageNumber % pages()) + 1;
-    downloadCloudPage(next, nextPage, sort, ascend, legal, lowGen, highGen, showLGPE);
-
-    // If there's a mon number desync, also download the previous page again
-    if ((*current->data)["total_pkm"] != (*prev->data)["total_pkm"])
-    {
-        int prevPage = pageNumber - 1 == 0 ? pages() : pageNumber - 1;
-        downloadCloudPage(prev, prevPage, sort, ascend, legal, lowGen, highGen, showLGPE);
-    }
-
-    return std::nullopt;
+    return switchPage(1);
 }
 
 std::optional<int> CloudAccess::prevPage()
 {
-    while (!prev->available)
+    return switchPage(-1);
+}
+
+std::optional<int> CloudAccess::switchPage(int offset)
+{
+    update();
+    if (!isGood)
     {
-        constexpr timespec sleepTime = {0, 100000};
-        nanosleep(&sleepTime, nullptr);
+        return current->siteJsonErrorCode;
     }
-    if (!prev->data || prev->data->is_discarded())
+
+    int number = neighbor(offset);
+    auto found = pageCache.find(number);
+    auto page  = found != pageCache.end() ? found->second : startPage(number);
+    waitForPage(*page);
+    if (!page->good)
     {
         isGood = false;
-        return prev->siteJsonErrorCode;
+        return page->siteJsonErrorCode;
     }
-    // Update data
-    pageNumber = pageNumber - 1 == 0 ? pages() : pageNumber - 1;
-    next       = current;
-    current    = prev;
-    prev       = std::make_shared<Page>();
-
-    // Download the next page in the background
-    int prevPage = pageNumber - 1 == 0 ? pages() : pageNumber - 1;
-    downloadCloudPage(prev, prevPage, sort, ascend, legal, lowGen, highGen, showLGPE);
-
-    // If there's a mon number desync, also download the next page again
-    if ((*current->data)["total_pkm"] != (*next->data)["total_pkm"])
+
+    int oldTotal = current->totalPkm;
+    pageNumber   = number;
+    current      = page;
+    direction    = offset > 0 ? 1 : -1;
+
+    // If there's a mon number desync, everything else that was downloaded is out of date
+    if (current->totalPkm != oldTotal)
     {
-        int nextPage = (pageNumber % pages()) + 1;
-        downloadCloudPage(next, nextPage, sort, ascend, legal, lowGen, highGen, showLGPE);
+        clearPages();
+        pageCache[pageNumber] = current;
     }
 
+    prefetch();
+
     return std::nullopt;
 }
 
@@ -351,7 +438,7 @@ long CloudAccess::pkm(std::unique_ptr<pksm::PKX> mon)
 
 int CloudAccess::pages() const
 {
-    return (*current->data)["pages"].get<int>();
+    return current->pages;
 }
 
 void CloudAccess::filterToGen(pksm::Generation g)
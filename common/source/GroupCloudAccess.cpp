@@ -43,42 +43,43 @@ GroupCloudAccess::Page::~Page() {}
 void GroupCloudAccess::downloadGroupPage(std::shared_ptr<Page> page, int number, bool legal,
     pksm::Generation low, pksm::Generation high, bool LGPE)
 {
-    std::string* retData = new std::string;
-    auto fetch           = Fetch::init(
-        GroupCloudAccess::makeURL(number, legal, low, high, LGPE), true, retData, nullptr, "");
-    Fetch::performAsync(fetch, [page, retData](CURLcode code, std::shared_ptr<Fetch> fetch) {
-        if (code == CURLE_OK)
-        {
-            long status_code;
-            fetch->getinfo(CURLINFO_RESPONSE_CODE, &status_code);
-            switch (status_code)
-            {
-                case 200:
-                    page->data = std::make_unique<nlohmann::json>(
-                        nlohmann::json::parse(*retData, nullptr, false));
-                    // clang-format off
-                    if (!page->data || !pageIsGood(*page->data))
-                    // clang-format on
+    if (!Fetch::performCached(GroupCloudAccess::makeURL(number, legal, low, high, LGPE), nullptr,
+            [page](CURLcode code, long status, const std::string& body, bool) {
+                if (!page->available)
+                {
+                    if (code == CURLE_OK && (status == 200 || status == 401))
                     {
-                        page->data = nullptr;
+                        loadPage(*page, nlohmann::json::parse(body, nullptr, false));
                     }
-                    break;
-                case 401:
+                    page->available = true;
+                }
+                else
                 {
-                    nlohmann::json retJson = nlohmann::json::parse(*retData, nullptr, false);
-                    if (retJson.contains("error_code") && retJson["error_code"].is_number_integer())
+                    // A background revalidation brought new content. The page may already be on
+                    // screen, so update() swaps it in rather than it being changed in place
+                    auto fresh = std::make_shared<Page>();
+                    if (code == CURLE_OK && status == 200 &&
+                        loadPage(*fresh, nlohmann::json::parse(body, nullptr, false)))
                     {
-                        page->siteJsonErrorCode = retJson["error_code"].get<int>();
+                        fresh->available     = true;
+                        page->revalidated    = fresh;
+                        page->hasRevalidated = true;
                     }
                 }
-                break;
-                default:
-                    break;
-            }
-        }
-        delete retData;
+            },
+            &page->transfer))
+    {
         page->available = true;
-    });
+    }
+}
+
+void GroupCloudAccess::waitForPage(const Page& page)
+{
+    while (!page.available)
+    {
+        constexpr timespec sleepTime = {0, 100000};
+        nanosleep(&sleepTime, nullptr);
+    }
 }
 
 GroupCloudAccess::GroupCloudAccess() : pageNumber(1)
@@ -88,91 +89,201 @@ GroupCloudAccess::GroupCloudAccess() : pageNumber(1)
 
 void GroupCloudAccess::refreshPages()
 {
-    current            = std::make_shared<Page>();
-    current->data      = std::make_unique<nlohmann::json>(grabPage(pageNumber));
-    current->available = true;
-    if (current->data)
+    clearPages();
+    current = startPage(pageNumber);
+    waitForPage(*current);
+    isGood = current->good;
+    if (isGood && pageNumber > pages())
+    {
+        clearPages();
+        pageNumber = pages();
+        current    = startPage(pageNumber);
+        waitForPage(*current);
+        isGood = current->good;
+    }
+    prefetch();
+}
+
+void GroupCloudAccess::clearPages()
+{
+    for (auto& [number, page] : pageCache)
     {
-        if (pageIsGood(*current->data))
+        if (!page->available)
         {
-            isGood = true;
+            Fetch::cancel(page->transfer);
         }
-        else
+    }
+    pageCache.clear();
+}
+
+std::shared_ptr<GroupCloudAccess::Page> GroupCloudAccess::startPage(int number)
+{
+    auto page = std::make_shared<Page>();
+    downloadGroupPage(page, number, legal, low, high, LGPE);
+    pageCache[number] = page;
+    return page;
+}
+
+int GroupCloudAccess::neighbor(int offset) const
+{
+    int count = pages();
+    if (count < 1)
+    {
+        return pageNumber;
+    }
+    return ((pageNumber - 1 + offset) % count + count) % count + 1;
+}
+
+int GroupCloudAccess::distance(int number) const
+{
+    int count = pages();
+    if (count < 1)
+    {
+        return 0;
+    }
+    int forward = ((number - pageNumber) % count + count) % count;
+    return std::min(forward, count - forward);
+}
+
+void GroupCloudAccess::prefetch()
+{
+    if (!isGood || pages() < 1)
+    {
+        return;
+    }
+
+    // Pages ahead in the direction the user is moving come first
+    std::vector<int> wanted;
+    for (int side : {direction, -direction})
+    {
+        for (int i = 1; i <= prefetchPages; i++)
         {
-            isGood = false;
-            if (current->data->contains("error_code") &&
-                (*current->data)["error_code"].is_number_integer())
+            int number = neighbor(side * i);
+            if (number != pageNumber &&
+                std::find(wanted.begin(), wanted.end(), number) == wanted.end())
             {
-                current->siteJsonErrorCode = (*current->data)["error_code"].get<int>();
-                current->data              = nullptr;
+                wanted.emplace_back(number);
             }
         }
     }
-    if (isGood && pageNumber >= pages())
+
+    int inFlight = 0;
+    for (auto it = pageCache.begin(); it != pageCache.end();)
     {
-        pageNumber         = pages();
-        current->data      = std::make_unique<nlohmann::json>(grabPage(pages()));
-        current->available = true;
-        if (current->data)
+        auto& page = it->second;
+        if (page->available)
         {
-            if (pageIsGood(*current->data))
-            {
-                isGood = true;
-            }
-            else
-            {
-                isGood = false;
-                if (current->data->contains("error_code") &&
-                    (*current->data)["error_code"].is_number_integer())
-                {
-                    current->siteJsonErrorCode = (*current->data)["error_code"].get<int>();
-                    current->data              = nullptr;
-                }
-            }
+            page->transfer = nullptr;
+            ++it;
+        }
+        else if (page != current &&
+                 std::find(wanted.begin(), wanted.end(), it->first) == wanted.end())
+        {
+            // Scrolled out of the window before it arrived; not worth finishing
+            Fetch::cancel(page->transfer);
+            it = pageCache.erase(it);
+        }
+        else
+        {
+            inFlight++;
+            ++it;
         }
     }
-    if (isGood)
+
+    for (int number : wanted)
     {
-        if (pages() > 1)
+        if (inFlight >= MAX_PREFETCHES)
         {
-            int page = (pageNumber % pages()) + 1;
-            next     = std::make_shared<Page>();
-            downloadGroupPage(next, page, legal, low, high, LGPE);
-            if (pages() > 2)
-            {
-                page = pageNumber - 1 == 0 ? pages() : pageNumber - 1;
-                prev = std::make_shared<Page>();
-                downloadGroupPage(prev, page, legal, low, high, LGPE);
-            }
-            else
-            {
-                prev = next;
-            }
+            break;
         }
-        else
+        if (!pageCache.count(number))
+        {
+            startPage(number);
+            inFlight++;
+        }
+    }
+
+    // Keep the window plus a little slack for quick reversals; drop whatever is farthest away
+    const size_t maxPages = 2 * prefetchPages + 3;
+    while (pageCache.size() > maxPages)
+    {
+        auto farthest = std::max_element(pageCache.begin(), pageCache.end(),
+            [this](const auto& a, const auto& b) { return distance(a.first) < distance(b.first); });
+        if (farthest->second == current)
         {
-            next = prev = current;
+            break;
         }
+        if (!farthest->second->available)
+        {
+            Fetch::cancel(farthest->second->transfer);
+        }
+        pageCache.erase(farthest);
     }
 }
 
-nlohmann::json GroupCloudAccess::grabPage(int num)
+void GroupCloudAccess::update()
 {
-    std::string retData;
-    auto fetch = Fetch::init(makeURL(num, legal, low, high, LGPE), true, &retData, nullptr, "");
-    auto res   = Fetch::perform(fetch);
-    if (res.index() == 0)
+    if (!isGood)
     {
-        return {};
+        return;
     }
-    else if (std::get<1>(res) == CURLE_OK)
+    for (auto& [number, page] : pageCache)
     {
-        return nlohmann::json::parse(retData, nullptr, false);
+        if (page != current && page->hasRevalidated)
+        {
+            page = page->revalidated;
+        }
     }
-    else
+    if (current->hasRevalidated)
     {
-        return {};
+        int oldTotal          = current->totalBundles;
+        current               = current->revalidated;
+        pageCache[pageNumber] = current;
+        // Everything may have shifted around, so the other pages have to be redone
+        if (current->totalBundles != oldTotal)
+        {
+            refreshPages();
+            return;
+        }
     }
+    prefetch();
+}
+
+bool GroupCloudAccess::loadPage(Page& page, const nlohmann::json& json)
+{
+    if (!pageIsGood(json))
+    {
+        if (json.is_object() && json.contains("error_code") &&
+            json["error_code"].is_number_integer())
+        {
+            page.siteJsonErrorCode = json["error_code"].get<int>();
+        }
+        return page.good = false;
+    }
+
+    page.pages        = json["pages"].get<int>();
+    page.totalBundles = json["total_bundles"].get<int>();
+    page.results.clear();
+    page.results.reserve(json["results"].size());
+    for (const auto& jsonGroup : json["results"])
+    {
+        auto& group = page.results.emplace_back();
+        group.code  = jsonGroup["code"].get<std::string>();
+        group.pokemon.reserve(jsonGroup["pokemon"].size());
+        for (const auto& poke : jsonGroup["pokemon"])
+        {
+            std::vector<u8> data = base64_decode(poke["base64"].get_ref<const std::string&>());
+            pksm::Generation gen =
+                pksm::Generation::fromString(poke["generation"].get_ref<const std::string&>());
+
+            auto& entry = group.pokemon.emplace_back();
+            entry.pkm   = pksm::PKX::getPKM(gen, data.data(), data.size());
+            entry.code  = poke["code"].get<std::string>();
+            entry.legal = poke["legal"].get<bool>();
+        }
+    }
+
+    return page.good = true;
 }
 
 std::string GroupCloudAccess::makeURL(
@@ -186,103 +297,84 @@ std::string GroupCloudAccess::makeURL(
 
 std::optional<int> GroupCloudAccess::nextPage()
 {
-    while (!next->available)
-    {
-        constexpr timespec sleepTime = {0, 100000};
-        nanosleep(&sleepTime, nullptr);
-    }
-    if (!next->data || next->data->is_discarded())
-    {
-        isGood = false;
-        return next->siteJsonErrorCode;
-    }
-    // Update data
-    pageNumber = (pageNumber % pages()) + 1;
-    prev       = current;
-    current    = next;
-    next       = std::make_shared<Page>();
-
-    // Download next page in the background
-    int nextPage = (pageNumber % pages()) + 1;
-    downloadGroupPage(next, nextPage, legal, low, high, LGPE);
-
-    // If there's a mon number desync, also download the previous page again
-    if ((*current->data)["total_bundles"] != (*prev->data)["total_bundles"])
-    {
-        int prevPage = pageNumber - 1 == 0 ? pages() : pageNumber - 1;
-        downloadGroupPage(prev, prevPage, legal, low, high, LGPE);
-    }
-
-    return std::nullopt;
+    return switchPage(1);
 }
 
 std::optional<int> GroupCloudAccess::prevPage()
 {
-    while (!prev->available)
+    return switchPage(-1);
+}
+
+std::optional<int> GroupCloudAccess::switchPage(int offset)
+{
+    update();
+    if (!isGood)
     {
-        constexpr timespec sleepTime = {0, 100000};
-        nanosleep(&sleepTime, nullptr);
+        return current->siteJsonErrorCode;
     }
-    if (!prev->data || prev->data->is_discarded())
+
+    int number = neighbor(offset);
+    auto found = pageCache.find(number);
+    auto page  = found != pageCache.end() ? found->second : startPage(number);
+    waitForPage(*page);
+    if (!page->good)
     {
         isGood = false;
-        return prev->siteJsonErrorCode;
+        return page->siteJsonErrorCode;
     }
-    // Update data
-    pageNumber = pageNumber - 1 == 0 ? pages() : pageNumber - 1;
-    next       = current;
-    current    = prev;
-    prev       = std::make_shared<Page>();
-
-    // Download the next page in the background
-    int prevPage = pageNumber - 1 == 0 ? pages() : pageNumber - 1;
-    downloadGroupPage(prev, prevPage, legal, low, high, LGPE);
-
-    // If there's a mon number desync, also download the next page again
-    if ((*current->data)["total_bundles"] != (*next->data)["total_bundles"])
+
+    int oldTotal = current->totalBundles;
+    pageNumber   = number;
+    current      = page;
+    direction    = offset > 0 ? 1 : -1;
+
+    // If there's a mon number desync, everything else that was downloaded is out of date
+    if (current->totalBundles != oldTotal)
     {
-        int nextPage = (pageNumber % pages()) + 1;
-        downloadGroupPage(next, nextPage, legal, low, high, LGPE);
+        clearPages();
+        pageCache[pageNumber] = current;
     }
 
+    prefetch();
+
     return std::nullopt;
 }
 
 int GroupCloudAccess::pages() const
 {
-    return (*current->data)["pages"].get<int>();
+    return current->pages;
 }
 
 std::unique_ptr<pksm::PKX> GroupCloudAccess::pkm(size_t groupIndex, size_t pokeIndex) const
 {
-    if (groupIndex < (*current->data)["results"].size())
+    if (const pksm::PKX* ret = pkmView(groupIndex, pokeIndex))
     {
-        auto& group = (*current->data)["results"][groupIndex];
-        if (pokeIndex < group["pokemon"].size())
-        {
-            auto& poke           = group["pokemon"][pokeIndex];
-            std::vector<u8> data = base64_decode(poke["base64"].get<std::string>());
-            pksm::Generation gen =
-                pksm::Generation::fromString(poke["generation"].get<std::string>());
+        return ret->clone();
+    }
+    return pksm::PKX::getPKM<pksm::Generation::SEVEN>(nullptr);
+}
 
-            auto ret = pksm::PKX::getPKM(gen, data.data(), data.size());
-            if (ret)
-            {
-                return ret;
-            }
+const pksm::PKX* GroupCloudAccess::pkmView(size_t groupIndex, size_t pokeIndex) const
+{
+    if (groupIndex < current->results.size())
+    {
+        auto& group = current->results[groupIndex];
+        if (pokeIndex < group.pokemon.size())
+        {
+            return group.pokemon[pokeIndex].pkm.get();
         }
     }
-    return pksm::PKX::getPKM<pksm::Generation::SEVEN>(nullptr);
+    return nullptr;
 }
 
 bool GroupCloudAccess::isLegal(size_t groupIndex, size_t pokeIndex) const
 {
-    if (groupIndex < (*current->data)["results"].size())
+    if (groupIndex < current->results.size())
     {
-        auto& group = (*current->data)["results"][groupIndex];
-        if (pokeIndex < group["pokemon"].size())
+        auto& group = current->results[groupIndex];
+        if (pokeIndex < group.pokemon.size())
         {
-            return group["pokemon"][pokeIndex]["legal"];
+            return group.pokemon[pokeIndex].legal;
         }
     }
     return false;
@@ -290,16 +382,15 @@ bool GroupCloudAccess::isLegal(size_t groupIndex, size_t pokeIndex) const
 
 std::unique_ptr<pksm::PKX> GroupCloudAccess::fetchPkm(size_t groupIndex, size_t pokeIndex) const
 {
-    if (groupIndex < (*current->data)["results"].size())
+    if (groupIndex < current->results.size())
     {
-        auto& group = (*current->data)["results"][groupIndex];
-        if (pokeIndex < group["pokemon"].size())
+        auto& group = current->results[groupIndex];
+        if (pokeIndex < group.pokemon.size())
         {
-            auto& poke = group["pokemon"][pokeIndex];
-            auto ret   = pkm(groupIndex, pokeIndex);
+            auto ret = pkm(groupIndex, pokeIndex);
 
             if (auto fetch = Fetch::init(
-                    "https://flagbrew.org/gpss/download/" + poke["code"].get<std::string>(), true,
+                    "https://flagbrew.org/gpss/download/" + group.pokemon[pokeIndex].code, true,
                     nullptr, nullptr, ""))
             {
                 Fetch::performAsync(fetch);
@@ -314,10 +405,10 @@ std::unique_ptr<pksm::PKX> GroupCloudAccess::fetchPkm(size_t groupIndex, size_t
 std::vector<std::unique_ptr<pksm::PKX>> GroupCloudAccess::group(size_t groupIndex) const
 {
     std::vector<std::unique_ptr<pksm::PKX>> ret;
-    if (groupIndex < (*current->data)["results"].size())
+    if (groupIndex < current->results.size())
     {
-        auto& group = (*current->data)["results"][groupIndex];
-        for (size_t i = 0; i < group["pokemon"].size(); i++)
+        auto& group = current->results[groupIndex];
+        for (size_t i = 0; i < group.pokemon.size(); i++)
         {
             ret.emplace_back(pkm(groupIndex, i));
         }
@@ -328,18 +419,17 @@ std::vector<std::unique_ptr<pksm::PKX>> GroupCloudAccess::group(size_t groupInde
 std::vector<std::unique_ptr<pksm::PKX>> GroupCloudAccess::fetchGroup(size_t groupIndex) const
 {
     std::vector<std::unique_ptr<pksm::PKX>> ret;
-    if (groupIndex < (*current->data)["results"].size())
+    if (groupIndex < current->results.size())
     {
-        auto& group = (*current->data)["results"][groupIndex];
-        for (size_t i = 0; i < group["pokemon"].size(); i++)
+        auto& group = current->results[groupIndex];
+        for (size_t i = 0; i < group.pokemon.size(); i++)
         {
             // When the full group is downloaded, all the individual download counters will be
             // incremented
             ret.emplace_back(pkm(groupIndex, i));
         }
-        if (auto fetch = Fetch::init(
-                "https://github.com/gpss/download/bundle/" + group["code"].get<std::string>(), true,
-                nullptr, nullptr, ""))
+        if (auto fetch = Fetch::init("https://github.com/gpss/download/bundle/" + group.code,
+                true, nullptr, nullptr, ""))
         {
             Fetch::performAsync(fetch);
         }
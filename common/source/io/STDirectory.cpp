@@ -27,30 +27,76 @@
 #include "STDirectory.hpp"
 #include <string.h>
 
-STDirectory::STDirectory(const std::string& root) : mError(0), mGood(false)
+STDirectoryReader::STDirectoryReader(const std::string& root, std::string_view prefix)
+    : mDir(opendir(root.c_str())), mEntry(nullptr), mPrefix(prefix), mError(0)
 {
-    DIR* dir = opendir(root.c_str());
-
-    if (dir == NULL)
+    if (mDir == NULL)
     {
         mError = (Result)errno;
-        closedir(dir);
-        return;
     }
-    else
+}
+
+STDirectoryReader::~STDirectoryReader()
+{
+    if (mDir)
     {
-        struct dirent* ent;
-        while ((ent = readdir(dir)))
+        closedir(mDir);
+    }
+}
+
+bool STDirectoryReader::next(void)
+{
+    if (mDir == NULL)
+    {
+        return false;
+    }
+    while ((mEntry = readdir(mDir)))
+    {
+        // Don't return the implicit . and .. folders because ew
+        if (strcmp(mEntry->d_name, ".") && strcmp(mEntry->d_name, "..") &&
+            name().substr(0, mPrefix.size()) == mPrefix)
         {
-            // Don't insert the implicit . and .. folders because ew
-            if (strcmp(ent->d_name, ".") && strcmp(ent->d_name, ".."))
-            {
-                mList.emplace_back(ent->d_name, ent->d_type == DT_DIR);
-            }
+            return true;
         }
     }
+    return false;
+}
+
+Result STDirectoryReader::error(void) const
+{
+    return mError;
+}
+
+bool STDirectoryReader::good(void) const
+{
+    return mDir != NULL;
+}
+
+std::string_view STDirectoryReader::name(void) const
+{
+    return mEntry->d_name;
+}
+
+bool STDirectoryReader::folder(void) const
+{
+    return mEntry->d_type == DT_DIR;
+}
+
+STDirectory::STDirectory(const std::string& root) : mError(0), mGood(false)
+{
+    STDirectoryReader reader(root);
+
+    if (!reader.good())
+    {
+        mError = reader.error();
+        return;
+    }
+
+    while (reader.next())
+    {
+        mList.emplace_back(std::string(reader.name()), reader.folder());
+    }
 
-    closedir(dir);
     mGood = true;
 }
 
@@ -28,6 +28,7 @@
 #include "io.hpp"
 #include "nlohmann/json.hpp"
 #include "utils.hpp"
+#include "utils/crypto.hpp"
 #include "wcx/PCD.hpp"
 #include "wcx/PGF.hpp"
 #include "wcx/PGT.hpp"
@@ -36,152 +37,598 @@
 #include "wcx/WC6.hpp"
 #include "wcx/WC7.hpp"
 #include "wcx/WC8.hpp"
+#include <algorithm>
+#include <numeric>
+#include <sys/stat.h>
+#include <unordered_map>
 
 namespace
 {
-    nlohmann::json mysteryGiftSheet;
-    u8* mysteryGiftData;
-}
+    // Decompressing and parsing the bz2 JSON sheets is slow and takes a lot of memory, so they are
+    // converted once into this format, which is rebuilt whenever the source files change. Only the
+    // header, records, matches, strings, and indexes are read into memory; wonder card data is read
+    // from the file when needed. All integers are little endian
+    constexpr std::string_view DB_MAGIC = "PKSMMGDB";
+    constexpr u32 DB_VERSION            = 2;
 
-void MysteryGift::init(pksm::Generation g)
-{
-    // Just in case cleanup did not occur properly
-    delete[] mysteryGiftData;
-    mysteryGiftData = nullptr;
+    constexpr std::string_view langs[] = {
+        "JPN", "ENG", "FRE", "ITA", "GER", "SPA", "KOR", "CHS", "CHT"};
+    constexpr size_t LANGUAGES = std::size(langs);
+    constexpr u32 NO_CARD      = 0xFFFFFFFF;
 
-    std::string sheetPath = "/3ds/PKSM/mysterygift/sheet" + (std::string)g + ".json.bz2";
-    std::string dataPath  = "/3ds/PKSM/mysterygift/data" + (std::string)g + ".bin.bz2";
-    if (!io::exists(sheetPath) || !io::exists(dataPath))
+    enum CardFlags : u8
     {
-        sheetPath = "romfs:/mg/sheet" + (std::string)g + ".json.bz2";
-        dataPath  = "romfs:/mg/data" + (std::string)g + ".bin.bz2";
-    }
+        CARD_PGT  = 1 << 0,
+        CARD_PCD  = 1 << 1,
+        CARD_FULL = 1 << 2
+    };
+
+    // Size and modification time of a source file, which are cheap to check. A time of 0 means it
+    // isn't known, like for RomFS files, and such a stamp never matches
+    struct SourceStamp
+    {
+        u32 size;
+        u32 mtime;
+
+        bool operator==(const SourceStamp&) const = default;
+    };
+    static_assert(sizeof(SourceStamp) == 8);
+
+    struct DbHeader
+    {
+        char magic[8];
+        u32 version;
+        // Hashes of the compressed sheet and data the database was built from
+        u8 sheetHash[32];
+        u8 dataHash[32];
+        // Stamps of the same files, so that they only need to be hashed when these change
+        SourceStamp sheetStamp;
+        SourceStamp dataStamp;
+        u32 records;
+        u32 matches;
+        u32 stringsSize;
+        u32 speciesIndex;
+        u32 gameIndex;
+        u32 dataSize;
+    };
+    static_assert(sizeof(DbHeader) == 116);
+
+    // One wonder card. name and game are offsets into the string pool
+    struct Record
+    {
+        u32 name;
+        u32 game;
+        u32 offset;
+        u32 size;
+        s16 species;
+        u8 form;
+        u8 gender;
+        u8 flags;
+        u8 released;
+        u8 padding[2];
+    };
+    static_assert(sizeof(Record) == 24);
+
+    // The same gift in each language, as record numbers
+    struct Match
+    {
+        u32 cards[LANGUAGES];
+    };
+    static_assert(sizeof(Match) == 36);
 
-    FILE* f = fopen(sheetPath.c_str(), "rb");
-    if (f != NULL)
+    // Sorted by key, then match
+    struct IndexEntry
     {
-        fseek(f, 0, SEEK_END);
-        size_t size          = ftell(f);
-        unsigned int destLen = 700 * 1024; // big enough
-        char* s              = new char[size];
-        char* d              = new char[destLen]();
-        rewind(f);
-        fread(s, 1, size, f);
+        u32 key;
+        u32 match;
+    };
+    static_assert(sizeof(IndexEntry) == 8);
 
-        int r = BZ2_bzBuffToBuffDecompress(d, &destLen, s, size, 0, 0);
-        if (r == BZ_OK)
+    using Hash = decltype(pksm::crypto::sha256(nullptr, 0));
+
+    struct SourceHashes
+    {
+        Hash sheet;
+        Hash data;
+    };
+
+    struct SourceStamps
+    {
+        SourceStamp sheet;
+        SourceStamp data;
+    };
+
+    pksm::Generation dbGen;
+    std::string dbPath;
+    std::vector<Record> records;
+    std::vector<Match> matches;
+    std::vector<char> strings;
+    std::vector<IndexEntry> speciesIndex;
+    std::vector<IndexEntry> gameIndex;
+    // Only used if the database couldn't be written; otherwise card data is read from dbPath
+    std::vector<u8> mysteryGiftData;
+    // Decoded once so that lists can be drawn without touching the string pool every frame
+    std::vector<MysteryGift::giftData> infos;
+
+    std::vector<u8> readFile(const std::string& path)
+    {
+        std::vector<u8> ret;
+        FILE* f = fopen(path.c_str(), "rb");
+        if (f)
         {
-            mysteryGiftSheet = nlohmann::json::parse(d);
+            fseek(f, 0, SEEK_END);
+            ret.resize(ftell(f));
+            rewind(f);
+            ret.resize(fread(ret.data(), 1, ret.size(), f));
+            fclose(f);
         }
+        return ret;
+    }
 
-        delete[] s;
-        delete[] d;
+    SourceStamp stamp(const std::string& path)
+    {
+        struct stat st;
+        if (stat(path.c_str(), &st) != 0)
+        {
+            return SourceStamp{};
+        }
+        return SourceStamp{u32(st.st_size), u32(st.st_mtime)};
+    }
 
-        fclose(f);
+    bool hashesMatch(const DbHeader& header, const SourceHashes& sources)
+    {
+        return std::equal(sources.sheet.begin(), sources.sheet.end(), header.sheetHash) &&
+               std::equal(sources.data.begin(), sources.data.end(), header.dataHash);
     }
 
-    if (mysteryGiftSheet.is_discarded())
+    bool stampsMatch(const DbHeader& header, const SourceStamps& stamps)
     {
-        mysteryGiftSheet            = nlohmann::json::object();
-        mysteryGiftSheet["gen"]     = "BAD";
-        mysteryGiftSheet["matches"] = nlohmann::json::array();
+        return stamps.sheet.mtime != 0 && stamps.data.mtime != 0 &&
+               header.sheetStamp == stamps.sheet && header.dataStamp == stamps.data;
+    }
+
+    std::vector<u8> decompress(std::vector<u8>& in, unsigned int maxSize)
+    {
+        std::vector<u8> ret(maxSize);
+        if (BZ2_bzBuffToBuffDecompress(
+                (char*)ret.data(), &maxSize, (char*)in.data(), in.size(), 0, 0) != BZ_OK)
+        {
+            return {};
+        }
+        ret.resize(maxSize);
+        return ret;
     }
 
-    f = fopen(dataPath.c_str(), "rb");
-    if (f != NULL)
+    void clear()
     {
-        fseek(f, 0, SEEK_END);
-        u32 size             = ftell(f);
-        unsigned int destLen = 800 * 1024;
-        char* s              = new char[size];
-        mysteryGiftData      = new u8[destLen]();
-        rewind(f);
-        fread(s, 1, size, f);
+        records.clear();
+        records.shrink_to_fit();
+        matches.clear();
+        matches.shrink_to_fit();
+        strings.clear();
+        strings.shrink_to_fit();
+        speciesIndex.clear();
+        speciesIndex.shrink_to_fit();
+        gameIndex.clear();
+        gameIndex.shrink_to_fit();
+        mysteryGiftData.clear();
+        mysteryGiftData.shrink_to_fit();
+        infos.clear();
+        infos.shrink_to_fit();
+    }
 
-        int r = BZ2_bzBuffToBuffDecompress((char*)mysteryGiftData, &destLen, s, size, 0, 0);
-        if (r != BZ_OK)
+    void buildInfos()
+    {
+        infos.reserve(records.size());
+        for (const auto& record : records)
         {
-            // TODO
+            infos.emplace_back(&strings[record.name], &strings[record.game], record.species,
+                record.form, pksm::Gender(record.gender), record.released);
         }
+    }
 
-        delete[] s;
+    template <typename T>
+    bool readSection(FILE* f, std::vector<T>& out, size_t count)
+    {
+        out.resize(count);
+        return fread(out.data(), sizeof(T), count, f) == count;
+    }
 
+    // Loads everything but the card data from the database if it was built from these sources.
+    // Without hashes, the sources' stamps have to match instead
+    bool loadDb(const SourceStamps& stamps, const SourceHashes* sources)
+    {
+        FILE* f = fopen(dbPath.c_str(), "rb");
+        if (!f)
+        {
+            return false;
+        }
+        DbHeader header;
+        bool ok = fread(&header, sizeof(header), 1, f) == 1 &&
+                  std::equal(DB_MAGIC.begin(), DB_MAGIC.end(), header.magic) &&
+                  header.version == DB_VERSION &&
+                  (sources ? hashesMatch(header, *sources) : stampsMatch(header, stamps)) &&
+                  readSection(f, records, header.records) &&
+                  readSection(f, matches, header.matches) &&
+                  readSection(f, strings, header.stringsSize) &&
+                  readSection(f, speciesIndex, header.speciesIndex) &&
+                  readSection(f, gameIndex, header.gameIndex);
         fclose(f);
+        if (!ok)
+        {
+            clear();
+            return false;
+        }
+
+        // The sources were touched without changing, so record their new stamps to skip hashing
+        // them next time
+        if (header.sheetStamp != stamps.sheet || header.dataStamp != stamps.data)
+        {
+            header.sheetStamp = stamps.sheet;
+            header.dataStamp  = stamps.data;
+            if ((f = fopen(dbPath.c_str(), "r+b")))
+            {
+                fwrite(&header, sizeof(header), 1, f);
+                fclose(f);
+            }
+        }
+        return true;
     }
-}
 
-std::unique_ptr<pksm::WCX> MysteryGift::wondercard(size_t index)
-{
-    std::string gen = mysteryGiftSheet["gen"];
+    u32 addString(std::unordered_map<std::string, u32>& pooled, const std::string& str)
+    {
+        auto found = pooled.find(str);
+        if (found != pooled.end())
+        {
+            return found->second;
+        }
+        u32 ret = strings.size();
+        strings.insert(strings.end(), str.begin(), str.end());
+        strings.emplace_back('\0');
+        pooled.emplace(str, ret);
+        return ret;
+    }
+
+    template <typename Key>
+    void buildIndex(std::vector<IndexEntry>& index, Key Record::*key)
+    {
+        index.clear();
+        for (u32 i = 0; i < matches.size(); i++)
+        {
+            // Every card in a match is the same gift, so any of them will do
+            for (u32 card : matches[i].cards)
+            {
+                if (card != NO_CARD)
+                {
+                    index.emplace_back(IndexEntry{u32(records[card].*key), i});
+                    break;
+                }
+            }
+        }
+        std::sort(index.begin(), index.end(), [](const IndexEntry& a, const IndexEntry& b) {
+            return a.key < b.key || (a.key == b.key && a.match < b.match);
+        });
+    }
 
-    auto entry = mysteryGiftSheet["wondercards"][index];
+    // Fills records, matches, strings, and the indexes from a parsed sheet
+    void buildFromSheet(const nlohmann::json& sheet, size_t dataSize)
+    {
+        clear();
+        std::unordered_map<std::string, u32> pooled;
+        std::vector<u32> offsets;
+        for (const auto& card : sheet["wondercards"])
+        {
+            Record record{};
+            record.name     = addString(pooled, card["name"].get<std::string>());
+            record.game     = addString(pooled, card["game"].get<std::string>());
+            record.offset   = card["offset"].get<u32>();
+            record.species  = card["species"].get<int>();
+            record.form     = card["form"].get<int>();
+            record.gender   = card["gender"].get<int>();
+            record.released = card.contains("released") ? card["released"].get<bool>() : true;
 
-    u32 offset = entry["offset"];
+            const std::string type = card["type"].get<std::string>();
+            if (type == "pgt")
+            {
+                record.flags |= CARD_PGT;
+            }
+            else if (type == "pcd")
+            {
+                record.flags |= CARD_PCD;
+            }
+            if (type.find("full") != std::string::npos)
+            {
+                record.flags |= CARD_FULL;
+            }
+            records.emplace_back(record);
+            offsets.emplace_back(record.offset);
+        }
 
-    if (gen == "4")
+        // The sheet doesn't give sizes, so each card runs until the next one starts
+        std::sort(offsets.begin(), offsets.end());
+        for (auto& record : records)
+        {
+            auto next   = std::upper_bound(offsets.begin(), offsets.end(), record.offset);
+            record.size = (next == offsets.end() ? dataSize : *next) - record.offset;
+        }
+
+        for (const auto& match : sheet["matches"])
+        {
+            Match entry;
+            std::fill(std::begin(entry.cards), std::end(entry.cards), NO_CARD);
+            for (size_t lang = 0; lang < LANGUAGES; lang++)
+            {
+                auto found = match.find(langs[lang]);
+                if (found != match.end())
+                {
+                    entry.cards[lang] = found->get<u32>();
+                }
+            }
+            matches.emplace_back(entry);
+        }
+
+        buildIndex(speciesIndex, &Record::species);
+        buildIndex(gameIndex, &Record::game);
+    }
+
+    bool writeDb(
+        const SourceStamps& stamps, const SourceHashes& sources, const std::vector<u8>& data)
     {
-        std::unique_ptr<pksm::WCX> wc = nullptr;
-        if (entry["type"] == "wc4")
+        DbHeader header;
+        std::copy(DB_MAGIC.begin(), DB_MAGIC.end(), header.magic);
+        header.version = DB_VERSION;
+        std::copy(sources.sheet.begin(), sources.sheet.end(), header.sheetHash);
+        std::copy(sources.data.begin(), sources.data.end(), header.dataHash);
+        header.sheetStamp   = stamps.sheet;
+        header.dataStamp    = stamps.data;
+        header.records      = records.size();
+        header.matches      = matches.size();
+        header.stringsSize  = strings.size();
+        header.speciesIndex = speciesIndex.size();
+        header.gameIndex    = gameIndex.size();
+        header.dataSize     = data.size();
+
+        std::string tmpPath = dbPath + ".tmp";
+        FILE* f             = fopen(tmpPath.c_str(), "wb");
+        if (!f)
         {
-            wc = std::make_unique<pksm::WC4>(mysteryGiftData + offset);
+            return false;
         }
-        else if (entry["type"] == "pgt")
+        bool ok = fwrite(&header, sizeof(header), 1, f) == 1 &&
+                  fwrite(records.data(), sizeof(Record), records.size(), f) == records.size() &&
+                  fwrite(matches.data(), sizeof(Match), matches.size(), f) == matches.size() &&
+                  fwrite(strings.data(), 1, strings.size(), f) == strings.size() &&
+                  fwrite(speciesIndex.data(), sizeof(IndexEntry), speciesIndex.size(), f) ==
+                      speciesIndex.size() &&
+                  fwrite(gameIndex.data(), sizeof(IndexEntry), gameIndex.size(), f) ==
+                      gameIndex.size() &&
+                  fwrite(data.data(), 1, data.size(), f) == data.size();
+        ok = fclose(f) == 0 && ok;
+        if (ok)
         {
-            wc = std::make_unique<pksm::PGT>(mysteryGiftData + offset);
+            std::remove(dbPath.c_str());
+            ok = std::rename(tmpPath.c_str(), dbPath.c_str()) == 0;
         }
-        else
+        if (!ok)
         {
-            wc = std::make_unique<pksm::PCD>(mysteryGiftData + offset);
+            std::remove(tmpPath.c_str());
         }
-        return wc;
+        return ok;
     }
-    else if (gen == "5")
+
+    long dataStart()
     {
-        return std::make_unique<pksm::PGF>(mysteryGiftData + offset);
+        return sizeof(DbHeader) + records.size() * sizeof(Record) + matches.size() * sizeof(Match) +
+               strings.size() + (speciesIndex.size() + gameIndex.size()) * sizeof(IndexEntry);
     }
-    else if (gen == "6")
+
+    std::vector<size_t> indexLookup(const std::vector<IndexEntry>& index, u32 key)
+    {
+        std::vector<size_t> ret;
+        auto found = std::lower_bound(index.begin(), index.end(), key,
+            [](const IndexEntry& entry, u32 key) { return entry.key < key; });
+        for (; found != index.end() && found->key == key; ++found)
+        {
+            ret.emplace_back(found->match);
+        }
+        return ret;
+    }
+}
+
+void MysteryGift::init(pksm::Generation g)
+{
+    // Just in case cleanup did not occur properly
+    clear();
+    dbGen  = g;
+    dbPath = "/3ds/PKSM/mysterygift/gifts" + (std::string)g + ".db";
+
+    std::string sheetPath = "/3ds/PKSM/mysterygift/sheet" + (std::string)g + ".json.bz2";
+    std::string dataPath  = "/3ds/PKSM/mysterygift/data" + (std::string)g + ".bin.bz2";
+    if (!io::exists(sheetPath) || !io::exists(dataPath))
+    {
+        sheetPath = "romfs:/mg/sheet" + (std::string)g + ".json.bz2";
+        dataPath  = "romfs:/mg/data" + (std::string)g + ".bin.bz2";
+    }
+
+    // Reading and hashing the sources is only needed when their stamps don't match the database's
+    SourceStamps stamps{stamp(sheetPath), stamp(dataPath)};
+    if (loadDb(stamps, nullptr))
     {
-        return std::make_unique<pksm::WC6>(mysteryGiftData + offset,
-            entry["type"].get<std::string>().find("full") != std::string::npos);
+        buildInfos();
+        return;
     }
-    else if (gen == "7")
+
+    std::vector<u8> sheetSource = readFile(sheetPath);
+    std::vector<u8> dataSource  = readFile(dataPath);
+
+    SourceHashes sources{pksm::crypto::sha256(sheetSource.data(), sheetSource.size()),
+        pksm::crypto::sha256(dataSource.data(), dataSource.size())};
+
+    if (loadDb(stamps, &sources))
     {
-        return std::make_unique<pksm::WC7>(mysteryGiftData + offset,
-            entry["type"].get<std::string>().find("full") != std::string::npos);
+        buildInfos();
+        return;
     }
-    else if (gen == "LGPE")
+
+    std::vector<u8> sheetData = decompress(sheetSource, 700 * 1024); // big enough
+    sheetSource               = std::vector<u8>();
+    nlohmann::json sheet =
+        nlohmann::json::parse(sheetData.begin(), sheetData.end(), nullptr, false);
+    sheetData = std::vector<u8>();
+
+    std::vector<u8> data = decompress(dataSource, 800 * 1024);
+    dataSource           = std::vector<u8>();
+
+    if (sheet.is_discarded() || data.empty() || !sheet.contains("wondercards") ||
+        !sheet.contains("matches"))
     {
-        return std::make_unique<pksm::WB7>(mysteryGiftData + offset,
-            entry["type"].get<std::string>().find("full") != std::string::npos);
+        return;
     }
-    else if (gen == "8")
+
+    buildFromSheet(sheet, data.size());
+    if (!writeDb(stamps, sources, data))
     {
-        return std::make_unique<pksm::WC8>(mysteryGiftData + offset);
+        mysteryGiftData = std::move(data);
+    }
+    buildInfos();
+}
+
+std::unique_ptr<pksm::WCX> MysteryGift::wondercard(size_t index)
+{
+    const Record& record = records[index];
+
+    std::vector<u8> readData;
+    const u8* data;
+    if (!mysteryGiftData.empty())
+    {
+        data = mysteryGiftData.data() + record.offset;
     }
     else
     {
-        return nullptr;
+        readData.resize(record.size);
+        FILE* f = fopen(dbPath.c_str(), "rb");
+        if (!f)
+        {
+            return nullptr;
+        }
+        fseek(f, dataStart() + record.offset, SEEK_SET);
+        size_t read = fread(readData.data(), 1, readData.size(), f);
+        fclose(f);
+        if (read != readData.size())
+        {
+            return nullptr;
+        }
+        data = readData.data();
+    }
+
+    // The constructors copy the data they're given
+    switch (dbGen)
+    {
+        case pksm::Generation::FOUR:
+            if (record.flags & CARD_PGT)
+            {
+                return std::make_unique<pksm::PGT>(data);
+            }
+            else if (record.flags & CARD_PCD)
+            {
+                return std::make_unique<pksm::PCD>(data);
+            }
+            return std::make_unique<pksm::WC4>(data);
+        case pksm::Generation::FIVE:
+            return std::make_unique<pksm::PGF>(data);
+        case pksm::Generation::SIX:
+            return std::make_unique<pksm::WC6>(data, record.flags & CARD_FULL);
+        case pksm::Generation::SEVEN:
+            return std::make_unique<pksm::WC7>(data, record.flags & CARD_FULL);
+        case pksm::Generation::LGPE:
+            return std::make_unique<pksm::WB7>(data, record.flags & CARD_FULL);
+        case pksm::Generation::EIGHT:
+            return std::make_unique<pksm::WC8>(data);
+        default:
+            return nullptr;
     }
 }
 
 void MysteryGift::exit(void)
 {
-    delete[] mysteryGiftData;
-    mysteryGiftData = nullptr;
-    mysteryGiftSheet.clear();
+    clear();
+}
+
+size_t MysteryGift::matchCard(size_t match, const std::string& lang)
+{
+    const Match& entry = matches[match];
+    auto found         = std::find(std::begin(langs), std::end(langs), lang);
+    if (found != std::end(langs) && entry.cards[found - std::begin(langs)] != NO_CARD)
+    {
+        return entry.cards[found - std::begin(langs)];
+    }
+    return *std::find_if(std::begin(entry.cards), std::end(entry.cards),
+        [](u32 card) { return card != NO_CARD; });
+}
+
+nlohmann::json MysteryGift::matchCards(size_t match)
+{
+    nlohmann::json ret = nlohmann::json::object();
+    for (size_t lang = 0; lang < LANGUAGES; lang++)
+    {
+        if (matches[match].cards[lang] != NO_CARD)
+        {
+            ret[std::string(langs[lang])] = matches[match].cards[lang];
+        }
+    }
+    return ret;
+}
+
+bool MysteryGift::matchReleased(size_t match)
+{
+    return std::all_of(std::begin(matches[match].cards), std::end(matches[match].cards),
+        [](u32 card) { return card == NO_CARD || records[card].released; });
 }
 
-std::vector<nlohmann::json> MysteryGift::wondercards()
+const MysteryGift::giftData& MysteryGift::wondercardInfo(size_t index)
 {
-    return mysteryGiftSheet["matches"];
+    return infos[index];
 }
 
-MysteryGift::giftData MysteryGift::wondercardInfo(size_t index)
+std::vector<size_t> MysteryGift::allMatches()
 {
-    nlohmann::json entry = mysteryGiftSheet["wondercards"][index];
-    giftData ret(entry["name"].get<std::string>(), entry["game"].get<std::string>(),
-        entry["species"].get<int>(), entry["form"].get<int>(),
-        pksm::Gender(entry["gender"].get<int>()),
-        entry.contains("released") ? entry["released"].get<bool>() : true);
+    std::vector<size_t> ret(matches.size());
+    std::iota(ret.begin(), ret.end(), 0);
     return ret;
 }
+
+std::vector<size_t> MysteryGift::matchesForLanguage(const std::string& lang)
+{
+    std::vector<size_t> ret;
+    auto found = std::find(std::begin(langs), std::end(langs), lang);
+    if (found != std::end(langs))
+    {
+        size_t langIndex = found - std::begin(langs);
+        for (size_t i = 0; i < matches.size(); i++)
+        {
+            if (matches[i].cards[langIndex] != NO_CARD)
+            {
+                ret.emplace_back(i);
+            }
+        }
+    }
+    return ret;
+}
+
+std::vector<size_t> MysteryGift::matchesForSpecies(int species)
+{
+    return indexLookup(speciesIndex, u32(s16(species)));
+}
+
+std::vector<size_t> MysteryGift::matchesForGame(const std::string& game)
+{
+    // Game names are pooled, so all cards for the same game share one string offset
+    for (const auto& entry : gameIndex)
+    {
+        if (game == &strings[entry.key])
+        {
+            return indexLookup(gameIndex, entry.key);
+        }
+    }
+    return {};
+}
@@ -34,6 +34,11 @@ struct LibraryFunction UnixFunctions[] =
     { bank_get_pkx,         "char* bank_get_pkx(enum Generation* type, int box, int slot);" },
     { bank_get_size,        "int bank_get_size(void);" },
     { bank_select,          "void bank_select(void);" },
+    { bank_move_pkx,        "int bank_move_pkx(char* fromBank, int fromBox, int fromSlot, char* toBank, int toBox, int toSlot);" },
+    { sav_box_query,        "int sav_box_query(int* out, int maxOut, int firstBox, int lastBox, int count, enum PKX_Field* fields, int* args, unsigned int* values);" },
+    { bank_box_query,       "int bank_box_query(int* out, int maxOut, int firstBox, int lastBox, int count, enum PKX_Field* fields, int* args, unsigned int* values);" },
+    { sav_box_values,       "void sav_box_values(unsigned int* out, int firstBox, int lastBox, enum PKX_Field field, int arg);" },
+    { bank_box_values,      "void bank_box_values(unsigned int* out, int firstBox, int lastBox, enum PKX_Field field, int arg);" },
     // general data handling
     { sav_get_data,         "void sav_get_data(char* dataOut, unsigned int size, int off1, int off2);" },
     { sav_set_data,         "void sav_set_data(char* data, unsigned int size, int off1, int off2);" },
@@ -56,6 +61,12 @@ struct LibraryFunction UnixFunctions[] =
     { pkx_is_valid,         "int pkx_is_valid(char* data, enum Generation gen);" },
     { pkx_set_value,        "void pkx_set_value(char* data, enum Generation gen, enum PKX_Field field, ...);" },
     { pkx_get_value,        "unsigned int pkx_get_value(char* data, enum Generation gen, enum PKX_Field field, ...);" },
+    { pkx_open,             "struct PKXHandle* pkx_open(char* data, enum Generation gen);" },
+    { pkx_close,            "void pkx_close(struct PKXHandle* pkx);" },
+    { pkx_handle_get_value, "unsigned int pkx_handle_get_value(struct PKXHandle* pkx, enum PKX_Field field, ...);" },
+    { pkx_handle_set_value, "void pkx_handle_set_value(struct PKXHandle* pkx, enum PKX_Field field, ...);" },
+    { pkx_get_values,       "void pkx_get_values(struct PKXHandle* pkx, int count, enum PKX_Field* fields, int* args, unsigned int* out);" },
+    { pkx_set_values,       "void pkx_set_values(struct PKXHandle* pkx, int count, enum PKX_Field* fields, int* args, int* values);" },
     // io
     { current_directory,    "char* current_directory(void);" },
     { read_directory,       "struct directory* read_directory(char* dir);" },
@@ -109,6 +120,7 @@ void PlatformLibraryInit(Picoc *pc)
     IncludeRegister(pc, "pksm.h", &UnixSetupFunc, &UnixFunctions[0],
     "struct pkx { int species; int form; };"
     "struct JSON { void* dummy; };"
+    "struct PKXHandle { void* dummy; };"
     "enum Generation { GEN_FOUR, GEN_FIVE, GEN_SIX, GEN_SEVEN, GEN_LGPE, GEN_EIGHT, GEN_THREE };"
     "struct directory { int count; char** files; };"
     "enum PKX_Field {OT_NAME, TID, SID, SHINY, LANGUAGE, MET_LOCATION, MOVE, BALL, LEVEL, GENDER,"
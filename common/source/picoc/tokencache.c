@@ -0,0 +1,332 @@
+/*
+ *   This file is part of PKSM
+ *   Copyright (C) 2016-2020 Bernardo Giordano, Admiral Fish, piepie62
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+
+#include "tokencache.h"
+#include "interpreter.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TOKEN_CACHE_MAGIC "PKSMTOKN"
+#define TOKEN_CACHE_HASH_SIZE 32
+
+/* A cache file is this header, StringCount NUL-terminated strings taking up StringsSize bytes,
+ * and then the tokens. Identifier and string constant tokens point into the interpreter's string
+ * table, which is gone after PicocCleanup, so in the file they hold an index into its strings */
+struct TokenCacheHeader
+{
+    char Magic[8];
+    uint32_t Version;
+    unsigned char SourceHash[TOKEN_CACHE_HASH_SIZE];
+    /* Other values are kept as they are in memory, so only builds that agree on these can share */
+    uint32_t PointerSize;
+    uint32_t LongSize;
+    uint32_t StringCount;
+    uint32_t StringsSize;
+    uint32_t TokensSize;
+};
+
+/* Strings met while writing a cache file, keyed by their address in the string table */
+struct StringIndex
+{
+    const char** Keys;
+    uint32_t* Values;
+    uint32_t Capacity;
+    uint32_t Count;
+    char* Strings;
+    uint32_t StringsSize;
+    uint32_t StringsCapacity;
+};
+
+/* Strings read from a cache file, once registered with the interpreter */
+struct StringList
+{
+    Picoc* pc;
+    char** Strings;
+    uint32_t Count;
+};
+
+/* Size of the value that follows a token. LexTokenise stores each token as its LexToken and the
+ * character position it starts at, a byte each, followed by this */
+static int TokenValueSize(enum LexToken Token)
+{
+    switch (Token)
+    {
+        case TokenIdentifier:
+        case TokenStringConstant:
+            return sizeof(char*);
+        case TokenIntegerConstant:
+            return sizeof(long);
+        case TokenCharacterConstant:
+            return sizeof(unsigned char);
+        case TokenFPConstant:
+            return sizeof(double);
+        default:
+            return 0;
+    }
+}
+
+/* Calls Visit with each token that holds a string and where its pointer is. Fails if Visit does or
+ * if the tokens don't end with TokenEOF within Size bytes */
+static int ForEachString(unsigned char* Tokens, int Size,
+    int (*Visit)(void* Context, enum LexToken Token, unsigned char* Value), void* Context)
+{
+    int Pos = 0;
+    while (Pos + 2 <= Size)
+    {
+        enum LexToken Token = (enum LexToken)Tokens[Pos];
+        int ValueSize       = TokenValueSize(Token);
+        Pos += 2;
+        if (Pos + ValueSize > Size)
+            return false;
+
+        if ((Token == TokenIdentifier || Token == TokenStringConstant) &&
+            !Visit(Context, Token, Tokens + Pos))
+            return false;
+
+        Pos += ValueSize;
+        if (Token == TokenEOF)
+            return true;
+    }
+    return false;
+}
+
+static int CountString(void* Context, enum LexToken Token, unsigned char* Value)
+{
+    (*(uint32_t*)Context)++;
+    return true;
+}
+
+/* Replaces a string pointer with the index of its string, adding it if it's new */
+static int IndexString(void* Context, enum LexToken Token, unsigned char* Value)
+{
+    struct StringIndex* Index = Context;
+    const char* Str;
+    memcpy(&Str, Value, sizeof(Str));
+
+    uint32_t Slot = (uint32_t)(((uintptr_t)Str >> 2) * 2654435761u) & (Index->Capacity - 1);
+    while (Index->Keys[Slot] != NULL && Index->Keys[Slot] != Str)
+        Slot = (Slot + 1) & (Index->Capacity - 1);
+
+    if (Index->Keys[Slot] == NULL)
+    {
+        uint32_t Len = strlen(Str) + 1;
+        if (Index->StringsSize + Len > Index->StringsCapacity)
+        {
+            uint32_t NewCapacity = (Index->StringsSize + Len) * 2;
+            char* NewStrings     = realloc(Index->Strings, NewCapacity);
+            if (NewStrings == NULL)
+                return false;
+            Index->Strings         = NewStrings;
+            Index->StringsCapacity = NewCapacity;
+        }
+        memcpy(Index->Strings + Index->StringsSize, Str, Len);
+        Index->StringsSize += Len;
+        Index->Keys[Slot]   = Str;
+        Index->Values[Slot] = Index->Count++;
+    }
+
+    uintptr_t Stored = Index->Values[Slot];
+    memcpy(Value, &Stored, sizeof(Stored));
+    return true;
+}
+
+/* Replaces a string index with the string it stands for, registered with the interpreter */
+static int ResolveString(void* Context, enum LexToken Token, unsigned char* Value)
+{
+    struct StringList* List = Context;
+    uintptr_t Stored;
+    memcpy(&Stored, Value, sizeof(Stored));
+    if (Stored >= List->Count)
+        return false;
+
+    char* Str = List->Strings[Stored];
+    if (Token == TokenStringConstant && VariableStringLiteralGet(List->pc, Str) == NULL)
+    {
+        /* Done by the lexer for each string constant it finds, as LexGetStringConstant does */
+        struct Value* ArrayValue = VariableAllocValueAndData(List->pc, NULL, 0, false, NULL, true);
+        ArrayValue->Typ          = List->pc->CharArrayType;
+        ArrayValue->Val          = (union AnyValue*)Str;
+        VariableStringLiteralDefine(List->pc, Str, ArrayValue);
+    }
+
+    memcpy(Value, &Str, sizeof(Str));
+    return true;
+}
+
+static void SaveTokens(const void* Tokens, int TokensSize, const unsigned char* SourceHash,
+    const char* CachePath)
+{
+    struct StringIndex Index = {0};
+    struct TokenCacheHeader Header;
+    unsigned char* Copy = malloc(TokensSize);
+    uint32_t StringTokens = 0;
+    char* TmpPath = malloc(strlen(CachePath) + 5);
+    FILE* Out;
+    int Ok;
+
+    if (Copy == NULL || TmpPath == NULL)
+        goto done;
+    memcpy(Copy, Tokens, TokensSize);
+    if (!ForEachString(Copy, TokensSize, CountString, &StringTokens))
+        goto done;
+
+    Index.Capacity = 16;
+    while (Index.Capacity < StringTokens * 2)
+        Index.Capacity *= 2;
+    Index.Keys   = calloc(Index.Capacity, sizeof(const char*));
+    Index.Values = malloc(Index.Capacity * sizeof(uint32_t));
+    if (Index.Keys == NULL || Index.Values == NULL ||
+        !ForEachString(Copy, TokensSize, IndexString, &Index))
+        goto done;
+
+    memcpy(Header.Magic, TOKEN_CACHE_MAGIC, sizeof(Header.Magic));
+    Header.Version = PKSM_TOKEN_CACHE_VERSION;
+    memcpy(Header.SourceHash, SourceHash, TOKEN_CACHE_HASH_SIZE);
+    Header.PointerSize = sizeof(char*);
+    Header.LongSize    = sizeof(long);
+    Header.StringCount = Index.Count;
+    Header.StringsSize = Index.StringsSize;
+    Header.TokensSize  = TokensSize;
+
+    /* Written next to the old file and moved over it, so that a cut off write is never read */
+    strcpy(TmpPath, CachePath);
+    strcat(TmpPath, ".tmp");
+    Out = fopen(TmpPath, "wb");
+    if (Out == NULL)
+        goto done;
+    Ok = fwrite(&Header, sizeof(Header), 1, Out) == 1 &&
+         fwrite(Index.Strings, 1, Index.StringsSize, Out) == Index.StringsSize &&
+         fwrite(Copy, 1, TokensSize, Out) == (size_t)TokensSize;
+    Ok = fclose(Out) == 0 && Ok;
+    if (Ok)
+    {
+        remove(CachePath);
+        Ok = rename(TmpPath, CachePath) == 0;
+    }
+    if (!Ok)
+        remove(TmpPath);
+
+done:
+    free(Index.Keys);
+    free(Index.Values);
+    free(Index.Strings);
+    free(TmpPath);
+    free(Copy);
+}
+
+/* Reads the tokens stored for this source into the interpreter's heap, or returns NULL */
+static void* LoadTokens(Picoc* pc, const unsigned char* SourceHash, const char* CachePath)
+{
+    struct TokenCacheHeader Header;
+    struct StringList List = {pc, NULL, 0};
+    char* Strings          = NULL;
+    unsigned char* Tokens  = NULL;
+    FILE* In               = fopen(CachePath, "rb");
+    int Ok                 = false;
+
+    if (In == NULL)
+        return NULL;
+    if (fread(&Header, sizeof(Header), 1, In) != 1 ||
+        memcmp(Header.Magic, TOKEN_CACHE_MAGIC, sizeof(Header.Magic)) != 0 ||
+        Header.Version != PKSM_TOKEN_CACHE_VERSION ||
+        memcmp(Header.SourceHash, SourceHash, TOKEN_CACHE_HASH_SIZE) != 0 ||
+        Header.PointerSize != sizeof(char*) || Header.LongSize != sizeof(long) ||
+        Header.TokensSize == 0 || Header.TokensSize > INT32_MAX ||
+        Header.StringCount > Header.StringsSize)
+        goto done;
+
+    Strings      = malloc(Header.StringsSize);
+    List.Strings = malloc(Header.StringCount * sizeof(char*));
+    Tokens       = HeapAllocMem(pc, Header.TokensSize);
+    if ((Header.StringsSize != 0 && Strings == NULL) ||
+        (Header.StringCount != 0 && List.Strings == NULL) || Tokens == NULL ||
+        fread(Strings, 1, Header.StringsSize, In) != Header.StringsSize ||
+        fread(Tokens, 1, Header.TokensSize, In) != Header.TokensSize)
+        goto done;
+
+    for (uint32_t Pos = 0; List.Count < Header.StringCount; List.Count++)
+    {
+        size_t Len = strnlen(Strings + Pos, Header.StringsSize - Pos);
+        if (Pos + Len >= Header.StringsSize)
+            goto done;
+        List.Strings[List.Count] = TableStrRegister2(pc, Strings + Pos, Len);
+        Pos += Len + 1;
+    }
+
+    Ok = ForEachString(Tokens, Header.TokensSize, ResolveString, &List);
+
+done:
+    fclose(In);
+    free(Strings);
+    free(List.Strings);
+    if (!Ok && Tokens != NULL)
+    {
+        HeapFreeMem(pc, Tokens);
+        Tokens = NULL;
+    }
+    return Tokens;
+}
+
+void PicocParseCached(Picoc* pc, const char* FileName, const char* Source, int SourceLen,
+    const unsigned char* SourceHash, const char* CachePath)
+{
+    struct ParseState Parser;
+    enum ParseResult Ok;
+    struct CleanupTokenNode* NewCleanupNode;
+    char* RegFileName = TableStrRegister(pc, FileName);
+    void* Tokens      = LoadTokens(pc, SourceHash, CachePath);
+
+    if (Tokens == NULL)
+    {
+        int TokensSize;
+        Tokens = LexAnalyse(pc, RegFileName, Source, SourceLen, &TokensSize);
+        SaveTokens(Tokens, TokensSize, SourceHash, CachePath);
+    }
+
+    /* The rest is what PicocParse does with the tokens it lexes: they're freed by PicocCleanup,
+     * as functions defined by the script point into them */
+    NewCleanupNode = HeapAllocMem(pc, sizeof(struct CleanupTokenNode));
+    if (NewCleanupNode == NULL)
+        ProgramFailNoParser(pc, "(PicocParseCached) out of memory");
+
+    NewCleanupNode->Tokens     = Tokens;
+    NewCleanupNode->SourceText = NULL;
+    NewCleanupNode->Next       = pc->CleanupTokenList;
+    pc->CleanupTokenList       = NewCleanupNode;
+
+    LexInitParser(&Parser, pc, Source, Tokens, RegFileName, true, false);
+
+    do
+    {
+        Ok = ParseStatement(&Parser, true);
+    } while (Ok == ParseResultOk);
+
+    if (Ok == ParseResultError)
+        ProgramFail(&Parser, "parse error");
+}
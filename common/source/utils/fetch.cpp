@@ -25,12 +25,19 @@
  */
 
 #include "fetch.hpp"
+#include "fetchcache.hpp"
 #include "thread.hpp"
 #include <errno.h>
+#include <optional>
 #include <stdarg.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/stat.h>
 #include <time.h>
 #include <unistd.h>
+#include <unordered_map>
 
 namespace
 {
@@ -46,13 +53,43 @@ namespace
     };
 
     constexpr int MAX_FILE_BUFFER_SIZE = 0x10000;
+    // Upper bound on how long the multi thread sleeps in curl_multi_poll. It only matters when
+    // curl_multi_wakeup doesn't work (no socketpair), as new requests can't interrupt the poll then
+    constexpr int MAX_POLL_MS      = 1000;
+    constexpr int FALLBACK_POLL_MS = 10;
 
-    std::atomic<bool> multiThreadInfo = false;
-    std::vector<MultiFetchRecord> fetches;
-    _LOCK_T fetchesMutex;
-    CURLM* multiHandle = nullptr;
-    _LOCK_T multiHandleMutex;
+    std::atomic<bool> multiThreadRunning = false;
+    // Running transfers by easy handle. Only ever touched by the multi thread
+    std::unordered_map<CURL*, MultiFetchRecord> fetches;
+    // Requests from other threads, picked up by the multi thread on its next iteration
+    std::vector<MultiFetchRecord> pendingFetches;
+    std::vector<std::shared_ptr<Fetch>> pendingCancels;
+    _LOCK_T pendingMutex;
+    std::unique_ptr<Threads::Event> multiWork;
+    std::unique_ptr<Threads::Event> multiDone;
+    CURLM* multiHandle    = nullptr;
     bool multiInitialized = false;
+    bool multiWakeup      = false;
+    // DNS results, TLS sessions and open connections are shared by every handle, so talking to the
+    // same host again doesn't need a new handshake
+    CURLSH* shareHandle = nullptr;
+    _LOCK_T shareLocks[CURL_LOCK_DATA_LAST];
+
+    void shareLock(CURL*, curl_lock_data data, curl_lock_access, void*)
+    {
+        __lock_acquire(shareLocks[data]);
+    }
+
+    void shareUnlock(CURL*, curl_lock_data data, void*) { __lock_release(shareLocks[data]); }
+
+    void wakeMultiThread()
+    {
+        multiWork->signal();
+        if (multiWakeup)
+        {
+            curl_multi_wakeup(multiHandle);
+        }
+    }
 
     size_t string_write_callback(char* ptr, size_t size, size_t nmemb, void* userdata)
     {
@@ -60,6 +97,218 @@ namespace
         str->append(ptr, size * nmemb);
         return size * nmemb;
     }
+
+    struct CachedRequest
+    {
+        ~CachedRequest() { curl_slist_free_all(headers); }
+        struct curl_slist* headers = nullptr;
+        std::string body;
+        std::string etag;
+        std::string lastModified;
+        // Only set when revalidating
+        std::optional<std::string> cachedBody;
+        u32 maxAge     = 0;
+        bool cacheable = true;
+    };
+
+    std::string headerLine(char* buffer, size_t size)
+    {
+        std::string header(buffer, size);
+        while (!header.empty() && (header.back() == '\r' || header.back() == '\n'))
+        {
+            header.pop_back();
+        }
+        return header;
+    }
+
+    std::optional<std::string> headerValue(const std::string& header, const char* name)
+    {
+        size_t length = strlen(name);
+        if (header.size() > length && !strncasecmp(header.c_str(), name, length))
+        {
+            size_t start = header.find_first_not_of(' ', length);
+            return start == std::string::npos ? "" : header.substr(start);
+        }
+        return std::nullopt;
+    }
+
+    size_t cache_header_callback(char* buffer, size_t size, size_t nitems, void* userdata)
+    {
+        CachedRequest* request = (CachedRequest*)userdata;
+        std::string header     = headerLine(buffer, size * nitems);
+        auto value             = [&header](const char* name) { return headerValue(header, name); };
+
+        if (header.substr(0, 5) == "HTTP/")
+        {
+            // New response (redirects); forget everything from the previous one
+            request->etag.clear();
+            request->lastModified.clear();
+            request->maxAge    = 0;
+            request->cacheable = true;
+        }
+        else if (auto etag = value("ETag:"))
+        {
+            request->etag = *etag;
+        }
+        else if (auto lastModified = value("Last-Modified:"))
+        {
+            request->lastModified = *lastModified;
+        }
+        else if (auto cacheControl = value("Cache-Control:"))
+        {
+            if (cacheControl->find("no-store") != std::string::npos)
+            {
+                request->cacheable = false;
+            }
+            size_t maxAge = cacheControl->find("max-age=");
+            if (maxAge != std::string::npos)
+            {
+                request->maxAge = strtoul(cacheControl->c_str() + maxAge + 8, nullptr, 10);
+            }
+        }
+
+        return size * nitems;
+    }
+
+    struct DownloadGroup;
+
+    struct DownloadState
+    {
+        DownloadGroup* group = nullptr;
+        Fetch* fetch         = nullptr;
+        FILE* file           = nullptr;
+        std::string path;
+        std::string partPath;
+        // Holds the ETag or Last-Modified of the response that a .part file came from
+        std::string validatorPath;
+        std::string etag;
+        std::string lastModified;
+        // Freed by downloadMany once the transfer is over
+        struct curl_slist* headers = nullptr;
+        curl_off_t resumeFrom = 0;
+        curl_off_t total      = 0;
+        curl_off_t now        = 0;
+        CURLcode result       = CURLE_OK;
+        long status           = 0;
+        bool checkedStatus    = false;
+        bool started          = false;
+    };
+
+    struct DownloadGroup
+    {
+        // Never resized once transfers start, as they point into it
+        std::vector<DownloadState> states;
+        curl_xferinfo_callback progress = nullptr;
+        void* progressInfo              = nullptr;
+        // One extra for the thread starting the transfers, so that finished can't fire early
+        std::atomic<size_t> remaining = 1;
+        Threads::Event finished;
+    };
+
+    // Weak ETags can't be used with If-Range, so Last-Modified is used instead of those
+    std::string validator(const DownloadState& state)
+    {
+        if (!state.etag.empty() && state.etag.substr(0, 2) != "W/")
+        {
+            return state.etag;
+        }
+        return state.lastModified;
+    }
+
+    std::string readValidator(const DownloadState& state)
+    {
+        char buffer[256] = {0};
+        if (FILE* in = fopen(state.validatorPath.c_str(), "rb"))
+        {
+            fread(buffer, 1, sizeof(buffer) - 1, in);
+            fclose(in);
+        }
+        return buffer;
+    }
+
+    // Without a validator, a .part file can't be resumed safely, so none is left to claim it can
+    void writeValidator(const DownloadState& state)
+    {
+        std::string value = validator(state);
+        if (!value.empty())
+        {
+            if (FILE* out = fopen(state.validatorPath.c_str(), "wb"))
+            {
+                bool good = fwrite(value.data(), 1, value.size(), out) == value.size();
+                if (fclose(out) == 0 && good)
+                {
+                    return;
+                }
+            }
+        }
+        remove(state.validatorPath.c_str());
+    }
+
+    size_t download_header_callback(char* buffer, size_t size, size_t nitems, void* userdata)
+    {
+        DownloadState* state = (DownloadState*)userdata;
+        std::string header   = headerLine(buffer, size * nitems);
+        if (header.substr(0, 5) == "HTTP/")
+        {
+            state->etag.clear();
+            state->lastModified.clear();
+        }
+        else if (auto etag = headerValue(header, "ETag:"))
+        {
+            state->etag = *etag;
+        }
+        else if (auto lastModified = headerValue(header, "Last-Modified:"))
+        {
+            state->lastModified = *lastModified;
+        }
+        return size * nitems;
+    }
+
+    size_t download_write_callback(char* ptr, size_t size, size_t nmemb, void* userdata)
+    {
+        DownloadState* state = (DownloadState*)userdata;
+        if (!state->checkedStatus)
+        {
+            state->checkedStatus = true;
+            state->fetch->getinfo(CURLINFO_RESPONSE_CODE, &state->status);
+            if (state->resumeFrom > 0 && state->status != 206)
+            {
+                // The server ignored the Range header or, through If-Range, said that the file
+                // changed, and is sending the whole file again
+                fclose(state->file);
+                state->file       = fopen(state->partPath.c_str(), "wb");
+                state->resumeFrom = 0;
+                if (!state->file)
+                {
+                    return 0;
+                }
+                setvbuf(state->file, nullptr, _IOFBF, MAX_FILE_BUFFER_SIZE);
+            }
+            if (state->resumeFrom == 0)
+            {
+                writeValidator(*state);
+            }
+        }
+        return fwrite(ptr, 1, size * nmemb, state->file);
+    }
+
+    // Every transfer of a group runs on the multi thread, so the totals can't race
+    int download_progress_callback(void* clientp, curl_off_t dltotal, curl_off_t dlnow,
+        curl_off_t ultotal, curl_off_t ulnow)
+    {
+        DownloadState* state = (DownloadState*)clientp;
+        DownloadGroup* group = state->group;
+        state->total         = dltotal > 0 ? state->resumeFrom + dltotal : 0;
+        state->now           = state->resumeFrom + dlnow;
+
+        curl_off_t total = 0, now = 0;
+        for (const auto& other : group->states)
+        {
+            total += other.total;
+            now += other.now;
+        }
+        return group->progress(group->progressInfo, total, now, ultotal, ulnow);
+    }
 }
 
 std::shared_ptr<Fetch> Fetch::init(const std::string& url, bool ssl, std::string* writeData,
@@ -91,6 +340,10 @@ std::shared_ptr<Fetch> Fetch::init(const std::string& url, bool ssl, std::string
         fetch->setopt(CURLOPT_FOLLOWLOCATION, 1L);
         fetch->setopt(CURLOPT_LOW_SPEED_LIMIT, 300L);
         fetch->setopt(CURLOPT_LOW_SPEED_TIME, 10L);
+        if (shareHandle)
+        {
+            fetch->setopt(CURLOPT_SHARE, shareHandle);
+        }
     }
     else
     {
@@ -102,46 +355,148 @@ std::shared_ptr<Fetch> Fetch::init(const std::string& url, bool ssl, std::string
 Result Fetch::download(const std::string& url, const std::string& path, const std::string& postData,
     curl_xferinfo_callback progress, void* progressInfo)
 {
-    FILE* file = fopen(path.c_str(), "wb");
-    if (!file)
-    {
-        return -errno;
-    }
+    return downloadMany({{url, path, postData}}, progress, progressInfo);
+}
+
+Result Fetch::downloadMany(const std::vector<DownloadRequest>& requests,
+    curl_xferinfo_callback progress, void* progressInfo)
+{
+    Result ret = 0;
+    DownloadGroup group;
+    group.states.resize(requests.size());
+    group.progress     = progress;
+    group.progressInfo = progressInfo;
 
-    if (auto fetch = Fetch::init(url, url.substr(0, 5) == "https", nullptr, nullptr, postData))
+    for (size_t i = 0; i < requests.size(); i++)
     {
-        setvbuf(file, nullptr, _IOFBF, MAX_FILE_BUFFER_SIZE);
-        fetch->setopt(CURLOPT_WRITEFUNCTION, fwrite);
-        fetch->setopt(CURLOPT_WRITEDATA, file);
-        if (progress)
+        const DownloadRequest& request = requests[i];
+        DownloadState& state           = group.states[i];
+        state.group                    = &group;
+        state.path                     = request.path;
+        state.partPath                 = request.path + ".part";
+        state.validatorPath            = request.path + ".partinfo";
+
+        // Only a plain GET can be picked up where it left off, and only with If-Range, so that a
+        // file that changed on the server since is sent whole instead of appended to the old part
+        struct stat partStat;
+        std::string resumeValidator;
+        if (request.postData.empty() && stat(state.partPath.c_str(), &partStat) == 0 &&
+            !(resumeValidator = readValidator(state)).empty())
         {
-            fetch->setopt(CURLOPT_NOPROGRESS, 0L);
-            fetch->setopt(CURLOPT_XFERINFOFUNCTION, progress);
-            fetch->setopt(CURLOPT_XFERINFODATA, progressInfo);
+            state.resumeFrom = partStat.st_size;
+            state.headers =
+                curl_slist_append(nullptr, ("If-Range: " + resumeValidator).c_str());
         }
 
-        auto res = Fetch::perform(fetch);
+        state.file = fopen(state.partPath.c_str(), state.resumeFrom > 0 ? "ab" : "wb");
+        if (!state.file)
+        {
+            ret = -errno;
+            break;
+        }
 
-        fclose(file);
+        auto fetch = Fetch::init(
+            request.url, request.url.substr(0, 5) == "https", nullptr, nullptr, request.postData);
+        if (!fetch)
+        {
+            fclose(state.file);
+            ret = -1;
+            break;
+        }
 
-        if (res.index() == 0)
+        state.fetch = fetch.get();
+        setvbuf(state.file, nullptr, _IOFBF, MAX_FILE_BUFFER_SIZE);
+        fetch->setopt(CURLOPT_WRITEFUNCTION, download_write_callback);
+        fetch->setopt(CURLOPT_WRITEDATA, &state);
+        fetch->setopt(CURLOPT_HEADERFUNCTION, download_header_callback);
+        fetch->setopt(CURLOPT_HEADERDATA, &state);
+        if (state.resumeFrom > 0)
         {
-            remove(path.c_str());
-            return -std::get<0>(res);
+            fetch->setopt(CURLOPT_HTTPHEADER, state.headers);
+            fetch->setopt(CURLOPT_RESUME_FROM_LARGE, state.resumeFrom);
         }
-        else if (std::get<1>(res) != CURLE_OK)
+        if (progress)
         {
-            remove(path.c_str());
-            return -(std::get<1>(res) + 100);
+            fetch->setopt(CURLOPT_NOPROGRESS, 0L);
+            fetch->setopt(CURLOPT_XFERINFOFUNCTION, download_progress_callback);
+            fetch->setopt(CURLOPT_XFERINFODATA, &state);
         }
+
+        group.remaining++;
+        CURLMcode mres =
+            performAsync(fetch, [&state, &group](CURLcode code, std::shared_ptr<Fetch> fetch) {
+                state.result = code;
+                fetch->getinfo(CURLINFO_RESPONSE_CODE, &state.status);
+                if (state.file)
+                {
+                    fclose(state.file);
+                    state.file = nullptr;
+                }
+                if (--group.remaining == 0)
+                {
+                    group.finished.signal();
+                }
+            });
+        if (mres != CURLM_OK)
+        {
+            group.remaining--;
+            fclose(state.file);
+            ret = -mres;
+            break;
+        }
+        state.started = true;
     }
-    else
+
+    if (--group.remaining != 0)
     {
-        fclose(file);
-        return -1;
+        group.finished.wait();
     }
 
-    return 0;
+    for (size_t i = 0; i < requests.size(); i++)
+    {
+        DownloadState& state = group.states[i];
+        curl_slist_free_all(state.headers);
+        if (!state.started)
+        {
+            continue;
+        }
+
+        Result res = 0;
+        if (state.result != CURLE_OK)
+        {
+            res = -(state.result + 100);
+            // Whatever arrived can be resumed next time, unless the request can't be repeated
+            // with a Range header or the server refused the one that was sent
+            if (!requests[i].postData.empty() || state.result == CURLE_RANGE_ERROR ||
+                state.status == 416)
+            {
+                remove(state.partPath.c_str());
+                remove(state.validatorPath.c_str());
+            }
+        }
+        else if (state.status >= 400)
+        {
+            res = -(CURLE_HTTP_RETURNED_ERROR + 100);
+            remove(state.partPath.c_str());
+            remove(state.validatorPath.c_str());
+        }
+        else
+        {
+            remove(state.validatorPath.c_str());
+            remove(state.path.c_str());
+            if (rename(state.partPath.c_str(), state.path.c_str()) != 0)
+            {
+                res = -errno;
+            }
+        }
+
+        if (ret == 0)
+        {
+            ret = res;
+        }
+    }
+
+    return ret;
 }
 
 std::unique_ptr<curl_mime, decltype(curl_mime_free)*> Fetch::mimeInit()
@@ -156,65 +511,106 @@ std::unique_ptr<curl_mime, decltype(curl_mime_free)*> Fetch::mimeInit()
 
 void Fetch::multiMainThread(void*)
 {
+    std::vector<MultiFetchRecord> toAdd;
+    std::vector<std::shared_ptr<Fetch>> toCancel;
     int trash;
-    while (multiThreadInfo)
+    while (multiThreadRunning)
     {
-        CURLMcode mc;
+        __lock_acquire(pendingMutex);
+        toAdd.swap(pendingFetches);
+        toCancel.swap(pendingCancels);
+        __lock_release(pendingMutex);
 
-        __lock_acquire(multiHandleMutex);
-        mc = curl_multi_perform(multiHandle, &trash);
-        __lock_release(multiHandleMutex);
-        if (mc == CURLM_OK)
+        for (auto& record : toAdd)
         {
-            int numFDs;
-            __lock_acquire(multiHandleMutex);
-            mc = curl_multi_wait(multiHandle, nullptr, 0, 1, &numFDs);
-            __lock_release(multiHandleMutex);
-            if (numFDs == 0)
+            CURL* handle = record.fetch->curl.get();
+            if (curl_multi_add_handle(multiHandle, handle) == CURLM_OK)
             {
-                constexpr timespec sleepTime = {0, 1000000};
-                nanosleep(&sleepTime, nullptr);
+                fetches.emplace(handle, std::move(record));
+            }
+            else if (record.function)
+            {
+                record.function(CURLE_FAILED_INIT, record.fetch);
             }
         }
+        toAdd.clear();
 
-        __lock_acquire(multiHandleMutex);
-        auto msg = curl_multi_info_read(multiHandle, &trash);
-        while (msg != nullptr)
+        for (auto& fetch : toCancel)
         {
-            // Find the done handle
-            __lock_acquire(fetchesMutex);
-            auto it = std::find_if(
-                fetches.begin(), fetches.end(), [&msg](const MultiFetchRecord& record) {
-                    return record.fetch->curl.get() == msg->easy_handle;
-                });
-            // And delete it
+            auto it = fetches.find(fetch->curl.get());
             if (it != fetches.end())
             {
-                if (it->function)
+                curl_multi_remove_handle(multiHandle, it->first);
+                if (it->second.function)
                 {
-                    it->function(msg->data.result, it->fetch);
+                    it->second.function(CURLE_ABORTED_BY_CALLBACK, it->second.fetch);
                 }
-                curl_multi_remove_handle(multiHandle, it->fetch->curl.get());
                 fetches.erase(it);
             }
-            __lock_release(fetchesMutex);
+        }
+        toCancel.clear();
 
-            msg = curl_multi_info_read(multiHandle, &trash);
+        if (fetches.empty())
+        {
+            // Nothing to do until someone asks for something
+            multiWork->wait();
+            continue;
         }
-        __lock_release(multiHandleMutex);
 
-        // Terrible things have happened, but I don't know what to do
+        curl_multi_perform(multiHandle, &trash);
+
+        while (CURLMsg* msg = curl_multi_info_read(multiHandle, &trash))
+        {
+            if (msg->msg != CURLMSG_DONE)
+            {
+                continue;
+            }
+            auto it = fetches.find(msg->easy_handle);
+            if (it != fetches.end())
+            {
+                // The record has to outlive the message, which is invalidated by removing the
+                // handle
+                MultiFetchRecord record = std::move(it->second);
+                CURLcode result         = msg->data.result;
+                fetches.erase(it);
+                curl_multi_remove_handle(multiHandle, record.fetch->curl.get());
+                if (record.function)
+                {
+                    record.function(result, record.fetch);
+                }
+            }
+        }
+
+        if (!fetches.empty())
+        {
+            curl_multi_poll(
+                multiHandle, nullptr, 0, multiWakeup ? MAX_POLL_MS : FALLBACK_POLL_MS, &trash);
+        }
     }
 
-    multiThreadInfo = true;
+    multiDone->signal();
 }
 
 Result Fetch::initMulti()
 {
-    __lock_init(fetchesMutex);
-    __lock_init(multiHandleMutex);
-    multiHandle     = curl_multi_init();
-    multiThreadInfo = true;
+    __lock_init(pendingMutex);
+    multiWork          = std::make_unique<Threads::Event>();
+    multiDone          = std::make_unique<Threads::Event>();
+    multiHandle        = curl_multi_init();
+    multiWakeup        = curl_multi_wakeup(multiHandle) == CURLM_OK;
+    if ((shareHandle = curl_share_init()))
+    {
+        for (auto& lock : shareLocks)
+        {
+            __lock_init(lock);
+        }
+        curl_share_setopt(shareHandle, CURLSHOPT_LOCKFUNC, shareLock);
+        curl_share_setopt(shareHandle, CURLSHOPT_UNLOCKFUNC, shareUnlock);
+        curl_share_setopt(shareHandle, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+        curl_share_setopt(shareHandle, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+        curl_share_setopt(shareHandle, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+    }
+    multiThreadRunning = true;
     if (!Threads::create(Fetch::multiMainThread, nullptr, 8 * 1024))
     {
         multiInitialized = false;
@@ -226,27 +622,33 @@ Result Fetch::initMulti()
 
 void Fetch::exitMulti()
 {
-    multiThreadInfo = false; // Stop multi thread
+    multiThreadRunning = false; // Stop multi thread
     if (multiInitialized)
     {
-        while (!multiThreadInfo) // Wait for it to be done
-        {
-            constexpr timespec sleepTime = {0, 100000};
-            nanosleep(&sleepTime, nullptr);
-        }
+        wakeMultiThread();
+        multiDone->wait();
         // And finally clean up
-        __lock_acquire(fetchesMutex);
-        __lock_acquire(multiHandleMutex);
         for (const auto& i : fetches)
         {
-            curl_multi_remove_handle(multiHandle, i.fetch->curl.get());
+            curl_multi_remove_handle(multiHandle, i.first);
         }
         fetches.clear();
-        __lock_release(fetchesMutex);
-        __lock_close(fetchesMutex);
+        __lock_acquire(pendingMutex);
+        pendingFetches.clear();
+        pendingCancels.clear();
+        __lock_release(pendingMutex);
+        __lock_close(pendingMutex);
         curl_multi_cleanup(multiHandle);
-        __lock_release(multiHandleMutex);
-        __lock_close(multiHandleMutex);
+        // Fails if some easy handle still uses it, in which case it and its locks are leaked
+        if (shareHandle && curl_share_cleanup(shareHandle) == CURLSHE_OK)
+        {
+            for (auto& lock : shareLocks)
+            {
+                __lock_close(lock);
+            }
+        }
+        shareHandle      = nullptr;
+        multiInitialized = false;
     }
 }
 
@@ -255,16 +657,15 @@ CURLMcode Fetch::performAsync(
 {
     if (multiInitialized)
     {
-        __lock_acquire(multiHandleMutex);
-        CURLMcode res = curl_multi_add_handle(multiHandle, fetch->curl.get());
-        __lock_release(multiHandleMutex);
-        if (res == CURLM_OK)
+        if (!fetch)
         {
-            __lock_acquire(fetchesMutex);
-            fetches.emplace_back(fetch, onComplete);
-            __lock_release(fetchesMutex);
+            return CURLM_BAD_EASY_HANDLE;
         }
-        return res;
+        __lock_acquire(pendingMutex);
+        pendingFetches.emplace_back(fetch, onComplete);
+        __lock_release(pendingMutex);
+        wakeMultiThread();
+        return CURLM_OK;
     }
     else
     {
@@ -272,27 +673,33 @@ CURLMcode Fetch::performAsync(
     }
 }
 
+void Fetch::cancel(const std::shared_ptr<Fetch>& fetch)
+{
+    if (multiInitialized && fetch)
+    {
+        __lock_acquire(pendingMutex);
+        pendingCancels.emplace_back(fetch);
+        __lock_release(pendingMutex);
+        wakeMultiThread();
+    }
+}
+
 std::variant<CURLMcode, CURLcode> Fetch::perform(std::shared_ptr<Fetch> fetch)
 {
     if (multiInitialized)
     {
         CURLcode cres;
-        std::atomic_flag wait;
-        wait.test_and_set();
-        CURLMcode mRes = performAsync(fetch, [&cres, &wait](CURLcode code, std::shared_ptr<Fetch>) {
+        Threads::Event done;
+        CURLMcode mRes = performAsync(fetch, [&cres, &done](CURLcode code, std::shared_ptr<Fetch>) {
             cres = code;
-            wait.clear();
+            done.signal();
         });
         if (mRes != CURLM_OK)
         {
             return mRes;
         }
 
-        while (wait.test_and_set())
-        {
-            constexpr timespec sleepTime = {0, 100000};
-            nanosleep(&sleepTime, nullptr);
-        }
+        done.wait();
 
         return cres;
     }
@@ -301,3 +708,94 @@ std::variant<CURLMcode, CURLcode> Fetch::perform(std::shared_ptr<Fetch> fetch)
         return CURLM_LAST;
     }
 }
+
+bool Fetch::performCached(const std::string& url, struct curl_slist* headers,
+    std::function<void(CURLcode, long, const std::string&, bool)> onComplete,
+    std::shared_ptr<Fetch>* transfer)
+{
+    // Headers can change the response, so they are part of the key
+    std::string key = url;
+    for (struct curl_slist* header = headers; header; header = header->next)
+    {
+        key += '\n';
+        key += header->data;
+    }
+
+    auto request = std::make_shared<CachedRequest>();
+    for (struct curl_slist* header = headers; header; header = header->next)
+    {
+        request->headers = curl_slist_append(request->headers, header->data);
+    }
+
+    if (auto cached = FetchCache::get(key))
+    {
+        onComplete(CURLE_OK, 200, cached->body, true);
+        if (cached->fresh())
+        {
+            return true;
+        }
+
+        if (!cached->etag.empty())
+        {
+            request->headers =
+                curl_slist_append(request->headers, ("If-None-Match: " + cached->etag).c_str());
+        }
+        if (!cached->lastModified.empty())
+        {
+            request->headers = curl_slist_append(
+                request->headers, ("If-Modified-Since: " + cached->lastModified).c_str());
+        }
+        request->cachedBody = std::move(cached->body);
+    }
+
+    const bool revalidating = request->cachedBody.has_value();
+    auto fetch =
+        Fetch::init(url, url.substr(0, 5) == "https", &request->body, request->headers, "");
+    if (!fetch)
+    {
+        return revalidating;
+    }
+    fetch->setopt(CURLOPT_HEADERFUNCTION, cache_header_callback);
+    fetch->setopt(CURLOPT_HEADERDATA, request.get());
+
+    CURLMcode res = performAsync(fetch, [request, key, onComplete = std::move(onComplete)](
+                                            CURLcode code, std::shared_ptr<Fetch> fetch) {
+        long status = 0;
+        if (code == CURLE_OK)
+        {
+            fetch->getinfo(CURLINFO_RESPONSE_CODE, &status);
+        }
+
+        if (status == 304 && request->cachedBody)
+        {
+            FetchCache::touch(key, request->maxAge);
+        }
+        else if (status == 200)
+        {
+            if (request->cacheable)
+            {
+                FetchCache::put(key, {request->body, request->etag, request->lastModified,
+                                         time(nullptr), request->maxAge});
+            }
+            else
+            {
+                FetchCache::remove(key);
+            }
+            if (request->cachedBody != request->body)
+            {
+                onComplete(code, status, request->body, false);
+            }
+        }
+        else if (!request->cachedBody)
+        {
+            onComplete(code, status, request->body, false);
+        }
+    });
+
+    if (res == CURLM_OK && transfer)
+    {
+        *transfer = fetch;
+    }
+
+    return res == CURLM_OK || revalidating;
+}
@@ -0,0 +1,355 @@
+/*
+ *   This file is part of PKSM
+ *   Copyright (C) 2016-2020 Bernardo Giordano, Admiral Fish, piepie62, Allen Lydiard
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+
+#include "fetchcache.hpp"
+#include "STDirectory.hpp"
+#include "format.h"
+#include <list>
+#include <stdio.h>
+#include <unordered_map>
+extern "C" {
+#include <sys/lock.h>
+}
+
+namespace
+{
+    constexpr u32 CACHE_MAGIC   = 0x43484B50; // PKHC
+    constexpr u32 CACHE_VERSION = 1;
+    // Offset of the stored time in an entry file, so that it can be updated in place
+    constexpr long STORED_OFFSET = 8;
+
+    struct IndexEntry
+    {
+        u64 hash;
+        u32 size;
+    };
+
+    std::string cacheRoot;
+    size_t maxCacheBytes  = 0;
+    size_t cacheBytes     = 0;
+    bool cacheInitialized = false;
+    // Least recently used entry first
+    std::list<IndexEntry> lru;
+    std::unordered_map<u64, std::list<IndexEntry>::iterator> lookup;
+    _LOCK_T cacheMutex;
+
+    u64 hashKey(const std::string& key)
+    {
+        // FNV-1a
+        u64 hash = 0xCBF29CE484222325;
+        for (char c : key)
+        {
+            hash ^= (u8)c;
+            hash *= 0x100000001B3;
+        }
+        return hash;
+    }
+
+    std::string entryPath(u64 hash)
+    {
+        return fmt::format(FMT_STRING("{:s}/{:016X}"), cacheRoot, hash);
+    }
+
+    std::string indexPath()
+    {
+        return cacheRoot + "/index";
+    }
+
+    template <typename T>
+    bool readValue(FILE* file, T& out)
+    {
+        return fread(&out, sizeof(T), 1, file) == 1;
+    }
+
+    template <typename T>
+    bool writeValue(FILE* file, const T& in)
+    {
+        return fwrite(&in, sizeof(T), 1, file) == 1;
+    }
+
+    template <typename Length>
+    bool readString(FILE* file, std::string& out)
+    {
+        Length length;
+        if (!readValue(file, length))
+        {
+            return false;
+        }
+        out.resize(length);
+        return length == 0 || fread(out.data(), 1, length, file) == length;
+    }
+
+    template <typename Length>
+    bool writeString(FILE* file, const std::string& in)
+    {
+        Length length = in.size();
+        return writeValue(file, length) && fwrite(in.data(), 1, length, file) == length;
+    }
+
+    // Must hold cacheMutex
+    void eraseEntry(u64 hash)
+    {
+        auto found = lookup.find(hash);
+        if (found != lookup.end())
+        {
+            cacheBytes -= found->second->size;
+            lru.erase(found->second);
+            lookup.erase(found);
+        }
+        ::remove(entryPath(hash).c_str());
+    }
+
+    // Must hold cacheMutex
+    void evict()
+    {
+        // Always keep the most recent entry, even if it's larger than the whole budget
+        while (cacheBytes > maxCacheBytes && lru.size() > 1)
+        {
+            eraseEntry(lru.front().hash);
+        }
+    }
+
+    void loadIndex()
+    {
+        FILE* file = fopen(indexPath().c_str(), "rb");
+        if (file)
+        {
+            u32 magic, version, count;
+            if (readValue(file, magic) && magic == CACHE_MAGIC && readValue(file, version) &&
+                version == CACHE_VERSION && readValue(file, count))
+            {
+                for (u32 i = 0; i < count; i++)
+                {
+                    IndexEntry entry;
+                    if (!readValue(file, entry.hash) || !readValue(file, entry.size))
+                    {
+                        break;
+                    }
+                    if (!lookup.count(entry.hash))
+                    {
+                        lookup[entry.hash] = lru.insert(lru.end(), entry);
+                        cacheBytes += entry.size;
+                    }
+                }
+            }
+            fclose(file);
+        }
+
+        // Anything the index doesn't know about was written by a session that didn't exit cleanly
+        STDirectory dir(cacheRoot);
+        if (dir.good())
+        {
+            for (size_t i = 0; i < dir.count(); i++)
+            {
+                const std::string name = dir.item(i);
+                if (dir.folder(i) || name == "index")
+                {
+                    continue;
+                }
+                char* end;
+                u64 hash = strtoull(name.c_str(), &end, 16);
+                if (*end != '\0' || !lookup.count(hash))
+                {
+                    ::remove((cacheRoot + '/' + name).c_str());
+                }
+            }
+        }
+    }
+
+    void saveIndex()
+    {
+        FILE* file = fopen(indexPath().c_str(), "wb");
+        if (file)
+        {
+            writeValue(file, CACHE_MAGIC);
+            writeValue(file, CACHE_VERSION);
+            writeValue(file, (u32)lru.size());
+            for (const auto& entry : lru)
+            {
+                writeValue(file, entry.hash);
+                writeValue(file, entry.size);
+            }
+            fclose(file);
+        }
+    }
+}
+
+void FetchCache::init(const std::string& root, size_t maxBytes)
+{
+    __lock_init(cacheMutex);
+    cacheRoot     = root;
+    maxCacheBytes = maxBytes;
+    cacheBytes    = 0;
+    lru.clear();
+    lookup.clear();
+    loadIndex();
+    evict();
+    // Until a clean exit rewrites it, the index no longer reflects what's on disk
+    ::remove(indexPath().c_str());
+    cacheInitialized = true;
+}
+
+void FetchCache::exit(void)
+{
+    if (cacheInitialized)
+    {
+        __lock_acquire(cacheMutex);
+        saveIndex();
+        cacheInitialized = false;
+        lru.clear();
+        lookup.clear();
+        __lock_release(cacheMutex);
+        __lock_close(cacheMutex);
+    }
+}
+
+bool FetchCache::initialized(void)
+{
+    return cacheInitialized;
+}
+
+std::optional<FetchCache::Entry> FetchCache::get(const std::string& key)
+{
+    if (!cacheInitialized)
+    {
+        return std::nullopt;
+    }
+
+    const u64 hash = hashKey(key);
+    std::optional<Entry> ret;
+
+    __lock_acquire(cacheMutex);
+    auto found = lookup.find(hash);
+    if (found != lookup.end())
+    {
+        lru.splice(lru.end(), lru, found->second);
+
+        FILE* file = fopen(entryPath(hash).c_str(), "rb");
+        if (file)
+        {
+            u32 magic, version;
+            u64 stored;
+            std::string storedKey;
+            Entry entry;
+            if (readValue(file, magic) && magic == CACHE_MAGIC && readValue(file, version) &&
+                version == CACHE_VERSION && readValue(file, stored) &&
+                readValue(file, entry.maxAge) && readString<u16>(file, storedKey) &&
+                storedKey == key && readString<u16>(file, entry.etag) &&
+                readString<u16>(file, entry.lastModified) && readString<u32>(file, entry.body))
+            {
+                entry.stored = (time_t)stored;
+                ret          = std::move(entry);
+            }
+            fclose(file);
+        }
+
+        if (!ret)
+        {
+            eraseEntry(hash);
+        }
+    }
+    __lock_release(cacheMutex);
+
+    return ret;
+}
+
+void FetchCache::put(const std::string& key, const Entry& entry)
+{
+    if (!cacheInitialized)
+    {
+        return;
+    }
+
+    const u64 hash = hashKey(key);
+
+    __lock_acquire(cacheMutex);
+    eraseEntry(hash);
+
+    const std::string path = entryPath(hash);
+    FILE* file             = fopen(path.c_str(), "wb");
+    if (file)
+    {
+        bool written = writeValue(file, CACHE_MAGIC) && writeValue(file, CACHE_VERSION) &&
+                       writeValue(file, (u64)entry.stored) && writeValue(file, entry.maxAge) &&
+                       writeString<u16>(file, key) && writeString<u16>(file, entry.etag) &&
+                       writeString<u16>(file, entry.lastModified) &&
+                       writeString<u32>(file, entry.body);
+        u32 size = ftell(file);
+        fclose(file);
+
+        if (written)
+        {
+            lookup[hash] = lru.insert(lru.end(), IndexEntry{hash, size});
+            cacheBytes += size;
+            evict();
+        }
+        else
+        {
+            ::remove(path.c_str());
+        }
+    }
+    __lock_release(cacheMutex);
+}
+
+void FetchCache::touch(const std::string& key, u32 maxAge)
+{
+    if (!cacheInitialized)
+    {
+        return;
+    }
+
+    const u64 hash = hashKey(key);
+
+    __lock_acquire(cacheMutex);
+    auto found = lookup.find(hash);
+    if (found != lookup.end())
+    {
+        lru.splice(lru.end(), lru, found->second);
+
+        FILE* file = fopen(entryPath(hash).c_str(), "r+b");
+        if (file)
+        {
+            fseek(file, STORED_OFFSET, SEEK_SET);
+            writeValue(file, (u64)time(nullptr));
+            writeValue(file, maxAge);
+            fclose(file);
+        }
+    }
+    __lock_release(cacheMutex);
+}
+
+void FetchCache::remove(const std::string& key)
+{
+    if (!cacheInitialized)
+    {
+        return;
+    }
+
+    __lock_acquire(cacheMutex);
+    eraseEntry(hashKey(key));
+    __lock_release(cacheMutex);
+}
@@ -0,0 +1,293 @@
+/*
+ *   This file is part of PKSM
+ *   Copyright (C) 2016-2020 Bernardo Giordano, Admiral Fish, piepie62
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+
+#include "searchindex.hpp"
+#include "utils/i18n.hpp"
+#include <algorithm>
+#include <memory>
+#include <unordered_map>
+
+namespace
+{
+    // Base letters of U+00C0 to U+017F. '*' marks ligatures and the like, which become two letters,
+    // and ' ' the few symbols in the range, which are kept
+    constexpr char LATIN_BASE[] = "aaaaaa*ceeeeiiiidnooooo ouuuuy**aaaaaa*ceeeeiiii"
+                                  "dnooooo ouuuuy*yaaaaaaccccccccddddeeeeeeeeeegggg"
+                                  "gggghhhhiiiiiiiiii**jjkkkllllllllllnnnnnnnnnoooo"
+                                  "oo**rrrrrrssssssssttttttuuuuuuuuuuuuwwyyyzzzzzzs";
+
+    struct CachedIndex
+    {
+        pksm::Language lang;
+        pksm::Generation gen;
+        std::unique_ptr<SearchIndex> index;
+    };
+
+    std::vector<CachedIndex> moveIndices;
+    std::vector<CachedIndex> itemIndices;
+    std::vector<CachedIndex> locationIndices;
+    std::unordered_map<pksm::Language, std::unique_ptr<SearchIndex>> speciesIndices;
+
+    template <typename Build>
+    const SearchIndex& cached(
+        std::vector<CachedIndex>& cache, pksm::Language lang, pksm::Generation gen, Build build)
+    {
+        for (const auto& entry : cache)
+        {
+            if (entry.lang == lang && entry.gen == gen)
+            {
+                return *entry.index;
+            }
+        }
+        cache.push_back({lang, gen, std::make_unique<SearchIndex>(build())});
+        return *cache.back().index;
+    }
+
+    std::vector<std::pair<u16, std::string>> tableNames(const std::vector<std::string>& table)
+    {
+        std::vector<std::pair<u16, std::string>> ret;
+        ret.reserve(table.size());
+        for (size_t i = 0; i < table.size(); i++)
+        {
+            ret.emplace_back(i, table[i]);
+        }
+        return ret;
+    }
+
+    // Decodes the UTF-8 sequence at pos. Returns its length, or 0 if it isn't valid
+    size_t decodeUtf8(const std::string& str, size_t pos, u32& codepoint)
+    {
+        u8 lead = str[pos];
+        size_t length;
+        if (lead < 0x80)
+        {
+            codepoint = lead;
+            return 1;
+        }
+        else if ((lead & 0xE0) == 0xC0)
+        {
+            codepoint = lead & 0x1F;
+            length    = 2;
+        }
+        else if ((lead & 0xF0) == 0xE0)
+        {
+            codepoint = lead & 0x0F;
+            length    = 3;
+        }
+        else if ((lead & 0xF8) == 0xF0)
+        {
+            codepoint = lead & 0x07;
+            length    = 4;
+        }
+        else
+        {
+            return 0;
+        }
+
+        if (pos + length > str.size())
+        {
+            return 0;
+        }
+        for (size_t i = 1; i < length; i++)
+        {
+            u8 continuation = str[pos + i];
+            if ((continuation & 0xC0) != 0x80)
+            {
+                return 0;
+            }
+            codepoint = (codepoint << 6) | (continuation & 0x3F);
+        }
+        return length;
+    }
+
+    void appendUtf8(std::string& str, u32 codepoint)
+    {
+        if (codepoint < 0x80)
+        {
+            str += (char)codepoint;
+        }
+        else if (codepoint < 0x800)
+        {
+            str += (char)(0xC0 | (codepoint >> 6));
+            str += (char)(0x80 | (codepoint & 0x3F));
+        }
+        else
+        {
+            str += (char)(0xE0 | (codepoint >> 12));
+            str += (char)(0x80 | ((codepoint >> 6) & 0x3F));
+            str += (char)(0x80 | (codepoint & 0x3F));
+        }
+    }
+}
+
+SearchIndex::SearchIndex(const std::vector<std::pair<u16, std::string>>& names)
+{
+    std::vector<std::pair<std::string, u16>> entries;
+    entries.reserve(names.size());
+    u16 maxId = 0;
+    for (const auto& name : names)
+    {
+        entries.emplace_back(fold(name.second), name.first);
+        maxId = std::max(maxId, name.first);
+    }
+    std::sort(entries.begin(), entries.end());
+
+    keys.reserve(entries.size());
+    ids.reserve(entries.size());
+    ranks.assign(entries.empty() ? 0 : maxId + 1, NOT_INDEXED);
+    for (auto& entry : entries)
+    {
+        ranks[entry.second] = ids.size();
+        keys.emplace_back(std::move(entry.first));
+        ids.emplace_back(entry.second);
+    }
+}
+
+SearchIndex::Matches SearchIndex::find(const std::string& prefix) const
+{
+    const std::string key = fold(prefix);
+    auto first            = std::lower_bound(keys.begin(), keys.end(), key);
+    auto last = std::partition_point(first, keys.end(),
+        [&key](const std::string& name) { return name.compare(0, key.size(), key) == 0; });
+    return Matches(this, first - keys.begin(), last - keys.begin());
+}
+
+std::string SearchIndex::fold(const std::string& str)
+{
+    std::string ret;
+    ret.reserve(str.size());
+    for (size_t pos = 0; pos < str.size();)
+    {
+        u32 codepoint;
+        size_t length = decodeUtf8(str, pos, codepoint);
+        if (length == 0)
+        {
+            // Not UTF-8; keep the byte so that it can still match itself
+            ret += str[pos++];
+            continue;
+        }
+
+        // Full-width Latin, as typed with the Japanese keyboard
+        if (codepoint >= 0xFF01 && codepoint <= 0xFF5E)
+        {
+            codepoint -= 0xFEE0;
+        }
+
+        if (codepoint >= 'A' && codepoint <= 'Z')
+        {
+            ret += (char)(codepoint - 'A' + 'a');
+        }
+        else if (codepoint < 0x80)
+        {
+            ret += (char)codepoint;
+        }
+        else if (codepoint >= 0xC0 && codepoint <= 0x17F && LATIN_BASE[codepoint - 0xC0] != ' ')
+        {
+            switch (codepoint)
+            {
+                case 0xC6: // Æ
+                case 0xE6: // æ
+                    ret += "ae";
+                    break;
+                case 0xDE: // Þ
+                case 0xFE: // þ
+                    ret += "th";
+                    break;
+                case 0xDF: // ß
+                    ret += "ss";
+                    break;
+                case 0x132: // Ĳ
+                case 0x133: // ĳ
+                    ret += "ij";
+                    break;
+                case 0x152: // Œ
+                case 0x153: // œ
+                    ret += "oe";
+                    break;
+                default:
+                    ret += LATIN_BASE[codepoint - 0xC0];
+                    break;
+            }
+        }
+        // Katakana to hiragana
+        else if (codepoint >= 0x30A1 && codepoint <= 0x30F6)
+        {
+            appendUtf8(ret, codepoint - 0x60);
+        }
+        else
+        {
+            ret.append(str, pos, length);
+        }
+        pos += length;
+    }
+    return ret;
+}
+
+const SearchIndex& SearchIndex::moves(pksm::Language lang)
+{
+    return cached(moveIndices, lang, pksm::Generation::EIGHT,
+        [lang]() { return tableNames(i18n::rawMoves(lang)); });
+}
+
+const SearchIndex& SearchIndex::items(pksm::Language lang, pksm::Generation gen)
+{
+    // Everything after generation three shares a table
+    if (gen != pksm::Generation::THREE)
+    {
+        gen = pksm::Generation::EIGHT;
+    }
+    return cached(itemIndices, lang, gen, [lang, gen]() {
+        return tableNames(
+            gen == pksm::Generation::THREE ? i18n::rawItems3(lang) : i18n::rawItems(lang));
+    });
+}
+
+const SearchIndex& SearchIndex::locations(pksm::Language lang, pksm::Generation gen)
+{
+    return cached(locationIndices, lang, gen, [lang, gen]() {
+        const auto& locations = i18n::rawLocations(lang, gen);
+        return std::vector<std::pair<u16, std::string>>(locations.begin(), locations.end());
+    });
+}
+
+const SearchIndex& SearchIndex::species(
+    pksm::Language lang, const std::set<pksm::Species>& available)
+{
+    auto& index     = speciesIndices[lang];
+    const u16 maxId = available.empty() ? 0 : u16(*available.rbegin());
+    if (!index || index->ranks.size() <= maxId)
+    {
+        std::vector<std::pair<u16, std::string>> names;
+        names.reserve(maxId + 1);
+        for (u16 i = 0; i <= maxId; i++)
+        {
+            names.emplace_back(i, i18n::species(lang, pksm::Species{i}));
+        }
+        index = std::make_unique<SearchIndex>(names);
+    }
+    return *index;
+}
@@ -0,0 +1,186 @@
+/*
+ *   This file is part of PKSM
+ *   Copyright (C) 2016-2020 Bernardo Giordano, Admiral Fish, piepie62
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#ifndef HOST_3DS_H
+#define HOST_3DS_H
+
+// The part of libctru used by the sources the host script runner builds, backed by the host in
+// source/ctru.cpp. Values match libctru's where they are stored or compared against real data
+
+#include "3ds/types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SYSCLOCK_ARM11 268111856LL
+
+// Ticks of a steady host clock, counted at the 3DS's rate so callers can keep converting with
+// SYSCLOCK_ARM11
+u64 svcGetSystemTick(void);
+
+typedef enum
+{
+    PATH_INVALID = 0,
+    PATH_EMPTY   = 1,
+    PATH_BINARY  = 2,
+    PATH_ASCII   = 3,
+    PATH_UTF16   = 4
+} FS_PathType;
+
+typedef struct
+{
+    FS_PathType type;
+    u32 size;
+    const void* data;
+} FS_Path;
+
+FS_Path fsMakePath(FS_PathType type, const void* path);
+
+enum
+{
+    FS_OPEN_READ   = BIT(0),
+    FS_OPEN_WRITE  = BIT(1),
+    FS_OPEN_CREATE = BIT(2)
+};
+
+enum
+{
+    FS_ATTRIBUTE_DIRECTORY = BIT(0),
+    FS_ATTRIBUTE_HIDDEN    = BIT(8),
+    FS_ATTRIBUTE_ARCHIVE   = BIT(16),
+    FS_ATTRIBUTE_READ_ONLY = BIT(24)
+};
+
+typedef enum
+{
+    MEDIATYPE_NAND      = 0,
+    MEDIATYPE_SD        = 1,
+    MEDIATYPE_GAME_CARD = 2
+} FS_MediaType;
+
+typedef enum
+{
+    ARCHIVE_USER_SAVEDATA        = 0x00000004,
+    ARCHIVE_EXTDATA              = 0x00000006,
+    ARCHIVE_SDMC                 = 0x00000009,
+    ARCHIVE_SAVEDATA_AND_CONTENT = 0x2345678A
+} FS_ArchiveID;
+
+typedef u64 FSPXI_File;
+typedef u64 FSPXI_Directory;
+
+typedef struct
+{
+    u16 name[0x106];
+    char shortName[0x0A];
+    char shortExt[0x04];
+    u8 valid;
+    u8 reserved;
+    u32 attributes;
+    u64 fileSize;
+} FS_DirectoryEntry;
+
+typedef enum
+{
+    CFG_LANGUAGE_JP = 0,
+    CFG_LANGUAGE_EN = 1,
+    CFG_LANGUAGE_FR = 2,
+    CFG_LANGUAGE_DE = 3,
+    CFG_LANGUAGE_IT = 4,
+    CFG_LANGUAGE_ES = 5,
+    CFG_LANGUAGE_ZH = 6,
+    CFG_LANGUAGE_KO = 7,
+    CFG_LANGUAGE_NL = 8,
+    CFG_LANGUAGE_PT = 9,
+    CFG_LANGUAGE_RU = 10,
+    CFG_LANGUAGE_TW = 11
+} CFG_Language;
+
+// Always English, and zeroed country and region data
+Result CFGU_GetSystemLanguage(u8* language);
+Result CFGU_GetConfigInfoBlk2(u32 size, u32 blkID, void* outData);
+Result CFGU_SecureInfoGetRegion(u8* region);
+
+typedef enum
+{
+    SWKBD_TYPE_NORMAL = 0,
+    SWKBD_TYPE_QWERTY,
+    SWKBD_TYPE_NUMPAD,
+    SWKBD_TYPE_WESTERN
+} SwkbdType;
+
+typedef enum
+{
+    SWKBD_ANYTHING = 0,
+    SWKBD_NOTEMPTY,
+    SWKBD_NOTEMPTY_NOTBLANK,
+    SWKBD_NOTBLANK_NOTEMPTY = SWKBD_NOTEMPTY_NOTBLANK,
+    SWKBD_NOTBLANK,
+    SWKBD_FIXEDLEN
+} SwkbdValidInput;
+
+enum
+{
+    SWKBD_FILTER_DIGITS    = BIT(0),
+    SWKBD_FILTER_AT        = BIT(1),
+    SWKBD_FILTER_PERCENT   = BIT(2),
+    SWKBD_FILTER_BACKSLASH = BIT(3),
+    SWKBD_FILTER_PROFANITY = BIT(4),
+    SWKBD_FILTER_CALLBACK  = BIT(5)
+};
+
+typedef enum
+{
+    SWKBD_BUTTON_LEFT = 0,
+    SWKBD_BUTTON_MIDDLE,
+    SWKBD_BUTTON_RIGHT,
+    SWKBD_BUTTON_CONFIRM = SWKBD_BUTTON_RIGHT,
+    SWKBD_BUTTON_NONE
+} SwkbdButton;
+
+// Only what the host keyboard needs; text comes from the runner's answers instead of a keyboard
+typedef struct
+{
+    SwkbdType type;
+    int numButtons;
+    int maxTextLength;
+    SwkbdValidInput validInput;
+    char hintText[256];
+} SwkbdState;
+
+void swkbdInit(SwkbdState* swkbd, SwkbdType type, int numButtons, int maxTextLength);
+void swkbdSetHintText(SwkbdState* swkbd, const char* text);
+void swkbdSetValidation(
+    SwkbdState* swkbd, SwkbdValidInput validInput, u32 filterFlags, int maxDigits);
+void swkbdSetButton(SwkbdState* swkbd, SwkbdButton button, const char* text, bool submit);
+SwkbdButton swkbdInputText(SwkbdState* swkbd, char* buf, size_t bufsize);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,45 @@
+/*
+ *   This file is part of PKSM
+ *   Copyright (C) 2016-2020 Bernardo Giordano, Admiral Fish, piepie62
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#ifndef HOSTINPUT_HPP
+#define HOSTINPUT_HPP
+
+#include <optional>
+#include <string>
+
+// What a player would enter on the console. Answers come from the file given to the runner, one
+// per line, and then from stdin
+namespace HostInput
+{
+    // Returns false if the file can't be opened
+    bool load(const std::string& path);
+    // Shows prompt on stderr and returns the next answer, or nothing once input has run out
+    std::optional<std::string> next(const std::string& prompt);
+    // The next answer as a number, or fallback if input has run out or it isn't one
+    long nextNumber(const std::string& prompt, long fallback);
+}
+
+#endif
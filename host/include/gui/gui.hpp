@@ -0,0 +1,58 @@
+/*
+ *   This file is part of PKSM
+ *   Copyright (C) 2016-2020 Bernardo Giordano, Admiral Fish, piepie62
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#ifndef GUI_HPP
+#define GUI_HPP
+
+// Stands in for common/include/gui/gui.hpp in the host script runner. Messages go to stderr and
+// questions are answered through HostInput; nothing is drawn
+
+#include "PKX.hpp"
+#include "enums/Language.hpp"
+#include "utils/i18n.hpp"
+#include <3ds.h>
+#include <optional>
+#include <string>
+
+namespace Gui
+{
+    // Runs a script screen from gui/scripts to completion and returns what it chose
+    template <typename S>
+    auto runScreen(S& s)
+    {
+        return s.run();
+    }
+
+    bool showChoiceMessage(const std::string& message, int timer = 0);
+    // partial and total are in KB
+    void showProgress(const std::string& message, u32 partial, u32 total);
+    void waitFrame(const std::string& message);
+    void warn(const std::string& message, std::optional<pksm::Language> forceLang = std::nullopt);
+    void error(const std::string& message, Result errorCode);
+    void showResizeStorage(void);
+}
+
+#endif
@@ -0,0 +1,54 @@
+/*
+ *   This file is part of PKSM
+ *   Copyright (C) 2016-2020 Bernardo Giordano, Admiral Fish, piepie62
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#ifndef BANKCHOICE_HPP
+#define BANKCHOICE_HPP
+
+#include "HostInput.hpp"
+#include "banks.hpp"
+#include <string>
+
+// Host stand-in for the bank picker. The answer is the name of the bank to switch to; an empty
+// one keeps the current bank
+class BankChoice
+{
+public:
+    std::nullptr_t run()
+    {
+        std::string prompt = "Choose a bank:";
+        for (const auto& [name, boxes] : Banks::bankNames())
+        {
+            prompt += "\n  " + name + " (" + std::to_string(boxes) + " boxes)";
+        }
+        if (auto answer = HostInput::next(prompt); answer && !answer->empty())
+        {
+            Banks::loadBank(*answer);
+        }
+        return nullptr;
+    }
+};
+
+#endif
@@ -0,0 +1,75 @@
+/*
+ *   This file is part of PKSM
+ *   Copyright (C) 2016-2020 Bernardo Giordano, Admiral Fish, piepie62
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#ifndef STORAGESCREEN_HPP
+#define STORAGESCREEN_HPP
+
+#include "HostInput.hpp"
+#include "loader.hpp"
+#include <sstream>
+#include <tuple>
+
+// Host stand-in for the slot picker. The answer is "<storage> <box> <slot>", where storage is 1 for
+// the bank and 0 for the save; anything else cancels, like B does on the console
+class BoxChoice
+{
+public:
+    BoxChoice(bool doCrypt) : doCrypt(doCrypt)
+    {
+        if (doCrypt)
+        {
+            TitleLoader::save->cryptBoxData(true);
+        }
+    }
+    ~BoxChoice()
+    {
+        if (doCrypt)
+        {
+            TitleLoader::save->cryptBoxData(false);
+        }
+    }
+    BoxChoice(const BoxChoice&) = delete;
+    BoxChoice& operator=(const BoxChoice&) = delete;
+
+    std::tuple<int, int, int> run()
+    {
+        if (auto answer = HostInput::next("Choose a slot: <storage 0/1> <box> <slot>"))
+        {
+            std::istringstream in(*answer);
+            int storage, box, slot;
+            if (in >> storage >> box >> slot)
+            {
+                return std::make_tuple(storage, box, slot);
+            }
+        }
+        return std::make_tuple(0, -1, -1);
+    }
+
+private:
+    bool doCrypt;
+};
+
+#endif
@@ -0,0 +1,63 @@
+/*
+ *   This file is part of PKSM
+ *   Copyright (C) 2016-2020 Bernardo Giordano, Admiral Fish, piepie62
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#ifndef FORTYCHOICE_HPP
+#define FORTYCHOICE_HPP
+
+#include "HostInput.hpp"
+#include <string>
+#include <vector>
+
+// Host stand-in for the 2x20 script menu. The answer is the index of the option chosen
+class FortyChoice
+{
+public:
+    FortyChoice(char* question, char** text, int items) : question(question), items(items)
+    {
+        for (int i = 0; i < items; i++)
+        {
+            labels.emplace_back(text[i]);
+        }
+    }
+
+    size_t run()
+    {
+        std::string prompt = question;
+        for (size_t i = 0; i < labels.size(); i++)
+        {
+            prompt += "\n  " + std::to_string(i) + ": " + labels[i];
+        }
+        long ret = HostInput::nextNumber(prompt, 0);
+        return ret >= 0 && ret < items ? ret : 0;
+    }
+
+private:
+    std::string question;
+    std::vector<std::string> labels;
+    const int items;
+};
+
+#endif
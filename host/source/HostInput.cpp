@@ -0,0 +1,72 @@
+/*
+ *   This file is part of PKSM
+ *   Copyright (C) 2016-2020 Bernardo Giordano, Admiral Fish, piepie62
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#include "HostInput.hpp"
+#include <fstream>
+#include <iostream>
+#include <stdlib.h>
+
+namespace
+{
+    std::ifstream answers;
+}
+
+bool HostInput::load(const std::string& path)
+{
+    answers.open(path);
+    return answers.is_open();
+}
+
+std::optional<std::string> HostInput::next(const std::string& prompt)
+{
+    std::cerr << prompt << "\n> " << std::flush;
+    std::string ret;
+    if ((answers.is_open() && std::getline(answers, ret)) || std::getline(std::cin, ret))
+    {
+        if (!ret.empty() && ret.back() == '\r')
+        {
+            ret.pop_back();
+        }
+        std::cerr << ret << '\n';
+        return ret;
+    }
+    std::cerr << "(no input)\n";
+    return std::nullopt;
+}
+
+long HostInput::nextNumber(const std::string& prompt, long fallback)
+{
+    if (auto answer = next(prompt))
+    {
+        char* end;
+        long ret = strtol(answer->c_str(), &end, 0);
+        if (end != answer->c_str() && *end == '\0')
+        {
+            return ret;
+        }
+    }
+    return fallback;
+}
@@ -0,0 +1,125 @@
+/*
+ *   This file is part of PKSM
+ *   Copyright (C) 2016-2020 Bernardo Giordano, Admiral Fish, piepie62
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#include "HostInput.hpp"
+#include <3ds.h>
+#include <algorithm>
+#include <chrono>
+#include <string.h>
+
+extern "C" {
+
+u64 svcGetSystemTick(void)
+{
+    static const auto start = std::chrono::steady_clock::now();
+    auto elapsed            = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start);
+    return (unsigned __int128)elapsed.count() * SYSCLOCK_ARM11 / 1000000000;
+}
+
+FS_Path fsMakePath(FS_PathType type, const void* path)
+{
+    FS_Path ret = {type, 0, path};
+    switch (type)
+    {
+        case PATH_ASCII:
+            ret.size = strlen((const char*)path) + 1;
+            break;
+        case PATH_UTF16:
+        {
+            const u16* str = (const u16*)path;
+            while (*str++) {}
+            ret.size = (const u8*)str - (const u8*)path;
+        }
+        break;
+        case PATH_EMPTY:
+            ret.size = 1;
+            ret.data = "";
+            break;
+        default:
+            break;
+    }
+    return ret;
+}
+
+Result CFGU_GetSystemLanguage(u8* language)
+{
+    *language = CFG_LANGUAGE_EN;
+    return 0;
+}
+
+Result CFGU_GetConfigInfoBlk2(u32 size, u32 blkID, void* outData)
+{
+    memset(outData, 0, size);
+    return 0;
+}
+
+Result CFGU_SecureInfoGetRegion(u8* region)
+{
+    *region = 0;
+    return 0;
+}
+
+void swkbdInit(SwkbdState* swkbd, SwkbdType type, int numButtons, int maxTextLength)
+{
+    *swkbd = SwkbdState{type, numButtons, maxTextLength, SWKBD_ANYTHING, {}};
+}
+
+void swkbdSetHintText(SwkbdState* swkbd, const char* text)
+{
+    strncpy(swkbd->hintText, text ? text : "", sizeof(swkbd->hintText) - 1);
+}
+
+void swkbdSetValidation(SwkbdState* swkbd, SwkbdValidInput validInput, u32, int)
+{
+    swkbd->validInput = validInput;
+}
+
+void swkbdSetButton(SwkbdState*, SwkbdButton, const char*, bool) {}
+
+// Once answers run out this confirms an empty string, so scripts that ask until they get
+// confirmation still finish
+SwkbdButton swkbdInputText(SwkbdState* swkbd, char* buf, size_t bufsize)
+{
+    std::string prompt = swkbd->type == SWKBD_TYPE_NUMPAD ? "Enter a number" : "Enter text";
+    if (swkbd->hintText[0])
+    {
+        prompt += std::string(" (") + swkbd->hintText + ')';
+    }
+    std::string answer = HostInput::next(prompt).value_or("");
+    if (swkbd->maxTextLength > 0 && answer.size() > (size_t)swkbd->maxTextLength)
+    {
+        answer.resize(swkbd->maxTextLength);
+    }
+    if (bufsize > 0)
+    {
+        size_t len = std::min(answer.size(), bufsize - 1);
+        memcpy(buf, answer.data(), len);
+        buf[len] = '\0';
+    }
+    return SWKBD_BUTTON_CONFIRM;
+}
+}
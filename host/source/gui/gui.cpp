@@ -0,0 +1,61 @@
+/*
+ *   This file is part of PKSM
+ *   Copyright (C) 2016-2020 Bernardo Giordano, Admiral Fish, piepie62
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#include "gui.hpp"
+#include "HostInput.hpp"
+#include "format.h"
+
+bool Gui::showChoiceMessage(const std::string& message, int)
+{
+    auto answer = HostInput::next(message + "\n(y/n)");
+    return answer && !answer->empty() && (answer->front() == 'y' || answer->front() == 'Y');
+}
+
+void Gui::showProgress(const std::string& message, u32 partial, u32 total)
+{
+    fmt::print(stderr, "{} {}/{} KB\n", message, partial, total);
+}
+
+void Gui::waitFrame(const std::string& message)
+{
+    fmt::print(stderr, "{}\n", message);
+}
+
+void Gui::warn(const std::string& message, std::optional<pksm::Language>)
+{
+    fmt::print(stderr, "Warning: {}\n", message);
+}
+
+void Gui::error(const std::string& message, Result errorCode)
+{
+    fmt::print(stderr, "Error: {}\n{}\n", message,
+        fmt::format(i18n::localize("ERROR_CODE"), (u32)errorCode));
+}
+
+void Gui::showResizeStorage(void)
+{
+    fmt::print(stderr, "{}\n", i18n::localize("STORAGE_RESIZE"));
+}
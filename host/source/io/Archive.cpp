@@ -0,0 +1,302 @@
+/*
+ *   This file is part of PKSM
+ *   Copyright (C) 2016-2020 Bernardo Giordano, Admiral Fish, piepie62
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#include "Archive.hpp"
+#include "hostfs.hpp"
+#include <errno.h>
+#include <fcntl.h>
+#include <filesystem>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// The SD card and PKSM's extdata are directories on the host; see Archive::init. The archive's
+// handle says which one it is, and 0 is a closed archive, like on the console
+
+namespace
+{
+    enum : u64
+    {
+        CLOSED,
+        SDMC,
+        EXTDATA
+    };
+
+    std::string roots[3];
+    Archive sdArchive;
+    Archive dataArchive;
+
+    Result errorCode(const std::error_code& ec)
+    {
+        return ec ? -ec.value() : 0;
+    }
+}
+
+std::string HostFS::path(const std::string& root, FS_Path path)
+{
+    switch (path.type)
+    {
+        case PATH_ASCII:
+            return root + (const char*)path.data;
+        case PATH_UTF16:
+            return root + StringUtils::UTF16toUTF8(std::u16string((const char16_t*)path.data));
+        default:
+            return root;
+    }
+}
+
+Archive::Archive(FS_ArchiveID id, FS_Path, bool pxi) : mPXI(pxi)
+{
+    switch (id)
+    {
+        case ARCHIVE_SDMC:
+            mHandle = SDMC;
+            break;
+        case ARCHIVE_EXTDATA:
+            mHandle = EXTDATA;
+            break;
+        default:
+            mHandle = CLOSED;
+            break;
+    }
+    mResult = mHandle == CLOSED ? -ENOENT : 0;
+}
+
+Archive::Archive(Archive&& other) : mHandle(other.mHandle), mResult(other.mResult), mPXI(other.mPXI)
+{
+    other.mHandle = CLOSED;
+}
+
+Archive& Archive::operator=(Archive&& other)
+{
+    if (&other != this)
+    {
+        close();
+        mHandle       = other.mHandle;
+        mPXI          = other.mPXI;
+        mResult       = other.mResult;
+        other.mHandle = CLOSED;
+    }
+    return *this;
+}
+
+// execPath is the host directory standing in for the SD card. PKSM's extdata is kept in its
+// extdata folder
+Result Archive::init(const std::string& execPath)
+{
+    std::error_code ec;
+    std::filesystem::path root = std::filesystem::absolute(execPath, ec).lexically_normal();
+    if (!root.has_filename())
+    {
+        root = root.parent_path();
+    }
+    roots[SDMC]    = root.string();
+    roots[EXTDATA] = roots[SDMC] + "/extdata";
+    std::filesystem::create_directories(roots[EXTDATA], ec);
+    if (ec)
+    {
+        return errorCode(ec);
+    }
+
+    sdArchive   = Archive{ARCHIVE_SDMC, fsMakePath(PATH_EMPTY, ""), false};
+    dataArchive = Archive{ARCHIVE_EXTDATA, fsMakePath(PATH_EMPTY, ""), false};
+    return 0;
+}
+
+void Archive::exit(void)
+{
+    sd().close();
+    data().close();
+}
+
+Archive& Archive::sd()
+{
+    return sdArchive;
+}
+
+Archive& Archive::data()
+{
+    return dataArchive;
+}
+
+Result Archive::moveDir(Archive& src, const std::u16string& dir, Archive& dst,
+    const std::u16string& dest, const TransferProgress& progress)
+{
+    std::string from = HostFS::path(roots[src.mHandle], fsMakePath(PATH_UTF16, dir.c_str()));
+    std::error_code ec;
+    // A dir that no longer exists was moved already
+    if (!std::filesystem::exists(from, ec))
+    {
+        return 0;
+    }
+    Result res;
+    if (R_FAILED(res = copyDir(src, dir, dst, dest, progress)))
+    {
+        return res;
+    }
+    std::filesystem::remove_all(from, ec);
+    return errorCode(ec);
+}
+
+Result Archive::copyDir(Archive& src, const std::u16string& dir, Archive& dst,
+    const std::u16string& dest, const TransferProgress& progress)
+{
+    std::string from = HostFS::path(roots[src.mHandle], fsMakePath(PATH_UTF16, dir.c_str()));
+    std::string to   = HostFS::path(roots[dst.mHandle], fsMakePath(PATH_UTF16, dest.c_str()));
+    std::error_code ec;
+    u64 total = 0;
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(from, ec))
+    {
+        if (entry.is_regular_file())
+        {
+            total += entry.file_size();
+        }
+    }
+    if (ec)
+    {
+        return errorCode(ec);
+    }
+    std::filesystem::remove_all(to, ec);
+    std::filesystem::copy(from, to, std::filesystem::copy_options::recursive, ec);
+    if (ec)
+    {
+        std::error_code ignored;
+        std::filesystem::remove_all(to, ignored);
+        return errorCode(ec);
+    }
+    if (progress)
+    {
+        progress(total, total);
+    }
+    return 0;
+}
+
+Result Archive::deleteDir(const std::u16string& path)
+{
+    std::error_code ec;
+    std::filesystem::remove_all(
+        HostFS::path(roots[mHandle], fsMakePath(PATH_UTF16, path.c_str())), ec);
+    return errorCode(ec);
+}
+
+Result Archive::moveFile(Archive& src, FS_Path file, Archive& dst, FS_Path dest)
+{
+    std::string to = HostFS::path(roots[dst.mHandle], dest);
+    std::error_code ec;
+    std::filesystem::remove(to, ec);
+    std::filesystem::rename(HostFS::path(roots[src.mHandle], file), to, ec);
+    return errorCode(ec);
+}
+
+Result Archive::copyFile(Archive& src, FS_Path file, Archive& dst, FS_Path dest)
+{
+    std::string to = HostFS::path(roots[dst.mHandle], dest);
+    std::error_code ec;
+    std::filesystem::copy_file(HostFS::path(roots[src.mHandle], file), to,
+        std::filesystem::copy_options::overwrite_existing, ec);
+    if (ec)
+    {
+        std::error_code ignored;
+        std::filesystem::remove(to, ignored);
+    }
+    return errorCode(ec);
+}
+
+Result Archive::createDir(FS_Path dir, u32)
+{
+    if (::mkdir(HostFS::path(roots[mHandle], dir).c_str(), 0777) != 0)
+    {
+        return mResult = -errno;
+    }
+    return mResult = 0;
+}
+
+std::unique_ptr<Directory> Archive::directory(FS_Path path)
+{
+    auto reader = readDirectory(path);
+    if (reader)
+    {
+        return std::unique_ptr<Directory>(new Directory(*reader));
+    }
+    return nullptr;
+}
+
+std::unique_ptr<DirectoryReader> Archive::readDirectory(
+    FS_Path path, std::u16string_view prefix, size_t batchSize)
+{
+    Handle dir;
+    if (R_SUCCEEDED(mResult = HostFS::openDirectory(HostFS::path(roots[mHandle], path), dir)))
+    {
+        return std::unique_ptr<DirectoryReader>(new DirectoryReader(dir, prefix, batchSize));
+    }
+    return nullptr;
+}
+
+// Like the console, this fails if the file is already there
+Result Archive::createFile(FS_Path file, u32, u64 size)
+{
+    int fd = ::open(HostFS::path(roots[mHandle], file).c_str(), O_WRONLY | O_CREAT | O_EXCL, 0666);
+    if (fd < 0)
+    {
+        return mResult = -errno;
+    }
+    mResult = ftruncate(fd, size) == 0 ? 0 : -errno;
+    ::close(fd);
+    return mResult;
+}
+
+std::unique_ptr<File> Archive::file(FS_Path file, u32 flags, u32)
+{
+    int mode = (flags & FS_OPEN_WRITE) ? ((flags & FS_OPEN_READ) ? O_RDWR : O_WRONLY) : O_RDONLY;
+    if (flags & FS_OPEN_CREATE)
+    {
+        mode |= O_CREAT;
+    }
+    int fd = ::open(HostFS::path(roots[mHandle], file).c_str(), mode, 0666);
+    if (fd < 0)
+    {
+        mResult = -errno;
+        return nullptr;
+    }
+    mResult = 0;
+    return std::unique_ptr<File>(new File((Handle)fd));
+}
+
+Result Archive::deleteFile(FS_Path file)
+{
+    return ::unlink(HostFS::path(roots[mHandle], file).c_str()) == 0 ? 0 : -errno;
+}
+
+Result Archive::close()
+{
+    mHandle = CLOSED;
+    return mResult = 0;
+}
+
+// Every write already went to the host's file system
+Result Archive::commit()
+{
+    return mResult = 0;
+}
@@ -0,0 +1,217 @@
+/*
+ *   This file is part of PKSM
+ *   Copyright (C) 2016-2020 Bernardo Giordano, Admiral Fish, piepie62
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#include "Directory.hpp"
+#include "hostfs.hpp"
+#include <algorithm>
+#include <errno.h>
+#include <fcntl.h>
+#include <mutex>
+#include <string.h>
+#include <sys/stat.h>
+#include <unordered_map>
+
+namespace
+{
+    std::mutex dirsMutex;
+    std::unordered_map<Handle, DIR*> dirs;
+    Handle nextDir = 1;
+}
+
+Result HostFS::openDirectory(const std::string& path, Handle& out)
+{
+    DIR* dir = opendir(path.c_str());
+    if (!dir)
+    {
+        return -errno;
+    }
+    std::lock_guard<std::mutex> lock(dirsMutex);
+    out       = nextDir++;
+    dirs[out] = dir;
+    return 0;
+}
+
+DIR* HostFS::directory(Handle handle)
+{
+    std::lock_guard<std::mutex> lock(dirsMutex);
+    auto found = dirs.find(handle);
+    return found == dirs.end() ? nullptr : found->second;
+}
+
+void HostFS::closeDirectory(Handle handle)
+{
+    std::lock_guard<std::mutex> lock(dirsMutex);
+    if (auto found = dirs.find(handle); found != dirs.end())
+    {
+        closedir(found->second);
+        dirs.erase(found);
+    }
+}
+
+DirectoryReader::DirectoryReader(Handle handle, std::u16string_view prefix, size_t batchSize)
+    : batch(std::max(batchSize, size_t(1))), prefix(prefix), handle(handle), pxi(false)
+{
+}
+
+// There is no PXI on the host; such a reader is simply empty
+DirectoryReader::DirectoryReader(
+    FSPXI_Directory handle, std::u16string_view prefix, size_t batchSize)
+    : batch(std::max(batchSize, size_t(1))), prefix(prefix), pxiHandle(handle), pxi(true),
+      open(false)
+{
+}
+
+DirectoryReader::~DirectoryReader()
+{
+    close();
+}
+
+void DirectoryReader::close(void)
+{
+    if (open)
+    {
+        HostFS::closeDirectory(handle);
+        open = false;
+    }
+}
+
+bool DirectoryReader::readBatch(void)
+{
+    DIR* dir = HostFS::directory(handle);
+    current  = 0;
+    filled   = 0;
+    errno    = 0;
+    while (dir && filled < batch.size())
+    {
+        struct dirent* ent = readdir(dir);
+        if (!ent)
+        {
+            err = -errno;
+            break;
+        }
+        if (!strcmp(ent->d_name, ".") || !strcmp(ent->d_name, ".."))
+        {
+            continue;
+        }
+
+        FS_DirectoryEntry& entry = batch[filled++];
+        entry                    = FS_DirectoryEntry{};
+        std::u16string name      = StringUtils::UTF8toUTF16(ent->d_name);
+        std::copy_n(name.begin(), std::min(name.size(), std::size(entry.name) - 1), entry.name);
+        struct stat info;
+        if (fstatat(dirfd(dir), ent->d_name, &info, 0) == 0)
+        {
+            entry.attributes = S_ISDIR(info.st_mode) ? FS_ATTRIBUTE_DIRECTORY : 0;
+            entry.fileSize   = S_ISDIR(info.st_mode) ? 0 : info.st_size;
+        }
+    }
+    if (filled == 0)
+    {
+        // Done with it, so don't hold the handle until the reader is destroyed
+        close();
+    }
+    return filled > 0;
+}
+
+bool DirectoryReader::next(void)
+{
+    while (true)
+    {
+        if (++current >= filled && (!open || !readBatch()))
+        {
+            return false;
+        }
+        if (name().substr(0, prefix.size()) == prefix)
+        {
+            return true;
+        }
+    }
+}
+
+Result DirectoryReader::error(void) const
+{
+    return err;
+}
+
+std::u16string_view DirectoryReader::name(void) const
+{
+    return (const char16_t*)batch[current].name;
+}
+
+bool DirectoryReader::folder(void) const
+{
+    return batch[current].attributes & FS_ATTRIBUTE_DIRECTORY;
+}
+
+u64 DirectoryReader::size(void) const
+{
+    return batch[current].fileSize;
+}
+
+const FS_DirectoryEntry& DirectoryReader::entry(void) const
+{
+    return batch[current];
+}
+
+Directory::Directory(DirectoryReader& reader)
+{
+    while (reader.next())
+    {
+        list.emplace_back(reader.entry());
+    }
+
+    err  = reader.error();
+    load = R_SUCCEEDED(err);
+    if (!load)
+    {
+        list.clear();
+    }
+}
+
+Result Directory::error(void) const
+{
+    return err;
+}
+
+bool Directory::loaded(void) const
+{
+    return load;
+}
+
+std::u16string Directory::item(size_t index) const
+{
+    return (char16_t*)list.at(index).name;
+}
+
+bool Directory::folder(size_t index) const
+{
+    return index < list.size() ? list.at(index).attributes == FS_ATTRIBUTE_DIRECTORY : false;
+}
+
+size_t Directory::count(void) const
+{
+    return list.size();
+}
@@ -0,0 +1,152 @@
+/*
+ *   This file is part of PKSM
+ *   Copyright (C) 2016-2020 Bernardo Giordano, Admiral Fish, piepie62
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#include "File.hpp"
+#include <algorithm>
+#include <errno.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// On the host a File's handle is a file descriptor from Archive::file. It's reset once closed, as
+// File::close may be called again by the destructor and the descriptor may be reused by then
+namespace
+{
+    constexpr Handle CLOSED = Handle(-1);
+
+    int fd(const std::variant<Handle, FSPXI_File>& handle)
+    {
+        return handle.index() == 0 ? (int)std::get<0>(handle) : -1;
+    }
+}
+
+File::File(Handle handle) : mHandle(handle), mSize(0), mOffset(0)
+{
+    struct stat info;
+    if (fstat((int)handle, &info) == 0)
+    {
+        mSize   = info.st_size;
+        mResult = 0;
+    }
+    else
+    {
+        mResult = -errno;
+    }
+}
+
+// There is no PXI on the host
+File::File(FSPXI_File handle) : mHandle(CLOSED), mSize(0), mOffset(0), mResult(-ENOSYS) {}
+
+Result File::close(void)
+{
+    if (mHandle.index() == 0 && std::get<0>(mHandle) != CLOSED)
+    {
+        mResult = ::close(fd(mHandle)) == 0 ? 0 : -errno;
+        mHandle = CLOSED;
+        return mResult;
+    }
+    return mResult;
+}
+
+Result File::result(void)
+{
+    return mResult;
+}
+
+u64 File::size(void)
+{
+    return mSize;
+}
+
+u32 File::read(void* buf, u32 sz)
+{
+    ssize_t rd = pread(fd(mHandle), buf, sz, mOffset);
+    if (rd < 0)
+    {
+        mResult = -errno;
+        return 0;
+    }
+    mResult = 0;
+    mOffset += rd;
+    return rd;
+}
+
+u32 File::write(const void* buf, u32 sz)
+{
+    ssize_t wt = pwrite(fd(mHandle), buf, sz, mOffset);
+    if (wt < 0)
+    {
+        mResult = -errno;
+        return 0;
+    }
+    mResult = 0;
+    mOffset += wt;
+    mSize = std::max(mSize, mOffset);
+    return wt;
+}
+
+bool File::eof(void)
+{
+    return mOffset >= mSize;
+}
+
+u64 File::offset(void)
+{
+    return mOffset;
+}
+
+void File::seek(s64 offset, int from)
+{
+    switch (from)
+    {
+        case SEEK_SET:
+            mOffset = offset;
+            break;
+        case SEEK_CUR:
+            mOffset += offset;
+            break;
+        case SEEK_END:
+            mOffset = mSize - offset;
+            break;
+        default:
+            break;
+    }
+}
+
+std::variant<Handle, FSPXI_File> File::getRawHandle(void)
+{
+    return mHandle;
+}
+
+Result File::resize(u64 size)
+{
+    if (ftruncate(fd(mHandle), size) != 0)
+    {
+        return mResult = -errno;
+    }
+    mSize = size;
+    return mResult = 0;
+}
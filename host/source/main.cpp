@@ -0,0 +1,386 @@
+/*
+ *   This file is part of PKSM
+ *   Copyright (C) 2016-2020 Bernardo Giordano, Admiral Fish, piepie62
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+// Runs a PicoC script against a save and a bank without a console, and reports how long each call
+// into the pksm.h API took. Meant for profiling scripts and the API on a development machine
+
+#include "Archive.hpp"
+#include "Configuration.hpp"
+#include "HostInput.hpp"
+#include "PkmUtils.hpp"
+#include "banks.hpp"
+#include "fetch.hpp"
+#include "format.h"
+#include "i18n_ext.hpp"
+#include "loader.hpp"
+#include "scriptprofiler.hpp"
+#include "thread.hpp"
+#include "utils/crypto.hpp"
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <string.h>
+#include <unistd.h>
+
+#include "picoc.h"
+#undef min // Get rid of picoc's min function
+extern "C" {
+#include "pksm_api.h"
+#include "tokencache.h"
+}
+
+// Same as on the console; see ScriptScreen.hpp
+#define PICOC_STACKSIZE (32 * 1024)
+
+namespace
+{
+    struct Options
+    {
+        std::string script;
+        std::string save;
+        std::string bank;
+        std::string sd = "sdmc";
+        std::string answers;
+        bool write      = false;
+        bool tokenCache = true;
+    };
+
+    std::string loadedSavePath;
+
+    void usage(const char* name)
+    {
+        fmt::print(stderr,
+            "Usage: {} [options] <script.c> <save> <bank.bnk>\n"
+            "\n"
+            "Runs a PicoC script as PKSM's script screen would and prints the time spent in each\n"
+            "pksm.h call to stderr. The save and bank are left alone unless --write is given.\n"
+            "\n"
+            "  --sd <dir>          Directory standing in for the SD card (default: sdmc)\n"
+            "  --answers <file>    Answers to the script's questions, one per line. stdin is\n"
+            "                      read once they run out\n"
+            "  --write             Write the changed save and bank back\n"
+            "  --no-token-cache    Always lex the script instead of using cached tokens\n",
+            name);
+    }
+
+    std::optional<Options> parseArgs(int argc, char** argv)
+    {
+        Options ret;
+        std::vector<std::string> positional;
+        for (int i = 1; i < argc; i++)
+        {
+            std::string arg = argv[i];
+            if (arg == "--sd" && i + 1 < argc)
+            {
+                ret.sd = argv[++i];
+            }
+            else if (arg == "--answers" && i + 1 < argc)
+            {
+                ret.answers = argv[++i];
+            }
+            else if (arg == "--write")
+            {
+                ret.write = true;
+            }
+            else if (arg == "--no-token-cache")
+            {
+                ret.tokenCache = false;
+            }
+            else if (arg.starts_with("-"))
+            {
+                return std::nullopt;
+            }
+            else
+            {
+                positional.emplace_back(std::move(arg));
+            }
+        }
+        if (positional.size() != 3)
+        {
+            return std::nullopt;
+        }
+
+        // The runner moves to its own directory to find its romfs, so everything else is made
+        // absolute first
+        ret.script = std::filesystem::absolute(positional[0]).string();
+        ret.save   = std::filesystem::absolute(positional[1]).string();
+        ret.bank   = std::filesystem::absolute(positional[2]).string();
+        ret.sd     = std::filesystem::absolute(ret.sd).string();
+        if (!ret.answers.empty())
+        {
+            ret.answers = std::filesystem::absolute(ret.answers).string();
+        }
+        return ret;
+    }
+
+    std::optional<std::string> readFile(const std::string& path)
+    {
+        std::ifstream in(path, std::ios::binary);
+        if (!in)
+        {
+            return std::nullopt;
+        }
+        return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    bool writeFile(const std::string& path, const void* data, size_t size)
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        return out && out.write((const char*)data, size);
+    }
+
+    bool loadSave(const std::string& path)
+    {
+        auto data = readFile(path);
+        if (!data || data->empty())
+        {
+            fmt::print(stderr, "Can't read save {}\n", path);
+            return false;
+        }
+        std::shared_ptr<u8[]> saveData(new u8[data->size()]);
+        std::copy(data->begin(), data->end(), saveData.get());
+        TitleLoader::save = pksm::Sav::getSave(saveData, data->size());
+        if (!TitleLoader::save)
+        {
+            fmt::print(stderr, "{} is not a save PKSM can open\n", path);
+            return false;
+        }
+        TitleLoader::save->beginEditing();
+        loadedSavePath = path;
+        return true;
+    }
+
+    // Where Bank keeps a bank of this name
+    std::string bankPath(const std::string& name)
+    {
+        return Configuration::getInstance().useExtData() ? "/banks/" + name + ".bnk"
+                                                         : "/3ds/PKSM/banks/" + name + ".bnk";
+    }
+
+    Archive& bankArchive(void)
+    {
+        return Configuration::getInstance().useExtData() ? Archive::data() : Archive::sd();
+    }
+
+    // Copies the bank into the SD directory, where Banks finds it, and opens it
+    bool loadBank(const std::string& path)
+    {
+        auto data = readFile(path);
+        if (!data)
+        {
+            fmt::print(stderr, "Can't read bank {}\n", path);
+            return false;
+        }
+        std::string name = std::filesystem::path(path).stem().string();
+
+        Archive& archive = bankArchive();
+        if (Configuration::getInstance().useExtData())
+        {
+            archive.createDir("/banks", 0);
+        }
+        else
+        {
+            archive.createDir("/3ds", 0);
+            archive.createDir("/3ds/PKSM", 0);
+            archive.createDir("/3ds/PKSM/banks", 0);
+        }
+        archive.deleteFile(bankPath(name));
+        archive.createFile(bankPath(name), 0, data->size());
+        auto out = archive.file(bankPath(name), FS_OPEN_WRITE);
+        if (!out || out->write(data->data(), data->size()) != data->size())
+        {
+            fmt::print(stderr, "Can't copy bank {} to {}\n", path, bankPath(name));
+            return false;
+        }
+        out->close();
+
+        // The box count follows the magic and version. Version 1 banks don't have one, and get
+        // converted on load
+        std::optional<int> boxes;
+        if (data->size() >= 16)
+        {
+            u32 version, headerBoxes;
+            memcpy(&version, data->data() + 8, sizeof(u32));
+            memcpy(&headerBoxes, data->data() + 12, sizeof(u32));
+            if (version > 1)
+            {
+                boxes = headerBoxes;
+            }
+        }
+        Banks::loadBank(name, boxes);
+        return Banks::bank != nullptr;
+    }
+
+    bool writeBank(const std::string& path)
+    {
+        std::string name = std::filesystem::path(path).stem().string();
+        auto in          = bankArchive().file(bankPath(name), FS_OPEN_READ);
+        if (!in)
+        {
+            return false;
+        }
+        std::string data(in->size(), '\0');
+        in->read(data.data(), data.size());
+        return R_SUCCEEDED(in->result()) && writeFile(path, data.data(), data.size());
+    }
+
+    // Keyed by the script's path, like ScriptScreen's, but kept in the SD directory
+    std::string tokenCachePath(const std::string& sd, const std::string& path)
+    {
+        auto hash = pksm::crypto::sha256((const u8*)path.data(), path.size());
+        u64 id;
+        std::copy(hash.begin(), hash.begin() + sizeof(id), (u8*)&id);
+        return fmt::format(FMT_STRING("{}/3ds/PKSM/cache/scripts/{:016X}.tok"), sd, id);
+    }
+
+    // Mirrors ScriptScreen::parsePicoCScript with profiling on. Returns the script's exit code
+    int runScript(const Options& options)
+    {
+        auto source = readFile(options.script);
+        if (!source)
+        {
+            fmt::print(stderr, "Can't read script {}\n", options.script);
+            return -1;
+        }
+
+        // Everything with a destructor is set up before the exit point, which PicoC longjmps to
+        std::string cachePath = tokenCachePath(options.sd, options.script);
+        std::error_code ec;
+        std::filesystem::create_directories(std::filesystem::path(cachePath).parent_path(), ec);
+        auto hash = pksm::crypto::sha256((const u8*)source->data(), source->size());
+
+        static Picoc picoc;
+        PicocInitialize(&picoc, PICOC_STACKSIZE);
+        ScriptProfiler::start();
+        if (!PicocPlatformSetExitPoint(&picoc))
+        {
+            static constexpr int NUM_ARGS = 1;
+            if (options.tokenCache)
+            {
+                PicocParseCached(&picoc, options.script.c_str(), source->c_str(), source->size(),
+                    hash.data(), cachePath.c_str());
+            }
+            else
+            {
+                PicocPlatformScanFile(&picoc, options.script.c_str());
+            }
+            ScriptProfiler::phase("Load");
+            char* args[NUM_ARGS];
+            char version = (char)TitleLoader::save->version();
+            args[0]      = &version;
+            PicocCallMain(&picoc, NUM_ARGS, args);
+        }
+        fflush(stdout);
+        ScriptProfiler::phase("Run");
+        fmt::print(stderr, "\n{}\n\n{}", options.script, ScriptProfiler::stop());
+
+        int ret = picoc.PicocExitValue;
+        if (ret != 0)
+        {
+            fmt::print(stderr, "Exit code: {}\n", ret);
+        }
+
+        Banks::saveChanged();
+        TitleLoader::save->cryptBoxData(false);
+        PicocCleanup(&picoc);
+        pksm_api_cleanup();
+        return ret;
+    }
+}
+
+std::string TitleLoader::savePath()
+{
+    return loadedSavePath;
+}
+
+int main(int argc, char** argv)
+{
+    auto options = parseArgs(argc, argv);
+    if (!options)
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    // romfs: is a directory next to the runner
+    std::error_code ec;
+    auto self = std::filesystem::read_symlink("/proc/self/exe", ec);
+    if (ec || chdir(self.parent_path().c_str()) != 0)
+    {
+        fmt::print(stderr, "Can't find the runner's romfs\n");
+        return 1;
+    }
+
+    if (!options->answers.empty() && !HostInput::load(options->answers))
+    {
+        fmt::print(stderr, "Can't read answers from {}\n", options->answers);
+        return 1;
+    }
+    if (R_FAILED(Archive::init(options->sd)))
+    {
+        fmt::print(stderr, "Can't use {} as the SD card\n", options->sd);
+        return 1;
+    }
+    Threads::init();
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+    Fetch::initMulti();
+
+    i18n::addCallbacks(i18n::initGui, i18n::exitGui);
+    i18n::init(Configuration::getInstance().language());
+    PkmUtils::initDefaults();
+
+    int ret = 1;
+    if (loadSave(options->save) && loadBank(options->bank))
+    {
+        ret = runScript(*options);
+
+        if (options->write)
+        {
+            TitleLoader::save->finishEditing();
+            if (!writeFile(options->save, TitleLoader::save->rawData().get(),
+                    TitleLoader::save->getLength()))
+            {
+                fmt::print(stderr, "Can't write save {}\n", options->save);
+                ret = 1;
+            }
+            if (!writeBank(options->bank))
+            {
+                fmt::print(stderr, "Can't write bank {}\n", options->bank);
+                ret = 1;
+            }
+        }
+    }
+
+    Banks::bank       = nullptr;
+    TitleLoader::save = nullptr;
+    Fetch::exitMulti();
+    curl_global_cleanup();
+    Threads::exit();
+    i18n::exit();
+    Archive::exit();
+    return ret;
+}
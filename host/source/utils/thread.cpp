@@ -0,0 +1,188 @@
+/*
+ *   This file is part of PKSM
+ *   Copyright (C) 2016-2020 Bernardo Giordano, Admiral Fish, piepie62
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+ *       * Requiring preservation of specified reasonable legal notices or
+ *         author attributions in that material or in the Appropriate Legal
+ *         Notices displayed by works containing it.
+ *       * Prohibiting misrepresentation of the origin of that material,
+ *         or requiring that modified versions of such material be marked in
+ *         reasonable ways as different from the original version.
+ */
+
+#include "thread.hpp"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// The host runner only needs tasks to run off the calling thread as they would on the console, so
+// one worker takes every queued task, highest priority class first
+namespace
+{
+    std::mutex jobsMutex;
+    std::condition_variable jobsQueued;
+    std::deque<std::unique_ptr<Threads::internal::Job>> jobs[Threads::PRIORITIES];
+    std::thread worker;
+    bool stopWorker            = false;
+    thread_local bool onWorker = false;
+
+    // jobsMutex must be held
+    std::unique_ptr<Threads::internal::Job> takeJob()
+    {
+        for (auto& queue : jobs)
+        {
+            if (!queue.empty())
+            {
+                auto ret = std::move(queue.front());
+                queue.pop_front();
+                return ret;
+            }
+        }
+        return nullptr;
+    }
+
+    void workerMain()
+    {
+        onWorker = true;
+        std::unique_lock<std::mutex> lock(jobsMutex);
+        while (!stopWorker)
+        {
+            if (auto job = takeJob())
+            {
+                lock.unlock();
+                job->run();
+                lock.lock();
+            }
+            else
+            {
+                jobsQueued.wait(lock);
+            }
+        }
+    }
+
+    struct EventState
+    {
+        std::mutex mutex;
+        std::condition_variable changed;
+        bool signaled = false;
+        bool autoReset;
+    };
+}
+
+bool Threads::init(void)
+{
+    stopWorker = false;
+    worker     = std::thread(workerMain);
+    return true;
+}
+
+bool Threads::create(void (*entrypoint)(void*), void* arg, std::optional<size_t>)
+{
+    std::thread(entrypoint, arg).detach();
+    return true;
+}
+
+void Threads::internal::schedule(std::unique_ptr<Job> job, Priority priority)
+{
+    std::unique_lock<std::mutex> lock(jobsMutex);
+    // Once exit() has emptied the queue, nothing would take this
+    if (stopWorker || !worker.joinable())
+    {
+        lock.unlock();
+        job->cancel();
+        return;
+    }
+    jobs[size_t(priority)].emplace_back(std::move(job));
+    jobsQueued.notify_one();
+}
+
+bool Threads::internal::runQueuedJob(void)
+{
+    if (!onWorker)
+    {
+        return false;
+    }
+    std::unique_lock<std::mutex> lock(jobsMutex);
+    if (auto job = takeJob())
+    {
+        lock.unlock();
+        job->run();
+        return true;
+    }
+    return false;
+}
+
+void Threads::exit(void)
+{
+    std::vector<std::unique_ptr<Threads::internal::Job>> cancelled;
+    {
+        std::lock_guard<std::mutex> lock(jobsMutex);
+        stopWorker = true;
+        while (auto job = takeJob())
+        {
+            cancelled.emplace_back(std::move(job));
+        }
+        jobsQueued.notify_all();
+    }
+    // Tasks that never ran are cancelled before joining, as the worker may be waiting on one
+    for (auto& job : cancelled)
+    {
+        job->cancel();
+    }
+    if (worker.joinable())
+    {
+        worker.join();
+    }
+}
+
+Threads::Event::Event(bool autoReset) : event(new EventState)
+{
+    ((EventState*)event)->autoReset = autoReset;
+}
+
+Threads::Event::~Event()
+{
+    delete (EventState*)event;
+}
+
+void Threads::Event::signal()
+{
+    EventState* state = (EventState*)event;
+    std::lock_guard<std::mutex> lock(state->mutex);
+    state->signaled = true;
+    if (state->autoReset)
+    {
+        state->changed.notify_one();
+    }
+    else
+    {
+        state->changed.notify_all();
+    }
+}
+
+void Threads::Event::wait()
+{
+    EventState* state = (EventState*)event;
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->changed.wait(lock, [state] { return state->signaled; });
+    if (state->autoReset)
+    {
+        state->signaled = false;
+    }
+}
@@ -0,0 +1,326 @@
+#!/usr/bin/env python3
+#
+#   This file is part of PKSM
+#   Copyright (C) 2016-2020 Bernardo Giordano, Admiral Fish, piepie62
+#
+#   This program is free software: you can redistribute it and/or modify
+#   it under the terms of the GNU General Public License as published by
+#   the Free Software Foundation, either version 3 of the License, or
+#   (at your option) any later version.
+#
+#   This program is distributed in the hope that it will be useful,
+#   but WITHOUT ANY WARRANTY; without even the implied warranty of
+#   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#   GNU General Public License for more details.
+#
+#   You should have received a copy of the GNU General Public License
+#   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+#   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+#       * Requiring preservation of specified reasonable legal notices or
+#         author attributions in that material or in the Appropriate Legal
+#         Notices displayed by works containing it.
+#       * Prohibiting misrepresentation of the origin of that material,
+#         or requiring that modified versions of such material be marked in
+#         reasonable ways as different from the original version.
+
+"""Reference PC side of the PKSM bridge, as implemented in 3ds/source/utils/pksmbridge.cpp.
+
+    pksmbridge.py send <3ds ip> <save>   push a save to PKSM's "receive from bridge"
+    pksmbridge.py recv <save>            wait for PKSM to send the edited save back
+    pksmbridge.py selftest               run both directions against a model of the 3DS side
+
+--v1 makes the PC behave like a version 1 peer, which only ever sends and expects the raw save.
+When receiving, the save file already on disk is used as the base that unchanged blocks are
+copied from, so receive into the same file that was sent.
+"""
+
+import argparse
+import hashlib
+import socket
+import struct
+import sys
+import threading
+import zlib
+
+PKSM_PORT = 34567
+PROTOCOL_MAGIC = b"PKSMBRDG"
+PROTOCOL_VERSION = 2
+BLOCK_SIZE = 0x4000
+RAW_BLOCK = 0x80000000
+END_OF_BLOCKS = 0xFFFFFFFF
+MAX_SAVE_SIZE = 0x180B19
+
+HEADER = struct.Struct("<8sIII")
+BLOCK_HEADER = struct.Struct("<II")
+U32 = struct.Struct("<I")
+HASH_SIZE = 32
+
+
+def recv_all(sock, size):
+    data = bytearray()
+    while len(data) < size:
+        chunk = sock.recv(size - len(data))
+        if not chunk:
+            raise ConnectionError("connection closed after {} of {} bytes".format(len(data), size))
+        data += chunk
+    return bytes(data)
+
+
+def recv_until_closed(sock, data=b""):
+    data = bytearray(data)
+    while len(data) < MAX_SAVE_SIZE:
+        chunk = sock.recv(MAX_SAVE_SIZE - len(data))
+        if not chunk:
+            break
+        data += chunk
+    return bytes(data)
+
+
+def blocks(data):
+    return [data[i : i + BLOCK_SIZE] for i in range(0, len(data), BLOCK_SIZE)]
+
+
+def block_hashes(data):
+    return [hashlib.sha256(block).digest() for block in blocks(data)]
+
+
+def make_header(size, version=PROTOCOL_VERSION):
+    return HEADER.pack(PROTOCOL_MAGIC, version, size, BLOCK_SIZE)
+
+
+def parse_header(raw):
+    magic, version, size, block_size = HEADER.unpack(raw)
+    if magic != PROTOCOL_MAGIC:
+        return None
+    return version, size, block_size
+
+
+def send_hashes(sock, hashes):
+    sock.sendall(U32.pack(len(hashes)) + b"".join(hashes))
+
+
+def recv_hashes(sock, size):
+    (count,) = U32.unpack(recv_all(sock, U32.size))
+    if count not in (0, len(blocks(bytes(size)))):
+        raise ValueError("peer sent {} hashes for a {} byte save".format(count, size))
+    return [recv_all(sock, HASH_SIZE) for _ in range(count)]
+
+
+def send_blocks(sock, data, peer_hashes):
+    """Sends the blocks of data whose hashes differ from peer_hashes. Returns how many were sent."""
+    sent = 0
+    for index, block in enumerate(blocks(data)):
+        if peer_hashes and hashlib.sha256(block).digest() == peer_hashes[index]:
+            continue
+        compressed = zlib.compress(block, 1)
+        if len(compressed) < len(block):
+            payload, size = compressed, len(compressed)
+        else:
+            payload, size = block, len(block) | RAW_BLOCK
+        sock.sendall(BLOCK_HEADER.pack(index, size) + payload)
+        sent += 1
+    sock.sendall(U32.pack(END_OF_BLOCKS) + hashlib.sha256(data).digest())
+    return sent
+
+
+def recv_blocks(sock, size, base):
+    """Receives blocks, filling the rest from base. Returns the save and how many blocks came."""
+    lengths = [len(block) for block in blocks(bytes(size))]
+    data = [None] * len(lengths)
+    received = 0
+    while True:
+        (index,) = U32.unpack(recv_all(sock, U32.size))
+        if index == END_OF_BLOCKS:
+            break
+        if index >= len(lengths):
+            raise ValueError("block index {} out of range".format(index))
+        (block_size,) = U32.unpack(recv_all(sock, U32.size))
+        payload = recv_all(sock, block_size & ~RAW_BLOCK)
+        data[index] = payload if block_size & RAW_BLOCK else zlib.decompress(payload)
+        if len(data[index]) != lengths[index]:
+            raise ValueError("block {} has the wrong length".format(index))
+        received += 1
+
+    for index, block in enumerate(data):
+        if block is None:
+            if base is None:
+                raise ValueError("block {} was skipped but there is no base".format(index))
+            data[index] = base[index * BLOCK_SIZE : index * BLOCK_SIZE + lengths[index]]
+    data = b"".join(data)
+    if hashlib.sha256(data).digest() != recv_all(sock, HASH_SIZE):
+        raise ValueError("save hash mismatch")
+    return data, received
+
+
+def push(sock, data, v1=False):
+    """Sends data to a peer that is receiving. Returns how many blocks went over the wire."""
+    if v1:
+        sock.sendall(data)
+        return len(blocks(data))
+    sock.sendall(make_header(len(data)))
+    reply = parse_header(recv_all(sock, HEADER.size))
+    if reply is None or reply[2] != BLOCK_SIZE:
+        raise ValueError("peer did not answer with a version 2 header")
+    return send_blocks(sock, data, recv_hashes(sock, len(data)))
+
+
+def pull(sock, base, v1=False):
+    """Receives a save from a peer that is sending. Returns the save, how many blocks came over the
+    wire, and the version the peer spoke."""
+    if v1:
+        data = recv_until_closed(sock)
+        return data, len(blocks(data)), 1
+    first = recv_all(sock, HEADER.size)
+    header = parse_header(first)
+    if header is None:
+        data = recv_until_closed(sock, first)
+        return data, len(blocks(data)), 1
+    version, size, _ = header
+    if size == 0 or size > MAX_SAVE_SIZE:
+        raise ValueError("bad save size {}".format(size))
+    version = min(version, PROTOCOL_VERSION)
+    if base is not None and len(base) != size:
+        base = None
+    sock.sendall(make_header(size, version))
+    send_hashes(sock, block_hashes(base) if base is not None else [])
+    data, received = recv_blocks(sock, size, base)
+    return data, received, version
+
+
+def listen(port):
+    server = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+    server.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    server.bind(("", port))
+    server.listen(1)
+    return server
+
+
+def cmd_send(args):
+    with open(args.save, "rb") as f:
+        data = f.read()
+    with socket.create_connection((args.host, args.port)) as sock:
+        sent = push(sock, data, args.v1)
+    print("Sent {} of {} blocks".format(sent, len(blocks(data))))
+
+
+def cmd_recv(args):
+    try:
+        with open(args.save, "rb") as f:
+            base = f.read()
+    except FileNotFoundError:
+        base = None
+    with listen(args.port) as server:
+        sock, addr = server.accept()
+        with sock:
+            data, received, version = pull(sock, base, args.v1)
+    with open(args.save, "wb") as f:
+        f.write(data)
+    print("Received {} of {} blocks from {} (version {})".format(
+        received, len(blocks(data)), addr[0], version))
+
+
+class Device:
+    """Model of the 3DS side of pksmbridge.cpp, which keeps the last exchanged save as its base and
+    answers in whichever version the PC last spoke."""
+
+    def __init__(self):
+        self.base = None
+        self.peer_version = 1
+
+    def receive(self, server):
+        sock, _ = server.accept()
+        with sock:
+            first = recv_all(sock, HEADER.size)
+            header = parse_header(first)
+            if header is None:
+                self.peer_version = 1
+                data = recv_until_closed(sock, first)
+            else:
+                self.peer_version = min(header[0], PROTOCOL_VERSION)
+                size = header[1]
+                base = self.base if self.base is not None and len(self.base) == size else None
+                sock.sendall(make_header(size, self.peer_version))
+                send_hashes(sock, block_hashes(base) if base is not None else [])
+                data, _ = recv_blocks(sock, size, base)
+        self.base = data
+        return data
+
+    def send(self, port, data):
+        with socket.create_connection(("127.0.0.1", port)) as sock:
+            push(sock, data, self.peer_version < 2)
+        self.base = data
+
+
+def selftest(_args):
+    def run(target):
+        thread = threading.Thread(target=target)
+        thread.start()
+        return thread
+
+    device = Device()
+    save = bytearray(zlib.crc32(bytes([i % 251])) & 0xFF for i in range(0x80B19))
+    results = {}
+
+    def pc_push(v1):
+        with listen(0) as server:
+            port = server.getsockname()[1]
+            thread = run(lambda: results.update(got=device.receive(server)))
+            with socket.create_connection(("127.0.0.1", port)) as sock:
+                sent = push(sock, bytes(save), v1)
+            thread.join()
+        assert results["got"] == save, "device received a different save"
+        return sent
+
+    def pc_pull(base, v1):
+        with listen(0) as server:
+            port = server.getsockname()[1]
+            thread = run(lambda: device.send(port, bytes(save)))
+            sock, _ = server.accept()
+            with sock:
+                data, received, version = pull(sock, base, v1)
+            thread.join()
+        assert data == save, "PC received a different save"
+        return received, version
+
+    total = len(blocks(save))
+
+    # PC -> 3DS with nothing in common sends everything
+    assert pc_push(False) == total
+    # 3DS -> PC after editing one byte sends only that block
+    base = bytes(save)
+    save[0x4001] ^= 0x55
+    received, version = pc_pull(base, False)
+    assert (received, version) == (1, 2), (received, version)
+    # PC -> 3DS after editing another byte sends only that block
+    save[0x70000] ^= 0xAA
+    assert pc_push(False) == 1
+    # Version 1 PC -> 3DS sends the raw save, and the 3DS answers with the raw save
+    assert pc_push(True) == total
+    save[0] ^= 1
+    received, version = pc_pull(None, False)
+    assert (received, version) == (total, 1), (received, version)
+    assert device.peer_version == 1
+    print("OK")
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description=__doc__, formatter_class=argparse.RawTextHelpFormatter)
+    parser.add_argument("--port", type=int, default=PKSM_PORT)
+    parser.add_argument("--v1", action="store_true", help="behave like a version 1 peer")
+    sub = parser.add_subparsers(dest="command", required=True)
+    send = sub.add_parser("send")
+    send.add_argument("host")
+    send.add_argument("save")
+    send.set_defaults(func=cmd_send)
+    recv = sub.add_parser("recv")
+    recv.add_argument("save")
+    recv.set_defaults(func=cmd_recv)
+    sub.add_parser("selftest").set_defaults(func=selftest)
+    args = parser.parse_args()
+    args.func(args)
+
+
+if __name__ == "__main__":
+    sys.exit(main())